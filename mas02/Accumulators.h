@@ -0,0 +1,177 @@
+#ifndef _ACCUMULATORS_H_
+#define _ACCUMULATORS_H_
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "ENVIImage.h"
+#include "Stats.h"
+
+/// <summary>A single histogram bin</summary>
+typedef float histogram_bin;
+
+/// <summary>
+/// Gathers the statistics of all bands of an image block by block, e.g. strip by strip while streaming a file.
+/// Every line yields a mean and a sum of squared deviations (from shifted sums in the vector kernels, or a Welford update)
+/// and partial results are merged pairwise (Chan et al.), all in double precision, so a single pass is about as accurate
+/// as computing mean and deviations in two passes.
+/// </summary>
+class BandStatsAccumulator
+{
+private:
+    /// <summary>
+    /// The number of bands
+    /// </summary>
+    const envi::bandcount_t _bands;
+
+    /// <summary>
+    /// The number of samples per band seen so far
+    /// </summary>
+    uint64_t _count;
+
+    /// <summary>
+    /// The means of all samples, per band
+    /// </summary>
+    std::vector<double> _mean;
+
+    /// <summary>
+    /// The sums of squared deviations from the mean, per band
+    /// </summary>
+    std::vector<double> _m2;
+
+    /// <summary>
+    /// The minimum values, per band
+    /// </summary>
+    std::vector<stats_t> _min;
+
+    /// <summary>
+    /// The maximum values, per band
+    /// </summary>
+    std::vector<stats_t> _max;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="BandStatsAccumulator"/> class.
+    /// </summary>
+    /// <param name="bands">The number of bands.</param>
+    explicit BandStatsAccumulator(const envi::bandcount_t& bands);
+
+    /// <summary>
+    /// Adds the samples of an image block; All lines of the block are processed in parallel and merged pairwise.
+    /// </summary>
+    /// <param name="block">The image block; Must have the accumulator's number of bands.</param>
+    void add(const envi::ImageView& block);
+
+    /// <summary>
+    /// Adds the totals of another accumulator, as if its samples had been added to this one
+    /// </summary>
+    /// <param name="other">The other accumulator; Must have the same number of bands.</param>
+    void merge(const BandStatsAccumulator& other);
+
+    /// <summary>
+    /// Gets the number of bands
+    /// </summary>
+    /// <returns>The number of bands.</returns>
+    inline envi::bandcount_t bands() const
+    {
+        return _bands;
+    }
+
+    /// <summary>
+    /// Gets the number of samples per band added so far
+    /// </summary>
+    /// <returns>The number of samples.</returns>
+    inline uint64_t count() const
+    {
+        return _count;
+    }
+
+    /// <summary>
+    /// Gets the statistics of all samples added so far
+    /// </summary>
+    /// <returns>The statistics, one per band; All values are NaN if no sample was added, the standard deviation of a single sample is 0.</returns>
+    bandstats_t result() const;
+
+    /// <summary>
+    /// Writes the running totals as a single line of text
+    /// </summary>
+    /// <param name="stream">The stream.</param>
+    void write(std::ostream& stream) const;
+
+    /// <summary>
+    /// Replaces the running totals by totals written by <see cref="write"/>
+    /// </summary>
+    /// <param name="stream">The stream.</param>
+    void read(std::istream& stream) throw(std::runtime_error);
+private:
+    /// <summary>
+    /// Combines the totals of a band with partial statistics (Chan et al.); The number of samples is not updated.
+    /// </summary>
+    /// <param name="band">The band.</param>
+    /// <param name="count">The number of samples of the partial statistics.</param>
+    /// <param name="mean">The mean of the partial statistics.</param>
+    /// <param name="m2">The sum of squared deviations from the mean of the partial statistics.</param>
+    /// <param name="min">The minimum of the partial statistics.</param>
+    /// <param name="max">The maximum of the partial statistics.</param>
+    void merge(const envi::bandcount_t& band, const double& count, const double& mean, const double& m2, const stats_t& min, const stats_t& max);
+};
+
+/// <summary>
+/// Builds the histogram of all bands of an image block by block, e.g. strip by strip while streaming a file.
+/// </summary>
+class HistogramAccumulator
+{
+private:
+    /// <summary>
+    /// The number of bands
+    /// </summary>
+    const envi::bandcount_t _bands;
+
+    /// <summary>
+    /// The lower boundary of the first class
+    /// </summary>
+    const stats_t _low_value;
+
+    /// <summary>
+    /// The upper boundary of the last class
+    /// </summary>
+    const stats_t _high_value;
+
+    /// <summary>
+    /// The number of classes per band
+    /// </summary>
+    const uint_fast8_t _class_count;
+
+    /// <summary>
+    /// The number of samples per class, band by band
+    /// </summary>
+    std::vector<double> _counts;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="HistogramAccumulator"/> class.
+    /// </summary>
+    /// <param name="bands">The number of bands.</param>
+    /// <param name="low_value">The lower boundary of the first class.</param>
+    /// <param name="high_value">The upper boundary of the last class.</param>
+    /// <param name="class_count">The number of classes.</param>
+    HistogramAccumulator(const envi::bandcount_t& bands, const stats_t low_value, const stats_t high_value, const uint_fast8_t class_count = 10);
+
+    /// <summary>
+    /// Adds the samples of an image block; All lines of the block are processed in parallel.
+    /// </summary>
+    /// <param name="block">The image block; Must have the accumulator's number of bands.</param>
+    void add(const envi::ImageView& block);
+
+    /// <summary>
+    /// Gets the histogram of all samples added so far, normalized per band
+    /// </summary>
+    /// <returns>The classes, band by band (<see cref="_class_count"/> classes per band).</returns>
+    std::unique_ptr<histogram_bin[]> result() const;
+};
+
+#endif
\ No newline at end of file
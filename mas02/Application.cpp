@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <cfloat>
 #include <cmath>
 #include <memory>
 
@@ -11,6 +12,13 @@
 #include <opencv/highgui.h>
 
 #include "ENVIFileReader.h"
+#include "ENVIFileWriter.h"
+#include "ImagePyramid.h"
+#include "IntegralImage.h"
+#include "SimdReduction.h"
+#include "StatsCache.h"
+#include "StatsGrid.h"
+#include "TiledArchive.h"
 #include "Application.h"
 
 using namespace std;
@@ -47,99 +55,236 @@ void Application::createWindow(const string& name)
     cvNamedWindow(name.c_str(), CV_WINDOW_AUTOSIZE);
 }
 
+/// <summary>
+/// Finds the blocks with the lowest and the highest mean of the first band
+/// </summary>
+/// <param name="grid">The block statistics.</param>
+/// <param name="low_x">The column of the block with the lowest mean.</param>
+/// <param name="low_y">The row of the block with the lowest mean.</param>
+/// <param name="high_x">The column of the block with the highest mean.</param>
+/// <param name="high_y">The row of the block with the highest mean.</param>
+static void findExtremeBlocks(const StatsGrid& grid, out samplecount_t& low_x, out linecount_t& low_y, out samplecount_t& high_x, out linecount_t& high_y)
+{
+    sample_t low = FLT_MAX, high = -FLT_MAX;
+    for (linecount_t y=0; y<grid.lines; ++y)
+    {
+        const sample_t* means = grid.mean->line(y, 0);
+        for (samplecount_t x=0; x<grid.samples; ++x)
+        {
+            if (means[x] < low)  { low = means[x];  low_x = x;  low_y = y; }
+            if (means[x] > high) { high = means[x]; high_x = x; high_y = y; }
+        }
+    }
+}
+
+/// <summary>
+/// Places a range of the given length around a center, within the given extent
+/// </summary>
+/// <param name="center">The center.</param>
+/// <param name="length">The length of the range; Must not exceed the extent.</param>
+/// <param name="extent">The extent.</param>
+/// <returns>The first position of the range.</returns>
+static inline uint_fast64_t centeredOrigin(const uint_fast64_t& center, const uint_fast64_t& length, const uint_fast64_t& extent)
+{
+    const uint_fast64_t origin = (center > length / 2) ? center - length / 2 : 0;
+    return min(origin, extent - length);
+}
+
 /// <summary>
 /// Runs this instance.
 /// </summary>
-void Application::run()
+/// <param name="header_path">The path of the ENVI header file of the image.</param>
+/// <param name="archive_path">The path of a tiled archive to write the scene to and read the regions back from; Empty to skip it.</param>
+void Application::run(const string& header_path, const string& archive_path)
 {
-    // open the input file
-    string filename = "./images/rued_corr_flt.img";
-    ifstream inputFile;
-    inputFile.open(filename, ios_base::in | ios_base::beg | ios_base::binary);
-    if (!inputFile.is_open()) throw runtime_error("Could not open input file");
-
-    // load the image data
-    const samplecount_t samples = 5000;
-    const linecount_t lines = 2000;
-    const bandcount_t bands = 1;
-    ENVIFileReader reader(samples, lines, bands);
-
-    cout << "Loading image ... ";
-    image_t image = reader.read(inputFile);
+    // the header describes the layout of the input file
+    const ENVIHeader header = ENVIHeader::load(header_path);
+    const string filename = ENVIHeader::dataFilePath(header_path);
+    ENVIFileReader reader(header);
+
+    // map the image data; float samples are used in place, all others are converted
+    cout << "Loading image " << filename << " (" << header.samples << "x" << header.lines << "x" << static_cast<int>(header.bands) << ") ... ";
+    image_t image = reader.map(filename);
     cout << "done." << endl;
 
-    // close the input file
-    inputFile.close();
+    // the whole scene
+    const ImageView scene = image->view();
+    cout << "Using " << simdLevelName(simdLevel()) << " kernels for statistics." << endl;
 
-    // calculate naive statistics
-    cout << endl << "Calculating statistics (naive) ... ";
-    auto stats = calculateStatisticsNaive(image, samples, lines, bands);
-    cout << "done" << endl;
-    cout << stats << endl;
+    // results of earlier runs on the same file are taken from the sidecar cache
+    StatsCache cache(filename);
 
-    // calculate naive d/c statistics
-    cout << endl << "Calculating statistics (naive divide-and-conquer) ... ";
-    stats = calculateStatisticsNaiveDivideConquer(image, samples, lines, bands);
-    cout << "done" << endl;
-    cout << stats << endl;
+    // statistics of all bands in a single pass
+    cout << endl << "Calculating statistics ... ";
+    bool cached = false;
+    const bandstats_t scene_stats = cachedStatistics(cache, "statistics", scene, out cached);
+    cout << (cached ? "cached" : "done") << endl;
+    for (bandcount_t b=0; b<scene.bands; ++b)
+    {
+        cout << scene_stats[b] << endl;
+    }
 
-    // calculate forward statistics
-    cout << endl << "Calculating statistics (forward d&q) ... ";
-    stats = calculateStatisticsForward(image, samples, lines, bands);
-    cout << "done" << endl;
-    cout << stats << endl;
+    // the first band sets the display range
+    const shared_ptr<Stats> stats = scene_stats[0];
+
+    // stream the file strip by strip within a fixed memory budget
+    cout << endl << "Calculating statistics and histogram (streaming) ... ";
+    bandstats_t streamed_stats;
+    unique_ptr<histogram_bin[]> streamed_histogram;
+    cached = cache.findStats("streaming", out streamed_stats) && cache.findHistogram("streaming:0:4096:10", out streamed_histogram);
+    if (!cached)
+    {
+        ENVIStripReader strips(header, filename, ENVIStripReader::linesForBudget(header, 64U << 20));
+        streamed_stats = calculateStreamingStatistics(strips, 0.0F, 4096.0F, out streamed_histogram);
+        cache.storeStats("streaming", streamed_stats);
+        cache.storeHistogram("streaming:0:4096:10", streamed_histogram.get(), static_cast<size_t>(header.bands) * 10);
+    }
+    cout << (cached ? "cached" : "done") << endl;
+    cout << streamed_stats[0] << endl;
+
+    // a coarse raster of block statistics locates the darkest and the brightest part of the scene
+    cout << endl << "Calculating block statistics ... ";
+    const statsgrid_t grid = calculateBlockStatistics(scene, 64);
+    cout << "done (" << grid->samples << "x" << grid->lines << " blocks)" << endl;
+
+    samplecount_t low_block_x = 0, high_block_x = 0;
+    linecount_t   low_block_y = 0, high_block_y = 0;
+    findExtremeBlocks(*grid, out low_block_x, out low_block_y, out high_block_x, out high_block_y);
+
+    // low- and high density regions around these blocks; clamped to the scene for smaller images
+    samplecount_t region_width = min<samplecount_t>(500, scene.samples);
+    linecount_t   region_height = min<linecount_t>(500, scene.lines);
 
-    // low- and high density regions
-    samplecount_t region_width = 500;
-    linecount_t   region_height = 500;
+    samplecount_t low_x = centeredOrigin(low_block_x * grid->block_size + grid->block_size / 2, region_width, scene.samples);
+    linecount_t   low_y = centeredOrigin(low_block_y * grid->block_size + grid->block_size / 2, region_height, scene.lines);
 
-    samplecount_t low_x = 200;
-    linecount_t   low_y = 200;
+    samplecount_t hi_x  = centeredOrigin(high_block_x * grid->block_size + grid->block_size / 2, region_width, scene.samples);
+    linecount_t   hi_y  = centeredOrigin(high_block_y * grid->block_size + grid->block_size / 2, region_height, scene.lines);
+    cout << "low-density region at " << low_x << "," << low_y << ", high-density region at " << hi_x << "," << hi_y << endl;
 
-    samplecount_t hi_x  = 2000;
-    linecount_t   hi_y  = 800;
+    const ImageView low_region  = scene.view(low_x, low_y, region_width, region_height);
+    const ImageView high_region = scene.view(hi_x, hi_y, region_width, region_height);
+
+    // per-tile statistics let region queries skip all whole tiles
+    if (!cache.hasTiles())
+    {
+        cout << endl << "Calculating tile statistics ... ";
+        cache.buildTiles(scene);
+        cout << "done" << endl;
+    }
 
     // calculate low-density statistics
     cout << endl << "Calculating statistics for low-density region ... ";
-    auto low_stats = calculateStatistics(image, low_x, low_x+region_width, low_y, low_x+region_height, bands);
+    auto low_stats = cache.regionStats(scene, low_x, low_y, region_width, region_height)[0];
     cout << "done" << endl;
     cout << low_stats << endl;
 
     // calculate high-density statistics
     cout << endl << "Calculating statistics for high-density region ... ";
-    auto high_stats = calculateStatistics(image, hi_x, hi_x+region_height, hi_y, hi_y+region_height, bands);
+    auto high_stats = cache.regionStats(scene, hi_x, hi_y, region_width, region_height)[0];
     cout << "done" << endl;
     cout << high_stats << endl;
 
+    // any number of rectangles and polygons are summarized in a single pass over the scene
+    cout << endl << "Calculating statistics for a batch of regions ... ";
+    vector<RegionOfInterest> regions;
+    regions.push_back(RegionOfInterest::rectangle(low_x, low_y, region_width, region_height));
+    regions.push_back(RegionOfInterest::rectangle(hi_x, hi_y, region_width, region_height));
+
+    // a diamond around the center of the scene
+    const double center_x = scene.samples / 2.0, center_y = scene.lines / 2.0;
+    const double radius = min(center_x, center_y) / 2.0;
+    vector<Vertex> diamond(4);
+    diamond[0].x = center_x;          diamond[0].y = center_y - radius;
+    diamond[1].x = center_x + radius; diamond[1].y = center_y;
+    diamond[2].x = center_x;          diamond[2].y = center_y + radius;
+    diamond[3].x = center_x - radius; diamond[3].y = center_y;
+    regions.push_back(RegionOfInterest::polygon(diamond));
+
+    const vector<bandstats_t> region_stats = calculateRegionStatistics(scene, regions);
+    cout << "done" << endl;
+    for (size_t r=0; r<region_stats.size(); ++r)
+    {
+        cout << region_stats[r][0] << endl;
+    }
+
+    // on request, archive the scene in compressed tiles and read the regions back from it
+    if (!archive_path.empty())
+    {
+        cout << endl << "Writing tiled archive ... ";
+        TiledArchiveWriter().write(scene, archive_path);
+        TiledArchiveReader archive(archive_path);
+        cout << "done (" << archive.size() << " of " << static_cast<size_t>(scene.samples) * scene.lines * scene.bands * sizeof(sample_t) << " bytes)" << endl;
+
+        cout << endl << "Calculating statistics for regions read from the tiled archive ... ";
+        image_t archived_low  = archive.read(low_x, low_y, region_width, region_height);
+        image_t archived_high = archive.read(hi_x, hi_y, region_width, region_height);
+        auto archived_low_stats  = calculateStatistics(archived_low->view().band(0));
+        auto archived_high_stats = calculateStatistics(archived_high->view().band(0));
+        cout << "done" << endl;
+        cout << archived_low_stats << endl;
+        cout << archived_high_stats << endl;
+    }
+
     // convert image to OpenCV image.
     cout << endl << "Converting low and high density regions for display ... ";
-    IplImagePtr lowDensityRegion = enviToOpenCv(image, low_x, low_x+region_width, low_y, low_x+region_height, bands, low_stats->min, low_stats->max);
-    IplImagePtr highDensityRegion = enviToOpenCv(image, hi_x, hi_x+region_height, hi_y, hi_y+region_height, bands, high_stats->min, high_stats->max);
-    IplImagePtr displayImage = enviToOpenCv(image, samples, lines, bands, stats->min, stats->max);
+    IplImagePtr lowDensityRegion = enviToOpenCv(low_region, low_stats->min, low_stats->max);
+    IplImagePtr highDensityRegion = enviToOpenCv(high_region, high_stats->min, high_stats->max);
+    IplImagePtr displayImage = enviToOpenCv(scene, stats->min, stats->max);
+    cout << "done" << endl;
+
+    // summed-area tables of the high-density region smooth it with a box filter at a cost independent of the window size
+    cout << endl << "Smoothing high density region ... ";
+    const image_t smoothed = IntegralImage(high_region).boxMean(3);
+    IplImagePtr smoothedHighDensityRegion = enviToOpenCv(smoothed->view(), high_stats->min, high_stats->max);
     cout << "done" << endl;
     
+    // the overview pyramid is kept next to the image file and only built if it is missing
+    cout << endl << "Loading overview pyramid ... ";
+    const ImagePyramid pyramid(scene, header_path);
+    cout << "done (" << pyramid.levels() << " levels)" << endl;
+
+    // a quick preview of the histogram from a coarse level
+    cout << endl << "Building histogram preview ... ";
+    auto histogram_preview = buildHistogram(pyramid.closest(8.0F), 0.0F, 4096.0F, 10);
+    cout << "done" << endl;
+
     // calculate the histogram
     cout << endl << "Building histogram ... ";
-    auto histogram = buildHistogram(image, samples, lines, bands, 0.0F, 4096.0F, 10);
-    cout << "done" << endl;
+    unique_ptr<histogram_bin[]> histogram;
+    cached = cache.findHistogram("histogram:0:4096:10", out histogram);
+    if (!cached)
+    {
+        histogram = buildHistogram(scene, 0.0F, 4096.0F, 10);
+        cache.storeHistogram("histogram:0:4096:10", histogram.get(), static_cast<size_t>(scene.bands) * 10);
+    }
+    cout << (cached ? "cached" : "done") << endl;
+    cache.save();
 
     cout << endl << "Histogram:" << endl;
     for (uint8_t i=0; i<10; ++i)
     {
         float value = histogram[i] * 100.0F;
-        cout << "class " << to_string(i) << "\tvalue: " << to_string(value) << "%" << endl;
+        float preview = histogram_preview[i] * 100.0F;
+        cout << "class " << to_string(i) << "\tvalue: " << to_string(value) << "%\tpreview: " << to_string(preview) << "%" << endl;
     }
     
-    // scaling
+    // scaling; starts from the closest overview level instead of the full-resolution image
     const float scaleFactor = 5;
     cout << endl << "Scaling image ... ";
-    auto scaled = scaleDownLinear(image, samples, lines, bands, scaleFactor);
+    const size_t scale_level = pyramid.levelFor(scaleFactor);
+    auto scaled = scaleDownLinear(pyramid.level(scale_level), scaleFactor / ImagePyramid::scaleFactor(scale_level));
+    cout << "done" << endl;
+
+    // keep the full precision of the scaled image for other tools
+    cout << "Writing scaled image ... ";
+    ENVIFileWriter(true).write(scaled->view(), "./mas02_scaled");
     cout << "done" << endl;
 
     cout << "Converting scaled image ... ";
-    auto cvscaled       = enviToOpenCv(scaled, static_cast<samplecount_t>(samples/scaleFactor), static_cast<linecount_t>(lines/scaleFactor), bands, stats->min, stats->max);
-    auto cvscaledLow    = enviToOpenCv(scaled, static_cast<samplecount_t>(samples/scaleFactor), static_cast<linecount_t>(lines/scaleFactor), bands, stats->min, stats->max/4);
-    auto cvscaledHigh   = enviToOpenCv(scaled, static_cast<samplecount_t>(samples/scaleFactor), static_cast<linecount_t>(lines/scaleFactor), bands, stats->max*1/4, stats->max);
+    auto cvscaled       = enviToOpenCv(scaled->view());
+    auto cvscaledLow    = enviToOpenCv(scaled->view(), stats->min, stats->max/4);
+    auto cvscaledHigh   = enviToOpenCv(scaled->view(), stats->max*1/4, stats->max);
     cout << "done" << endl;
     
 
@@ -167,5 +312,9 @@ void Application::run()
     cvShowImage("High Density", highDensityRegion.get());
     cvSaveImage("./mas02_highdensity.jpg", highDensityRegion.get());
 
+    createWindow("High Density Smoothed");
+    cvShowImage("High Density Smoothed", smoothedHighDensityRegion.get());
+    cvSaveImage("./mas02_highdensity_smoothed.jpg", smoothedHighDensityRegion.get());
+
     cvWaitKey(0);
 }
\ No newline at end of file
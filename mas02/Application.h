@@ -7,16 +7,20 @@
 #include <string>
 #include <vector>
 
+#include "Accumulators.h"
 #include "ENVIFileReader.h"
+#include "ENVIHeader.h"
+#include "ENVIImage.h"
+#include "ENVIStripReader.h"
 #include "OpenCvImage.h"
+#include "RegionOfInterest.h"
 #include "Stats.h"
+#include "StatsCache.h"
+#include "StatsGrid.h"
 
 /// <summary>Marks a variable as output</summary>
 #define out
 
-/// <summary>A single histogram bin</summary>
-typedef float histogram_bin;
-
 /// <summary>
 /// Main application class
 /// </summary>
@@ -42,7 +46,9 @@ public:
     /// <summary>
     /// Runs this instance.
     /// </summary>
-    void run() throw(std::runtime_error);
+    /// <param name="header_path">The path of the ENVI header file of the image.</param>
+    /// <param name="archive_path">The path of a tiled archive to write the scene to and read the regions back from; Empty to skip it.</param>
+    void run(const std::string& header_path, const std::string& archive_path) throw(std::runtime_error);
 
 private:
 
@@ -64,121 +70,106 @@ private:
     void createWindow(const std::string& name);
 
     /// <summary>
-    /// Converts an ENVI image to OpenCV
+    /// Converts an ENVI image region to OpenCV; Regions with three or more bands are converted to color, treating the first three bands as red, green and blue;
+    /// Regions with fewer bands are shown as gray scale of the first band.
     /// </summary>
-    /// <param name="image">The image.</param>
-    /// <param name="samples">The number of samples.</param>
-    /// <param name="lines">The number of lines.</param>
-    /// <param name="bands">The number of bands.</param>
+    /// <param name="image">The image or image region.</param>
+    /// <param name="min">The sample value mapped to black.</param>
+    /// <param name="max">The sample value mapped to white.</param>
     /// <returns>The converted image</returns>
-    IplImagePtr enviToOpenCv(const envi::image_t& image, const envi::samplecount_t& samples, const envi::linecount_t& lines, const envi::bandcount_t& bands, const envi::sample_t& min = 0.0F, const envi::sample_t& max = 1.0F) const
-    {
-        assert (min < max);
-        return enviToOpenCv(image, 0, samples-1, 0, lines-1, bands, min, max);
-    }
-    
+    IplImagePtr enviToOpenCv(const envi::ImageView& image, const envi::sample_t& min, const envi::sample_t& max) const;
+
     /// <summary>
-    /// Converts an ENVI image to OpenCV
+    /// Converts an ENVI image region to OpenCV, mapping its own range of values to black and white
     /// </summary>
-    /// <param name="image">The image.</param>
-    /// <param name="samples">The number of samples.</param>
-    /// <param name="lines">The number of lines.</param>
-    /// <param name="bands">The number of bands.</param>
+    /// <param name="image">The image or image region.</param>
     /// <returns>The converted image</returns>
-    IplImagePtr enviToOpenCv(const envi::image_t& image, const envi::samplecount_t& sample_first, const envi::samplecount_t& sample_last, const envi::linecount_t& line_first, 
-        const envi::linecount_t& line_last, const envi::bandcount_t& bands, const envi::sample_t& min = 0.0F, const envi::sample_t& max = 1.0F) const;
+    IplImagePtr enviToOpenCv(const envi::ImageView& image) const;
 
     /// <summary>
     /// Scales down the image
     /// </summary>
-    /// <param name="image">The image.</param>
-    /// <param name="samples">The samples.</param>
-    /// <param name="lines">The lines.</param>
-    /// <param name="bands">The bands.</param>
+    /// <param name="image">The image or image region.</param>
     /// <param name="scaleFactor">The scaling factor; Scaling will be 1/scaleFactor. Must be larger than or equal to 1.</param>
     /// <returns>The scaled image.</returns>
-    envi::image_t scaleDownLinear(const envi::image_t& image, const envi::samplecount_t& samples, const envi::linecount_t& lines, const envi::bandcount_t& bands, const float scaleFactor) const;
+    envi::image_t scaleDownLinear(const envi::ImageView& image, const float scaleFactor) const;
 
     /// <summary>
-    /// Naive calculation of the statistics
+    /// Forward-calculation of the statistics with divide-and-conquer
     /// </summary>
-    /// <param name="image">The image.</param>
-    /// <param name="samples">The number of samples.</param>
-    /// <param name="lines">The number of lines.</param>
-    /// <param name="bands">The number of bands.</param>
-    /// <param name="min">Output: The minimum value.</param>
-    /// <param name="max">Output: The maximum value.</param>
-    /// <param name="mean">Output: The mean value.</param>
-    /// <param name="stdDev">Output: The standard deviation.</param>
-    std::shared_ptr<Stats> calculateStatisticsNaive(const envi::image_t& image, const envi::samplecount_t& samples, const envi::linecount_t& lines, const envi::bandcount_t& bands) const;
+    /// <param name="image">The image or image region; Must have a single band.</param>
+    /// <returns>The statistics.</returns>
+    std::shared_ptr<Stats> calculateStatisticsForward(const envi::ImageView& image) const
+    {
+        assert(image.bands == 1);
+        return calculateBandStatistics(image)[0];
+    }
 
     /// <summary>
-    /// Naive calculation of the statistics using divide-and-conquer
+    /// Forward-calculation of the statistics of all bands with divide-and-conquer; All bands are processed in a single pass.
     /// </summary>
-    /// <param name="image">The image.</param>
-    /// <param name="samples">The number of samples.</param>
-    /// <param name="lines">The number of lines.</param>
-    /// <param name="bands">The number of bands.</param>
-    /// <param name="min">Output: The minimum value.</param>
-    /// <param name="max">Output: The maximum value.</param>
-    /// <param name="mean">Output: The mean value.</param>
-    /// <param name="stdDev">Output: The standard deviation.</param>
-    std::shared_ptr<Stats> calculateStatisticsNaiveDivideConquer(const envi::image_t& image, const envi::samplecount_t& samples, const envi::linecount_t& lines, const envi::bandcount_t& bands) const;
+    /// <param name="image">The image or image region.</param>
+    /// <returns>The statistics, one per band.</returns>
+    bandstats_t calculateBandStatistics(const envi::ImageView& image) const;
 
     /// <summary>
-    /// Forward-calculation of the statistics with divide-and-conquer
+    /// Calculates the statistics of many regions of interest in a single parallel pass over the image. The regions are
+    /// bucketed by the strips of lines they intersect, and every line is read once for all regions that cover it.
     /// </summary>
-    /// <param name="image">The image.</param>
-    /// <param name="samples">The number of samples.</param>
-    /// <param name="lines">The number of lines.</param>
-    /// <param name="bands">The number of bands.</param>
-    /// <param name="min">Output: The minimum value.</param>
-    /// <param name="max">Output: The maximum value.</param>
-    /// <param name="mean">Output: The mean value.</param>
-    /// <param name="stdDev">Output: The standard deviation.</param>
-    std::shared_ptr<Stats> calculateStatisticsForward(const envi::image_t& image, const envi::samplecount_t& sample_first, const envi::samplecount_t& sample_last, const envi::linecount_t& line_first, 
-        const envi::linecount_t& line_last, const envi::bandcount_t& bands ) const;
+    /// <param name="image">The image or image region; The regions are relative to it.</param>
+    /// <param name="regions">The rectangles and polygons; They may overlap.</param>
+    /// <returns>The statistics of each region, one per band; All values are NaN for regions that don't cover any sample.</returns>
+    std::vector<bandstats_t> calculateRegionStatistics(const envi::ImageView& image, const std::vector<envi::RegionOfInterest>& regions) const;
 
     /// <summary>
-    /// Forward-calculation of the statistics with divide-and-conquer
+    /// Calculates the statistics of each square block of the image in a single parallel pass; Rows of blocks are processed in parallel.
     /// </summary>
-    /// <param name="image">The image.</param>
-    /// <param name="samples">The number of samples.</param>
-    /// <param name="lines">The number of lines.</param>
-    /// <param name="bands">The number of bands.</param>
-    /// <param name="min">Output: The minimum value.</param>
-    /// <param name="max">Output: The maximum value.</param>
-    /// <param name="mean">Output: The mean value.</param>
-    /// <param name="stdDev">Output: The standard deviation.</param>
-    std::shared_ptr<Stats> calculateStatisticsForward(const envi::image_t& image, const envi::samplecount_t& samples, const envi::samplecount_t& lines, const envi::bandcount_t& bands ) const {
-        return calculateStatisticsForward(image, 0, samples-1, 0, lines-1, bands);
-    }
+    /// <param name="image">The image or image region.</param>
+    /// <param name="block_size">The width and height of a block.</param>
+    /// <returns>The block statistics.</returns>
+    statsgrid_t calculateBlockStatistics(const envi::ImageView& image, const envi::samplecount_t& block_size = 64) const;
 
     /// <summary>
-    /// Forward-calculation of the statistics with divide-and-conquer
+    /// Calculates the statistics using the default method
     /// </summary>
-    /// <param name="image">The image.</param>
-    /// <param name="samples">The number of samples.</param>
-    /// <param name="lines">The number of lines.</param>
-    /// <param name="bands">The number of bands.</param>
-    /// <param name="min">Output: The minimum value.</param>
-    /// <param name="max">Output: The maximum value.</param>
-    /// <param name="mean">Output: The mean value.</param>
-    /// <param name="stdDev">Output: The standard deviation.</param>
-    std::shared_ptr<Stats> calculateStatistics(const envi::image_t& image, const envi::samplecount_t& sample_first, const envi::samplecount_t& sample_last, const envi::linecount_t& line_first, 
-        const envi::linecount_t& line_last, const envi::bandcount_t& bands ) const 
+    /// <param name="image">The image or image region; Must have a single band.</param>
+    /// <returns>The statistics.</returns>
+    std::shared_ptr<Stats> calculateStatistics(const envi::ImageView& image) const 
     {
-        return calculateStatisticsForward(image, sample_first, sample_last, line_first, line_last, bands);
+        return calculateStatisticsForward(image);
     }
 
     /// <summary>
-    /// Builds the histogram.
+    /// Looks up the statistics of all bands in the cache; If they are missing, they are calculated in a single pass and stored.
     /// </summary>
-    /// <param name="image">The image.</param>
+    /// <param name="cache">The cache of the image.</param>
+    /// <param name="key">The key of the statistics.</param>
+    /// <param name="image">The image or image region.</param>
+    /// <param name="cached">true if the statistics were taken from the cache.</param>
+    /// <returns>The statistics, one per band.</returns>
+    bandstats_t cachedStatistics(StatsCache& cache, const std::string& key, const envi::ImageView& image, out bool& cached) const;
+
+    /// <summary>
+    /// Builds the histogram of all bands in a single pass.
+    /// </summary>
+    /// <param name="image">The image or image region.</param>
+    /// <param name="low_value">The lower boundary of the first class.</param>
+    /// <param name="high_value">The upper boundary of the last class.</param>
     /// <param name="class_count">The number of classes.</param>
-    /// <returns>The classes.</returns>
-    std::unique_ptr<histogram_bin[]> buildHistogram(const envi::image_t& image, const envi::samplecount_t& samples, const envi::samplecount_t& lines, const envi::bandcount_t& bands, 
-        const stats_t low_value, const stats_t high_value, const uint_fast8_t class_count = 10) const;
+    /// <returns>The classes, band by band (<paramref name="class_count"/> classes per band).</returns>
+    std::unique_ptr<histogram_bin[]> buildHistogram(const envi::ImageView& image, const stats_t low_value, const stats_t high_value, const uint_fast8_t class_count = 10) const;
+
+    /// <summary>
+    /// Calculates the statistics and the histogram of all bands of a file in a single pass over its strips;
+    /// Only one strip is held in memory at a time, so the file may be larger than the available memory.
+    /// </summary>
+    /// <param name="reader">The strip reader of the file.</param>
+    /// <param name="low_value">The lower boundary of the first histogram class.</param>
+    /// <param name="high_value">The upper boundary of the last histogram class.</param>
+    /// <param name="histogram">The histogram classes, band by band (<paramref name="class_count"/> classes per band).</param>
+    /// <param name="class_count">The number of histogram classes.</param>
+    /// <returns>The statistics, one per band.</returns>
+    bandstats_t calculateStreamingStatistics(envi::ENVIStripReader& reader, const stats_t low_value, const stats_t high_value, out std::unique_ptr<histogram_bin[]>& histogram, const uint_fast8_t class_count = 10) const;
 };
 
 #endif
\ No newline at end of file
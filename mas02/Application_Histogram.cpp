@@ -4,109 +4,139 @@
 #include <cmath>
 #include <memory>
 
+#include "Accumulators.h"
 #include "Application.h"
 
 using namespace std;
 using namespace envi;
 
 /// <summary>
-/// Builds the histogram.
+/// Initializes a new instance of the <see cref="HistogramAccumulator"/> class.
 /// </summary>
-/// <param name="image">The image.</param>
+/// <param name="bands">The number of bands.</param>
+/// <param name="low_value">The lower boundary of the first class.</param>
+/// <param name="high_value">The upper boundary of the last class.</param>
 /// <param name="class_count">The number of classes.</param>
-/// <returns>The classes.</returns>
-unique_ptr<histogram_bin[]> Application::buildHistogram(const envi::image_t& image, const samplecount_t& samples, const samplecount_t& lines, const bandcount_t& bands, const stats_t low_value, const stats_t high_value, const uint_fast8_t class_count) const
+HistogramAccumulator::HistogramAccumulator(const bandcount_t& bands, const stats_t low_value, const stats_t high_value, const uint_fast8_t class_count)
+    : _bands(bands), _low_value(low_value), _high_value(high_value), _class_count(class_count), _counts(static_cast<size_t>(class_count) * bands, 0.0)
 {
-    assert (bands == 1);
     assert (high_value >= low_value);
+}
+
+/// <summary>
+/// Adds the samples of an image block; All lines of the block are processed in parallel.
+/// </summary>
+/// <param name="block">The image block; Must have the accumulator's number of bands.</param>
+void HistogramAccumulator::add(const ImageView& block)
+{
+    const samplecount_t samples = block.samples;
+    const linecount_t lines = block.lines;
+    const bandcount_t bands = block.bands;
+    const size_t sample_step = block.sample_stride;
+    const uint_fast8_t class_count = _class_count;
+    assert (bands == _bands);
 
-    const stats_t width = high_value - low_value;
+    // the classes of all bands, band by band
+    const uint_fast16_t bin_count = static_cast<uint_fast16_t>(class_count) * bands;
+
+    const stats_t width = _high_value - _low_value;
     const stats_t invWidth = 1.0F / width;
 
     const stats_t f_count = static_cast<stats_t>(class_count);
-    const stats_t step = width / f_count;
 
     // create a buffer of lines classes per line
-    typedef histogram_bin* histogram_t;
-    typedef histogram_t*   line_histograms_t;
-
-    line_histograms_t line_histograms = new histogram_t[lines];
-    for (linecount_t y=0; y<lines; ++y)
-    {
-        line_histograms[y] = new histogram_bin[class_count];
-        for (uint_fast8_t c=0; c<class_count; ++c)
-        {
-            line_histograms[y][c] = 0;
-        }
-    }
+    unique_ptr<histogram_bin[]> line_histograms(new histogram_bin[static_cast<size_t>(lines) * bin_count]);
+    fill(line_histograms.get(), line_histograms.get() + static_cast<size_t>(lines) * bin_count, 0.0F);
 
-    typedef int_fast32_t omp_linecount_t; // OpenMP needs signed integral type
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
     omp_linecount_t omp_lines = lines;
 
     #pragma omp parallel for
     for(omp_linecount_t y=0; y<omp_lines; ++y)
     {
-        line_t& line = image[y];
-        auto& histogram = line_histograms[y];
+        for (bandcount_t b=0; b<bands; ++b)
+        {
+            const sample_t* line = block.line(y, b);
+            histogram_bin* histogram = line_histograms.get() + static_cast<size_t>(y) * bin_count + b * class_count;
 
-        float lineSum = 0;
+            for(samplecount_t x=0; x<samples; ++x)
+            {
+                sample_t sample = line[x * sample_step];
 
-        // TODO: when multiple bands are needed, implement another loop or specific behaviour for regular band counts (1, 3, 4)
-        for(samplecount_t x=0; x<samples; ++x)
-        {
-            sample_t sample = line[x];
+                // adjust for lower boundary
+                sample = sample - _low_value;
 
-            // adjust for lower boundary
-            sample = sample - low_value;
+                // adjust for upper boundary
+                sample *= invWidth;
 
-            // adjust for upper boundary
-            sample *= invWidth;
-            
-            // lerp to class and add
-            uint_fast8_t c = static_cast<uint_fast8_t>(floor(sample * f_count));
+                // skip value if it is outside our histogram bounds
+                if (sample < 0.0F || sample > 1.0F)
+                {
+                    continue;
+                }
 
-            // skip value if it is outside our histogram bounds
-            if (sample < 0.0F || sample > 1.0F)
-            {
-                continue;
-            }
+                // lerp to class and add; the upper boundary belongs to the last class
+                uint_fast8_t c = static_cast<uint_fast8_t>(floor(sample * f_count));
+                if (c == class_count) --c;
 
-            ++histogram[c];
+                ++histogram[c];
+            }
         }
     }
-    
-    // initialize the composite histogram
-    unique_ptr<histogram_bin[]> histogram(new float[class_count]);
-    for (uint_fast8_t c=0; c<class_count; ++c)
-    {
-        histogram[c] = 0;
-    }
 
     // aggregate the line histograms
-    float count = 0;
     for (linecount_t y=0; y<lines; ++y)
     {
-        // fetch the histogram of the current line and aggregate it
-        auto& line_hist = line_histograms[y];
-        for (uint_fast8_t c=0; c<class_count; ++c)
+        const histogram_bin* line_hist = line_histograms.get() + static_cast<size_t>(y) * bin_count;
+        for (uint_fast16_t c=0; c<bin_count; ++c)
         {
-            histogram[c] += line_hist[c];
-            count += line_hist[c];
+            _counts[c] += line_hist[c];
         }
-
-        // delete the current line, we don't need it anymore
-        delete[] line_hist;
     }
+}
 
-    // delete the line histogram table
-    delete[] line_histograms;
+/// <summary>
+/// Gets the histogram of all samples added so far, normalized per band
+/// </summary>
+/// <returns>The classes, band by band.</returns>
+unique_ptr<histogram_bin[]> HistogramAccumulator::result() const
+{
+    const uint_fast16_t bin_count = static_cast<uint_fast16_t>(_class_count) * _bands;
+    unique_ptr<histogram_bin[]> histogram(new histogram_bin[bin_count]);
 
-    // scale composite histogram
-    const float invCount = 1.0F / count;
-    for (uint_fast8_t c=0; c<class_count; ++c)
+    // scale composite histogram, band by band
+    for (bandcount_t b=0; b<_bands; ++b)
     {
-        histogram[c] *= invCount;
+        const double* band_counts = _counts.data() + b * _class_count;
+        histogram_bin* band_histogram = histogram.get() + b * _class_count;
+
+        double count = 0;
+        for (uint_fast8_t c=0; c<_class_count; ++c)
+        {
+            count += band_counts[c];
+        }
+
+        const double invCount = 1.0 / count;
+        for (uint_fast8_t c=0; c<_class_count; ++c)
+        {
+            band_histogram[c] = static_cast<histogram_bin>(band_counts[c] * invCount);
+        }
     }
 
     return histogram;
 }
+
+/// <summary>
+/// Builds the histogram of all bands in a single pass.
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="low_value">The lower boundary of the first class.</param>
+/// <param name="high_value">The upper boundary of the last class.</param>
+/// <param name="class_count">The number of classes.</param>
+/// <returns>The classes, band by band (<paramref name="class_count"/> classes per band).</returns>
+unique_ptr<histogram_bin[]> Application::buildHistogram(const ImageView& image, const stats_t low_value, const stats_t high_value, const uint_fast8_t class_count) const
+{
+    HistogramAccumulator accumulator(image.bands, low_value, high_value, class_count);
+    accumulator.add(image);
+    return accumulator.result();
+}
\ No newline at end of file
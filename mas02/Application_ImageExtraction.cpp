@@ -11,32 +11,54 @@
 
 #include "ENVIFileReader.h"
 #include "Application.h"
+#include "SimdReduction.h"
 
 using namespace std;
 using namespace envi;
 
 /// <summary>
-/// Converts an ENVI image to OpenCV
+/// Maps a sample to a display value
 /// </summary>
-/// <param name="image">The image.</param>
-/// <param name="samples">The number of samples.</param>
-/// <param name="lines">The number of lines.</param>
-/// <param name="bands">The number of bands.</param>
+/// <param name="input_sample">The sample.</param>
+/// <param name="min">The sample value mapped to black.</param>
+/// <param name="lerp_scaling">The scaling from the value range to 0..255.</param>
+/// <returns>The display value.</returns>
+static inline char toDisplayValue(const sample_t& input_sample, const sample_t& min, const float& lerp_scaling)
+{
+    // lerp the value
+    sample_t sample = (input_sample - min) * lerp_scaling;
+
+    // correct in case of problems
+    if (sample < 0.0F) {
+        return 0;
+    }
+    if (sample > 255.0F) {
+        return (char)255;
+    }
+    return static_cast<uint_fast8_t>(sample);
+}
+
+/// <summary>
+/// Converts an ENVI image region to OpenCV; Regions with three or more bands are converted to color, treating the first three bands as red, green and blue;
+/// Regions with fewer bands are shown as gray scale of the first band.
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="min">The sample value mapped to black.</param>
+/// <param name="max">The sample value mapped to white.</param>
 /// <returns>The converted image</returns>
-IplImagePtr Application::enviToOpenCv(const image_t& image, const samplecount_t& sample_first, const samplecount_t& sample_last, const linecount_t& line_first, 
-        const linecount_t& line_last, const bandcount_t& bands, const envi::sample_t& min, const envi::sample_t& max) const
+IplImagePtr Application::enviToOpenCv(const ImageView& image, const envi::sample_t& min, const envi::sample_t& max) const
 {
-    assert(bands == 1);
-    assert(sample_last >= sample_first);
-    assert(line_last >= line_first);
+    const bandcount_t bands = image.bands;
     assert (min < max);
    
-    samplecount_t samples = sample_last - sample_first + 1;
-    linecount_t lines = line_last - line_first + 1;
-    IplImagePtr displayImage(cvCreateImage(cvSize(samples, lines), IPL_DEPTH_8U, bands));
+    const samplecount_t samples = image.samples;
+    const linecount_t lines = image.lines;
+    const bandcount_t channels = (bands < 3) ? 1 : 3;
+    IplImagePtr displayImage(cvCreateImage(cvSize(static_cast<int>(samples), static_cast<int>(lines)), IPL_DEPTH_8U, channels));
     samplecount_t step = displayImage->widthStep;
+    const size_t sample_step = image.sample_stride;
 
-    typedef int_fast32_t omp_linecount_t; // OpenMP needs signed integral type
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
     omp_linecount_t omp_lines = lines;
 
     const float lerp_scaling = 255.0F / (max - min);
@@ -44,16 +66,33 @@ IplImagePtr Application::enviToOpenCv(const image_t& image, const samplecount_t&
     #pragma omp parallel for
     for(omp_linecount_t y=0; y<omp_lines; ++y)
     {
-        line_t& line = image[y+line_first];
-        uint_fast32_t lineOffset = y*(step);
+        size_t lineOffset = y*(step);
 
-        // TODO: when multiple bands are needed, implement another loop or specific behaviour for regular band counts (1, 3, 4)
+        // color: all three bands of a pixel are converted in the same pass
+        if (channels == 3)
+        {
+            const sample_t* red   = image.line(y, 0);
+            const sample_t* green = image.line(y, 1);
+            const sample_t* blue  = image.line(y, 2);
+            char* pixels = &displayImage->imageData[lineOffset];
+
+            for(samplecount_t x=0; x<samples; ++x)
+            {
+                const size_t offset = x * sample_step;
+                pixels[3*x + 0] = toDisplayValue(blue[offset], min, lerp_scaling);
+                pixels[3*x + 1] = toDisplayValue(green[offset], min, lerp_scaling);
+                pixels[3*x + 2] = toDisplayValue(red[offset], min, lerp_scaling);
+            }
+            continue;
+        }
+
+        const sample_t* line = image[y];
         for(samplecount_t x=0; x<samples; ++x)
         {
             char& pixel = displayImage->imageData[lineOffset+x];
 
             // pick the sample and convert it to 8-bit unsigned
-            const sample_t input_sample = line[x+sample_first];
+            const sample_t input_sample = line[x * sample_step];
             
             // lerp the value
             sample_t sample = (input_sample - min) * lerp_scaling;
@@ -73,63 +112,143 @@ IplImagePtr Application::enviToOpenCv(const image_t& image, const samplecount_t&
     return displayImage;
 }
 
+/// <summary>
+/// Determines the range of the values of an image region
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="min">The minimum value.</param>
+/// <param name="max">The maximum value.</param>
+static void valueRange(const ImageView& image, sample_t& min, sample_t& max)
+{
+    const samplecount_t samples = image.samples;
+    const linecount_t lines = image.lines;
+    const bandcount_t bands = image.bands;
+
+    // all bands of a line are contiguous if the region interleaves all of its bands by pixel
+    const bool pixel_line = (image.interleave == BIP) && (image.sample_stride == bands);
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    // array for intermediate results of each line
+    unique_ptr<sample_t[]> line_min(new sample_t[lines]);
+    unique_ptr<sample_t[]> line_max(new sample_t[lines]);
+
+    #pragma omp parallel for
+    for(omp_linecount_t y=0; y<omp_lines; ++y)
+    {
+        sample_t low = FLT_MAX;
+        sample_t high = -FLT_MAX;
+
+        if (pixel_line)
+        {
+            reduceMinMax(image.line(y), static_cast<size_t>(samples) * bands, low, high);
+        }
+        else
+        {
+            for (bandcount_t b=0; b<bands; ++b)
+            {
+                const sample_t* line = image.line(y, b);
+                sample_t band_low, band_high;
+
+                if (image.sample_stride == 1)
+                {
+                    reduceMinMax(line, static_cast<size_t>(samples), band_low, band_high);
+                }
+                else
+                {
+                    band_low = FLT_MAX;
+                    band_high = -FLT_MAX;
+                    for(samplecount_t x=0; x<samples; ++x)
+                    {
+                        const sample_t& sample = line[x * image.sample_stride];
+                        if (sample < band_low) band_low = sample;
+                        if (sample > band_high) band_high = sample;
+                    }
+                }
+
+                low = std::min(low, band_low);
+                high = std::max(high, band_high);
+            }
+        }
+
+        line_min[y] = low;
+        line_max[y] = high;
+    }
+
+    // conquer intermediate results
+    min = FLT_MAX;
+    max = -FLT_MAX;
+    for(linecount_t y=0; y<lines; ++y)
+    {
+        if (line_min[y] < min) min = line_min[y];
+        if (line_max[y] > max) max = line_max[y];
+    }
+}
+
+/// <summary>
+/// Converts an ENVI image region to OpenCV, mapping its own range of values to black and white
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <returns>The converted image</returns>
+IplImagePtr Application::enviToOpenCv(const ImageView& image) const
+{
+    sample_t min, max;
+    valueRange(image, min, max);
+
+    // a constant image would have an empty range
+    if (!(min < max)) max = min + 1.0F;
+
+    return enviToOpenCv(image, min, max);
+}
+
 /// <summary>
 /// Scales down the image
 /// </summary>
-/// <param name="image">The image.</param>
-/// <param name="samples">The samples.</param>
-/// <param name="lines">The lines.</param>
-/// <param name="bands">The bands.</param>
+/// <param name="image">The image or image region.</param>
 /// <param name="scaleFactor">The scaling factor. Must be larger than or equal to 1.</param>
 /// <returns>The scaled image.</returns>
-image_t Application::scaleDownLinear(const image_t& image, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands, const float scaleFactor) const
+image_t Application::scaleDownLinear(const ImageView& image, const float scaleFactor) const
 {
     assert(scaleFactor >= 1.0F);
 
+    const samplecount_t samples = image.samples;
+    const linecount_t lines = image.lines;
+
     float invScaleFactor = 1.0F/scaleFactor;
     samplecount_t new_samples = static_cast<samplecount_t>(samples * invScaleFactor);
     linecount_t new_lines = static_cast<linecount_t>(lines * invScaleFactor);
 
     // === perpare copy ===
 
-    // create the line array
-    image_t target = image_t(new line_t[new_lines]);
-    if (!image) throw runtime_error("not enough memory to create scaled-down line array");
-
-    // for each line, create the sample array
-    for (linecount_t lineIndex = 0; lineIndex < new_lines; ++lineIndex)
-    {
-        target[lineIndex].reset(new sample_t[new_samples]);
-        if (!target[lineIndex]) throw runtime_error("not enough memory to create scaled-down sample array");
-    }
+    // create the target image in the same band order
+    const bandcount_t bands = image.bands;
+    image_t target(new Image(new_samples, new_lines, bands, image.interleave));
+    const size_t source_step = image.sample_stride;
+    const size_t target_step = (image.interleave == BIP) ? bands : 1;
 
     // === copy image ===
 
-    typedef int_fast32_t omp_linecount_t; // OpenMP needs signed integral type
-    omp_linecount_t omp_lines = lines;
-    
-    omp_linecount_t omp_line_skip = static_cast<omp_linecount_t>(scaleFactor);
-    samplecount_t sample_skip = static_cast<samplecount_t>(scaleFactor);
-    assert(omp_line_skip >= 1.0F);
-    assert(sample_skip >= 1.0F);
-    
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_new_lines = new_lines;
+
+    // every target line picks its nearest source line, which also works for fractional factors
     #pragma omp parallel for
-    for(omp_linecount_t y=0; y<omp_lines; y += omp_line_skip)
+    for(omp_linecount_t target_y=0; target_y<omp_new_lines; ++target_y)
     {
-        linecount_t target_y = static_cast<linecount_t>(y * invScaleFactor);
-
-        const line_t& source_line = image[y];
-        line_t& target_line = target[target_y];
-        samplecount_t target_x = 0;
+        const linecount_t y = min<linecount_t>(static_cast<linecount_t>(target_y * scaleFactor), lines - 1);
 
-        // TODO: when multiple bands are needed, implement another loop or specific behaviour for regular band counts (1, 3, 4)
-        for(samplecount_t x=0; x<samples; x += sample_skip)
+        for (bandcount_t b=0; b<bands; ++b)
         {
-            target_line[target_x] = source_line[x];
-            ++target_x;
-        }
+            const sample_t* source_line = image.line(y, b);
+            sample_t* target_line = target->line(target_y, b);
 
-        ++target_y;
+            for(samplecount_t target_x=0; target_x<new_samples; ++target_x)
+            {
+                const samplecount_t x = min<samplecount_t>(static_cast<samplecount_t>(target_x * scaleFactor), samples - 1);
+                target_line[target_x * target_step] = source_line[x * source_step];
+            }
+        }
     }
 
     return target;
@@ -2,333 +2,708 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <memory>
 
+#include <emmintrin.h>
+
+#include "Accumulators.h"
 #include "Application.h"
+#include "RegionOfInterest.h"
+#include "SimdReduction.h"
 #include "Stats.h"
+#include "StatsGrid.h"
 
 using namespace std;
 using namespace envi;
 
 /// <summary>
-/// Naive calculation of the statistics
+/// Partial statistics of a single line of a band: the number of samples, their mean and the sum of their
+/// squared deviations from the mean, all in double precision.
 /// </summary>
-/// <param name="image">The image.</param>
-/// <param name="samples">The number of samples.</param>
-/// <param name="lines">The number of lines.</param>
-/// <param name="bands">The number of bands.</param>
-/// <param name="min">Output: The minimum value.</param>
-/// <param name="max">Output: The maximum value.</param>
-/// <param name="mean">Output: The mean value.</param>
-/// <param name="stdDev">Output: The standard deviation.</param>
-shared_ptr<Stats> Application::calculateStatisticsNaive(const image_t& image, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands
-                                            ) const
+struct LineStats
+{
+    double count;
+    double mean;
+    double m2;
+    stats_t min;
+    stats_t max;
+};
+
+/// <summary>
+/// Combines two partial statistics (Chan et al.); The result is as accurate as if all samples had been seen by a single accumulator.
+/// </summary>
+/// <param name="target">The partial statistics to merge into.</param>
+/// <param name="other">The partial statistics to merge.</param>
+static inline void mergeLineStats(LineStats& target, const LineStats& other)
 {
-    assert(bands == 1);
+    if (other.count == 0) return;
+    if (target.count == 0)
+    {
+        target = other;
+        return;
+    }
 
-    stats_t min = FLT_MAX;
-    stats_t max = FLT_MIN;
-    stats_t mean = 0;
-    stats_t stdDev = 0;
+    const double count = target.count + other.count;
+    const double delta = other.mean - target.mean;
 
-    const stats_t invLines = 1.0F / lines;
-    const stats_t invSamples = 1.0F / samples;
-    const stats_t invSamplesA = 1.0F / (samples-1);
+    target.mean += delta * (other.count / count);
+    target.m2   += other.m2 + delta * delta * (target.count * other.count / count);
+    target.count = count;
 
-    // first run: gather min, max and mean
-    for(linecount_t y=0; y<lines; ++y)
-    {
-        const line_t& line = image[y];
-        stats_t lineSum = 0;
+    if (other.min < target.min) target.min = other.min;
+    if (other.max > target.max) target.max = other.max;
+}
 
-        // TODO: when multiple bands are needed, implement another loop or specific behaviour for regular band counts (1, 3, 4)
-        for(samplecount_t x=0; x<samples; ++x)
+/// <summary>
+/// Merges partial statistics in pairs, then pairs of pairs and so on, so that only partial statistics
+/// of similar size are combined.
+/// </summary>
+/// <param name="stats">The partial statistics; The first entry receives the result.</param>
+/// <param name="count">The number of partial statistics.</param>
+/// <param name="stride">The distance between two partial statistics.</param>
+static inline void mergePairwise(LineStats* stats, const size_t& count, const size_t& stride)
+{
+    for (size_t width=1; width<count; width *= 2)
+    {
+        for (size_t i=0; i+width<count; i += 2*width)
         {
-            const sample_t& sample = line[x];
-            
-            // update mean
-            lineSum += sample;
-
-            // update minimum
-            if (sample < min) {
-                min = sample;
-            }
+            mergeLineStats(stats[i * stride], stats[(i + width) * stride]);
+        }
+    }
+}
 
-            // update maximum
-            if (sample > max) {
-                max = sample;
-            }
+/// <summary>
+/// Resets partial statistics to those of no samples at all
+/// </summary>
+/// <param name="stats">The partial statistics.</param>
+static inline void clearLineStats(LineStats& stats)
+{
+    stats.count = 0;
+    stats.mean = 0;
+    stats.m2 = 0;
+    stats.min = FLT_MAX;
+    stats.max = -FLT_MAX;
+}
+
+/// <summary>
+/// Turns the totals of a band into its statistics, the same way for every caller: Without any sample all values are NaN,
+/// a single sample has a standard deviation of 0, and more samples give the sample standard deviation.
+/// </summary>
+/// <param name="count">The number of samples.</param>
+/// <param name="mean">The mean.</param>
+/// <param name="m2">The sum of squared deviations from the mean.</param>
+/// <param name="min">The minimum.</param>
+/// <param name="max">The maximum.</param>
+/// <returns>The statistics.</returns>
+static inline Stats finalizeStats(const double& count, const double& mean, const double& m2, const stats_t& min, const stats_t& max)
+{
+    if (count == 0)
+    {
+        const stats_t nan = numeric_limits<stats_t>::quiet_NaN();
+        return Stats(nan, nan, nan, nan);
+    }
+
+    // sample variance from the squared deviations
+    const double variance = (count > 1) ? m2 / (count - 1) : 0.0;
+    return Stats(min, max, static_cast<stats_t>(mean), static_cast<stats_t>(sqrt(variance)));
+}
+
+/// <summary>
+/// Gathers the partial statistics of a single line of a band; Contiguous lines are reduced to shifted sums by the
+/// vector kernel selected for this processor, others are run through a Welford update.
+/// </summary>
+/// <param name="line">The first sample of the line.</param>
+/// <param name="step">The distance between two samples of the band.</param>
+/// <param name="samples">The number of samples.</param>
+/// <param name="stats">The partial statistics.</param>
+static inline void accumulateBandLine(const sample_t* line, const size_t& step, const samplecount_t& samples, LineStats& stats)
+{
+    // contiguous lines go through the vector kernels, which sum up the differences to the first sample and their squares;
+    // With a shift close to the mean the squared deviations sum_sq - sum^2/count hardly suffer from cancellation
+    if (step == 1 && samples > 0)
+    {
+        Reduction reduction;
+        const float shift = line[0];
+        reduceMinMaxSums(line, static_cast<size_t>(samples), shift, reduction);
+
+        const double count = static_cast<double>(samples);
+        stats.count = count;
+        stats.mean = shift + reduction.sum / count;
+        stats.m2 = max(reduction.sum_sq - reduction.sum * reduction.sum / count, 0.0);
+        stats.min = reduction.min;
+        stats.max = reduction.max;
+        return;
+    }
+
+    double mean = 0;
+    double m2 = 0;
+    stats_t lineMin = FLT_MAX;
+    stats_t lineMax = -FLT_MAX;
+
+    for(samplecount_t x=0; x<samples; ++x)
+    {
+        const sample_t& sample = line[x * step];
+
+        // update mean and squared deviations
+        const double delta = sample - mean;
+        mean += delta / static_cast<double>(x + 1);
+        m2 += delta * (sample - mean);
+
+        // update minimum
+        if (sample < lineMin) {
+            lineMin = sample;
         }
 
-        // aggregate mean per line
-        mean += lineSum * invSamples;
+        // update maximum
+        if (sample > lineMax) {
+            lineMax = sample;
+        }
+    }
+
+    stats.count = static_cast<double>(samples);
+    stats.mean = mean;
+    stats.m2 = m2;
+    stats.min = lineMin;
+    stats.max = lineMax;
+}
+
+/// <summary>
+/// Updates the means and squared deviations of two lanes with the next values
+/// </summary>
+/// <param name="values">The values.</param>
+/// <param name="inv_count">One over the number of values seen so far, including these.</param>
+/// <param name="mean">The means.</param>
+/// <param name="m2">The sums of squared deviations.</param>
+static inline void welfordUpdate(const __m128d& values, const __m128d& inv_count, __m128d& mean, __m128d& m2)
+{
+    const __m128d delta = _mm_sub_pd(values, mean);
+    mean = _mm_add_pd(mean, _mm_mul_pd(delta, inv_count));
+    m2   = _mm_add_pd(m2, _mm_mul_pd(delta, _mm_sub_pd(values, mean)));
+}
+
+/// <summary>
+/// Gathers the partial statistics of a single line of a four-band, pixel-interleaved region.
+/// Every pixel fills exactly one SSE register, so all bands are processed with a single instruction.
+/// </summary>
+/// <param name="line">The first sample of the line.</param>
+/// <param name="samples">The number of samples.</param>
+/// <param name="stats">The partial statistics, one per band.</param>
+static inline void accumulatePixelLine4(const sample_t* line, const samplecount_t& samples, LineStats* stats)
+{
+    __m128d mean_lo = _mm_setzero_pd(), mean_hi = _mm_setzero_pd();
+    __m128d m2_lo = _mm_setzero_pd(), m2_hi = _mm_setzero_pd();
+    __m128 min = _mm_set1_ps(FLT_MAX);
+    __m128 max = _mm_set1_ps(-FLT_MAX);
+
+    for(samplecount_t x=0; x<samples; ++x)
+    {
+        const __m128 pixel = _mm_loadu_ps(line + 4*x);
+        const __m128d inv_count = _mm_set1_pd(1.0 / static_cast<double>(x + 1));
+
+        // bands 0 and 1 in the low, bands 2 and 3 in the high register
+        welfordUpdate(_mm_cvtps_pd(pixel), inv_count, mean_lo, m2_lo);
+        welfordUpdate(_mm_cvtps_pd(_mm_movehl_ps(pixel, pixel)), inv_count, mean_hi, m2_hi);
+
+        min = _mm_min_ps(min, pixel);
+        max = _mm_max_ps(max, pixel);
     }
 
-    // adjust mean over all lines
-    mean *= invLines;
-    
-    // second run: calculate variance
-    stats_t variance = 0;
-    for(linecount_t y=0; y<lines; ++y)
+    double means[4], m2s[4];
+    float mins[4], maxs[4];
+    _mm_storeu_pd(means, mean_lo);
+    _mm_storeu_pd(means + 2, mean_hi);
+    _mm_storeu_pd(m2s, m2_lo);
+    _mm_storeu_pd(m2s + 2, m2_hi);
+    _mm_storeu_ps(mins, min);
+    _mm_storeu_ps(maxs, max);
+
+    for (bandcount_t b=0; b<4; ++b)
     {
-        const line_t& line = image[y];
-        stats_t rowVariance = 0;
+        stats[b].count = static_cast<double>(samples);
+        stats[b].mean = means[b];
+        stats[b].m2 = m2s[b];
+        stats[b].min = mins[b];
+        stats[b].max = maxs[b];
+    }
+}
 
-        // TODO: when multiple bands are needed, implement another loop or specific behaviour for regular band counts (1, 3, 4)
-        for(samplecount_t x=0; x<samples; ++x)
+/// <summary>
+/// Gathers the partial statistics of a single line of a three-band, pixel-interleaved region.
+/// Four pixels fill three SSE registers; The lane-to-band assignment repeats every three registers
+/// and is resolved after the line has been processed.
+/// </summary>
+/// <param name="line">The first sample of the line.</param>
+/// <param name="samples">The number of samples.</param>
+/// <param name="stats">The partial statistics, one per band.</param>
+static inline void accumulatePixelLine3(const sample_t* line, const samplecount_t& samples, LineStats* stats)
+{
+    __m128d mean_lo[3], mean_hi[3], m2_lo[3], m2_hi[3];
+    __m128 min[3], max[3];
+    for (uint_fast8_t r=0; r<3; ++r)
+    {
+        mean_lo[r] = mean_hi[r] = _mm_setzero_pd();
+        m2_lo[r] = m2_hi[r] = _mm_setzero_pd();
+        min[r] = _mm_set1_ps(FLT_MAX);
+        max[r] = _mm_set1_ps(-FLT_MAX);
+    }
+
+    // four pixels (twelve values) per iteration; Every lane sees one value per iteration
+    const samplecount_t blocks = samples / 4;
+    for(samplecount_t block=0; block<blocks; ++block)
+    {
+        const sample_t* values = line + 12*block;
+        const __m128d inv_count = _mm_set1_pd(1.0 / static_cast<double>(block + 1));
+
+        for (uint_fast8_t r=0; r<3; ++r)
         {
-            const sample_t& sample = line[x];
-            
-            const stats_t diff = sample - mean;
-            rowVariance += (diff * diff);
+            const __m128 v = _mm_loadu_ps(values + 4*r);
+            welfordUpdate(_mm_cvtps_pd(v), inv_count, mean_lo[r], m2_lo[r]);
+            welfordUpdate(_mm_cvtps_pd(_mm_movehl_ps(v, v)), inv_count, mean_hi[r], m2_hi[r]);
+            min[r] = _mm_min_ps(min[r], v);
+            max[r] = _mm_max_ps(max[r], v);
         }
+    }
 
-        // aggregate variance per line
-        variance += rowVariance * invSamplesA; // Stichprobenvarianz, sample variance
+    for (bandcount_t b=0; b<3; ++b)
+    {
+        clearLineStats(stats[b]);
     }
 
-    // second run, part two: scale variance and calculate standard deviation
-    variance *= invLines;
-    stdDev = sqrt(variance);
+    // fold the lanes: lane l of register r holds band (4r + l) mod 3
+    for (uint_fast8_t r=0; r<3; ++r)
+    {
+        double means[4], m2s[4];
+        float mins[4], maxs[4];
+        _mm_storeu_pd(means, mean_lo[r]);
+        _mm_storeu_pd(means + 2, mean_hi[r]);
+        _mm_storeu_pd(m2s, m2_lo[r]);
+        _mm_storeu_pd(m2s + 2, m2_hi[r]);
+        _mm_storeu_ps(mins, min[r]);
+        _mm_storeu_ps(maxs, max[r]);
+
+        for (uint_fast8_t l=0; l<4; ++l)
+        {
+            const LineStats lane = { static_cast<double>(blocks), means[l], m2s[l], mins[l], maxs[l] };
+            mergeLineStats(stats[(4*r + l) % 3], lane);
+        }
+    }
 
-    // up, up and away
-    return shared_ptr<Stats>(new Stats(min, max, mean, stdDev));
+    // remaining pixels
+    for(samplecount_t x=4*blocks; x<samples; ++x)
+    {
+        for (bandcount_t b=0; b<3; ++b)
+        {
+            const sample_t& sample = line[3*x + b];
+            LineStats& band = stats[b];
+
+            band.count += 1;
+            const double delta = sample - band.mean;
+            band.mean += delta / band.count;
+            band.m2 += delta * (sample - band.mean);
+
+            if (sample < band.min) band.min = sample;
+            if (sample > band.max) band.max = sample;
+        }
+    }
 }
 
 /// <summary>
-/// Naive calculation of the statistics
+/// Initializes a new instance of the <see cref="BandStatsAccumulator"/> class.
 /// </summary>
-/// <param name="image">The image.</param>
-/// <param name="samples">The number of samples.</param>
-/// <param name="lines">The number of lines.</param>
 /// <param name="bands">The number of bands.</param>
-/// <param name="min">Output: The minimum value.</param>
-/// <param name="max">Output: The maximum value.</param>
-/// <param name="mean">Output: The mean value.</param>
-/// <param name="stdDev">Output: The standard deviation.</param>
-shared_ptr<Stats> Application::calculateStatisticsNaiveDivideConquer(const image_t& image, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands
-                                                        ) const
+BandStatsAccumulator::BandStatsAccumulator(const bandcount_t& bands)
+    : _bands(bands), _count(0), _mean(bands, 0.0), _m2(bands, 0.0), _min(bands, FLT_MAX), _max(bands, -FLT_MAX)
+{
+}
+
+/// <summary>
+/// Combines the totals of a band with partial statistics (Chan et al.); The number of samples is not updated.
+/// </summary>
+/// <param name="band">The band.</param>
+/// <param name="count">The number of samples of the partial statistics.</param>
+/// <param name="mean">The mean of the partial statistics.</param>
+/// <param name="m2">The sum of squared deviations from the mean of the partial statistics.</param>
+/// <param name="min">The minimum of the partial statistics.</param>
+/// <param name="max">The maximum of the partial statistics.</param>
+void BandStatsAccumulator::merge(const bandcount_t& band, const double& count, const double& mean, const double& m2, const stats_t& min, const stats_t& max)
 {
-    assert(bands == 1);
+    if (count == 0) return;
 
-    stats_t min = FLT_MAX;
-    stats_t max = FLT_MIN;
-    stats_t mean = 0;
-    stats_t stdDev = 0;
+    const double own_count = static_cast<double>(_count);
+    const double total = own_count + count;
+    const double delta = mean - _mean[band];
 
-    const stats_t count = static_cast<stats_t>(samples * lines);
-    const stats_t invLines = 1.0F / lines;
-    const stats_t invSamples = 1.0F / samples;
-    const stats_t invSamplesA = 1.0F / (samples-1);
+    _mean[band] += delta * (count / total);
+    _m2[band]   += m2 + delta * delta * (own_count * count / total);
 
-    // array for intermediate results of each line
-    unique_ptr<stats_t[]> intermediate(new stats_t[lines]);
-    unique_ptr<stats_t[]> intermediate_min(new stats_t[lines]);
-    unique_ptr<stats_t[]> intermediate_max(new stats_t[lines]);
+    if (min < _min[band]) _min[band] = min;
+    if (max > _max[band]) _max[band] = max;
+}
 
-    typedef int_fast32_t omp_linecount_t; // OpenMP needs signed integral type
+/// <summary>
+/// Adds the samples of an image block; All lines of the block are processed in parallel and merged pairwise.
+/// </summary>
+/// <param name="block">The image block; Must have the accumulator's number of bands.</param>
+void BandStatsAccumulator::add(const ImageView& block)
+{
+    const samplecount_t samples = block.samples;
+    const linecount_t lines = block.lines;
+    const bandcount_t bands = block.bands;
+    assert(bands == _bands);
+    if (samples == 0 || lines == 0) return;
+
+    // pixel-interleaved regions with three or four bands have dedicated SIMD paths
+    const bool pixel_interleaved = (block.sample_stride == bands);
+    const bool simd3 = pixel_interleaved && (bands == 3);
+    const bool simd4 = pixel_interleaved && (bands == 4);
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
     omp_linecount_t omp_lines = lines;
 
-    // first run: gather min, max and mean
+    // array for intermediate results of each line and band
+    unique_ptr<LineStats[]> intermediate(new LineStats[static_cast<size_t>(lines) * bands]);
+
+    // single run: gather min, max, mean and squared deviations
     #pragma omp parallel for
     for(omp_linecount_t y=0; y<omp_lines; ++y)
     {
-        const line_t& line = image[y];
-        stats_t lineSum = 0;
-        stats_t lineMin = FLT_MAX;
-        stats_t lineMax = FLT_MIN;
+        LineStats* line_stats = &intermediate[static_cast<size_t>(y) * bands];
 
-        // TODO: when multiple bands are needed, implement another loop or specific behaviour for regular band counts (1, 3, 4)
-        for(samplecount_t x=0; x<samples; ++x)
+        if (simd4)
         {
-            const sample_t& sample = line[x];
-            
-            // update mean
-            lineSum += sample;
-
-            // update minimum
-            if (sample < lineMin) {
-                lineMin = sample;
-            }
-
-            // update maximum
-            if (sample > lineMax) {
-                lineMax = sample;
+            accumulatePixelLine4(block.line(y), samples, line_stats);
+        }
+        else if (simd3)
+        {
+            accumulatePixelLine3(block.line(y), samples, line_stats);
+        }
+        else
+        {
+            for (bandcount_t b=0; b<bands; ++b)
+            {
+                accumulateBandLine(block.line(y, b), block.sample_stride, samples, line_stats[b]);
             }
         }
-
-        // aggregate mean per line
-        intermediate[y] = lineSum;
-        intermediate_min[y] = lineMin;
-        intermediate_max[y] = lineMax;
     }
 
     // conquer intermediate results
-    for(linecount_t y=0; y<lines; ++y)
+    for (bandcount_t b=0; b<bands; ++b)
     {
-        // update minimum
-        stats_t& lineMin = intermediate_min[y];
-        if (lineMin < min) {
-            min = lineMin;
-        }
+        LineStats* band_stats = &intermediate[b];
+        mergePairwise(band_stats, static_cast<size_t>(lines), bands);
+        merge(b, band_stats->count, band_stats->mean, band_stats->m2, band_stats->min, band_stats->max);
+    }
 
-        // update maximum
-        stats_t& lineMax = intermediate_max[y];
-        if (lineMax > max) {
-            max = lineMax;
-        }
+    _count += static_cast<uint64_t>(samples) * lines;
+}
 
-        // update mean
-        mean += intermediate[y];
+/// <summary>
+/// Adds the totals of another accumulator, as if its samples had been added to this one
+/// </summary>
+/// <param name="other">The other accumulator; Must have the same number of bands.</param>
+void BandStatsAccumulator::merge(const BandStatsAccumulator& other)
+{
+    assert(other._bands == _bands);
+
+    for (bandcount_t b=0; b<_bands; ++b)
+    {
+        merge(b, static_cast<double>(other._count), other._mean[b], other._m2[b], other._min[b], other._max[b]);
     }
-    mean *= invLines * invSamples;
 
-    // release memory
-    intermediate_max.reset();
-    intermediate_min.reset();
-    
-    // second run: calculate variance
-    #pragma omp parallel for
-    for(omp_linecount_t y=0; y<omp_lines; ++y)
+    _count += other._count;
+}
+
+/// <summary>
+/// Writes the running totals as a single line of text
+/// </summary>
+/// <param name="stream">The stream.</param>
+void BandStatsAccumulator::write(ostream& stream) const
+{
+    // enough digits to read back the exact values
+    const streamsize precision = stream.precision(17);
+
+    stream << _count;
+    for (bandcount_t b=0; b<_bands; ++b)
     {
-        const line_t& line = image[y];
-        stats_t rowVariance = 0;
+        stream << ' ' << _mean[b] << ' ' << _m2[b] << ' ' << _min[b] << ' ' << _max[b];
+    }
+    stream << '\n';
 
-        // TODO: when multiple bands are needed, implement another loop or specific behaviour for regular band counts (1, 3, 4)
-        for(samplecount_t x=0; x<samples; ++x)
-        {
-            const sample_t& sample = line[x];
-            
-            const stats_t diff = sample - mean;
-            rowVariance += (diff * diff);
-        }
+    stream.precision(precision);
+}
 
-        // aggregate variance per line
-        intermediate[y] = rowVariance;
+/// <summary>
+/// Replaces the running totals by totals written by <see cref="write"/>
+/// </summary>
+/// <param name="stream">The stream.</param>
+void BandStatsAccumulator::read(istream& stream)
+{
+    stream >> _count;
+    for (bandcount_t b=0; b<_bands; ++b)
+    {
+        stream >> _mean[b] >> _m2[b] >> _min[b] >> _max[b];
     }
 
-    // second run, part two: scale variance and calculate standard deviation
-    // conquer intermediate results
-    stats_t variance = 0;
-    for(linecount_t y=0; y<lines; ++y)
+    if (!stream) throw runtime_error("Could not read statistics totals");
+}
+
+/// <summary>
+/// Gets the statistics of all samples added so far
+/// </summary>
+/// <returns>The statistics, one per band.</returns>
+bandstats_t BandStatsAccumulator::result() const
+{
+    const double count = static_cast<double>(_count);
+
+    bandstats_t stats;
+    for (bandcount_t b=0; b<_bands; ++b)
     {
-        variance += intermediate[y];
+        stats.push_back(shared_ptr<Stats>(new Stats(finalizeStats(count, _mean[b], _m2[b], _min[b], _max[b]))));
     }
-    variance *= invLines * invSamplesA; // Stichprobenvarianz, sample variance
-    stdDev = sqrt(variance);
 
     // up, up and away
-    return shared_ptr<Stats>(new Stats(min, max, mean, stdDev));
+    return stats;
 }
 
+/// <summary>
+/// Forward-calculation of the statistics of all bands with divide-and-conquer; All bands are processed in a single pass.
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <returns>The statistics, one per band.</returns>
+bandstats_t Application::calculateBandStatistics(const ImageView& image) const
+{
+    BandStatsAccumulator accumulator(image.bands);
+    accumulator.add(image);
+    return accumulator.result();
+}
 
 /// <summary>
-/// Forward-calculation of the statistics with divide-and-conquer
+/// The number of lines per strip of <see cref="Application::calculateRegionStatistics"/>; Regions are bucketed by strip
 /// </summary>
-/// <param name="image">The image.</param>
-/// <param name="samples">The number of samples.</param>
-/// <param name="lines">The number of lines.</param>
-/// <param name="bands">The number of bands.</param>
-/// <param name="min">Output: The minimum value.</param>
-/// <param name="max">Output: The maximum value.</param>
-/// <param name="mean">Output: The mean value.</param>
-/// <param name="stdDev">Output: The standard deviation.</param>
-shared_ptr<Stats> Application::calculateStatisticsForward(const image_t& image, const samplecount_t& sample_first, const samplecount_t& sample_last, const linecount_t& line_first, const linecount_t& line_last, const bandcount_t& bands
-                                                        ) const
+static const linecount_t REGION_STRIP_LINES = 32;
+
+/// <summary>
+/// Calculates the statistics of many regions of interest in a single parallel pass over the image. The regions are
+/// bucketed by the strips of lines they intersect, and every line is read once for all regions that cover it.
+/// </summary>
+/// <param name="image">The image or image region; The regions are relative to it.</param>
+/// <param name="regions">The rectangles and polygons; They may overlap.</param>
+/// <returns>The statistics of each region, one per band; All values are NaN for regions that don't cover any sample.</returns>
+vector<bandstats_t> Application::calculateRegionStatistics(const ImageView& image, const vector<RegionOfInterest>& regions) const
 {
-    assert(bands == 1);
-    assert(sample_last >= sample_first);
-    assert(line_last >= line_first);
-
-    stats_t min = FLT_MAX;
-    stats_t max = FLT_MIN;
-    stats_t mean = 0;
-    stats_t stdDev = 0;
-    stats_t variance = 0;
-
-    samplecount_t samples = sample_last - sample_first + 1;
-    linecount_t lines = line_last - line_first + 1;
-
-    const stats_t count = static_cast<stats_t>(samples * lines);
-    const stats_t invLines = 1.0F / lines;
-    const stats_t invSamples = 1.0F / samples;
-    const stats_t invSamplesA = 1.0F / (samples-1);
-    
-    stats_t sum = 0;
-    stats_t squareSum = 0;
-
-    typedef int_fast32_t omp_linecount_t; // OpenMP needs signed integral type
-    omp_linecount_t omp_lines = lines;
+    const samplecount_t samples = image.samples;
+    const linecount_t lines = image.lines;
+    const bandcount_t bands = image.bands;
+    const size_t step = image.sample_stride;
+
+    // bucket the regions by the strips they may intersect
+    const size_t strips = static_cast<size_t>((lines + REGION_STRIP_LINES - 1) / REGION_STRIP_LINES);
+    vector<vector<size_t>> buckets(strips);
+    for (size_t r=0; r<regions.size(); ++r)
+    {
+        const linecount_t first = regions[r].firstLine();
+        const linecount_t end = min<linecount_t>(regions[r].endLine(), lines);
+        if (first >= end) continue;
 
-    // array for intermediate results of each line
-    unique_ptr<stats_t[]> intermediate_sum(new stats_t[lines]);
-    unique_ptr<stats_t[]> intermediate_ssq(new stats_t[lines]);
-    unique_ptr<stats_t[]> intermediate_min(new stats_t[lines]);
-    unique_ptr<stats_t[]> intermediate_max(new stats_t[lines]);
+        for (size_t s = static_cast<size_t>(first / REGION_STRIP_LINES); s <= static_cast<size_t>((end - 1) / REGION_STRIP_LINES); ++s)
+        {
+            buckets[s].push_back(r);
+        }
+    }
 
-    // single run: gather min, max, mean and standard deviation
-    #pragma omp parallel for
-    for(omp_linecount_t y=0; y<omp_lines; ++y)
+    // partial statistics of each region of a strip, band by band
+    vector<vector<LineStats>> partials(strips);
+
+    typedef int_fast64_t omp_stripcount_t; // OpenMP needs signed integral type
+    omp_stripcount_t omp_strips = strips;
+
+    // strips differ in the number of regions they carry, so they are handed out one by one
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_stripcount_t s=0; s<omp_strips; ++s)
     {
-        const line_t& line = image[y+line_first];
-        stats_t lineSum = 0;
-        stats_t lineSumSq = 0;
-        stats_t lineMin = FLT_MAX;
-        stats_t lineMax = FLT_MIN;
-
-        // TODO: when multiple bands are needed, implement another loop or specific behaviour for regular band counts (1, 3, 4)
-        for(samplecount_t x=sample_first; x<=sample_last; ++x)
+        const vector<size_t>& bucket = buckets[s];
+        vector<LineStats>& strip_stats = partials[s];
+        strip_stats.resize(bucket.size() * bands);
+        for (size_t i=0; i<strip_stats.size(); ++i)
         {
-            const sample_t& sample = line[x];
-            
-            lineSum += sample;
-            lineSumSq += sample * sample;
-
-            // update minimum
-            if (sample < lineMin) {
-                lineMin = sample;
+            clearLineStats(strip_stats[i]);
+        }
+
+        const linecount_t y_first = static_cast<linecount_t>(s) * REGION_STRIP_LINES;
+        const linecount_t y_end = min<linecount_t>(y_first + REGION_STRIP_LINES, lines);
+        vector<Span> spans;
+
+        // line by line, so that overlapping regions find the line in the cache
+        for (linecount_t y=y_first; y<y_end; ++y)
+        {
+            for (size_t i=0; i<bucket.size(); ++i)
+            {
+                regions[bucket[i]].spans(y, samples, spans);
+
+                for (size_t k=0; k<spans.size(); ++k)
+                {
+                    for (bandcount_t b=0; b<bands; ++b)
+                    {
+                        LineStats span_stats;
+                        accumulateBandLine(image.line(y, b) + spans[k].first * step, step, spans[k].samples, span_stats);
+                        mergeLineStats(strip_stats[i * bands + b], span_stats);
+                    }
+                }
             }
+        }
+    }
 
-            // update maximum
-            if (sample > lineMax) {
-                lineMax = sample;
+    // conquer the strips of each region
+    vector<LineStats> totals(regions.size() * bands);
+    for (size_t i=0; i<totals.size(); ++i)
+    {
+        clearLineStats(totals[i]);
+    }
+
+    for (size_t s=0; s<strips; ++s)
+    {
+        for (size_t i=0; i<buckets[s].size(); ++i)
+        {
+            for (bandcount_t b=0; b<bands; ++b)
+            {
+                mergeLineStats(totals[buckets[s][i] * bands + b], partials[s][i * bands + b]);
             }
         }
+    }
 
-        // store
-        intermediate_sum[y] = lineSum;
-        intermediate_ssq[y] = lineSumSq;
-        intermediate_min[y] = lineMin;
-        intermediate_max[y] = lineMax;
+    vector<bandstats_t> stats(regions.size());
+    for (size_t r=0; r<regions.size(); ++r)
+    {
+        for (bandcount_t b=0; b<bands; ++b)
+        {
+            const LineStats& total = totals[r * bands + b];
+            stats[r].push_back(shared_ptr<Stats>(new Stats(finalizeStats(total.count, total.mean, total.m2, total.min, total.max))));
+        }
     }
 
-    // conquer intermediate results
-    for(linecount_t y=0; y<lines; ++y)
+    // up, up and away
+    return stats;
+}
+
+/// <summary>
+/// Calculates the statistics of each square block of the image in a single parallel pass; Rows of blocks are processed in parallel.
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="block_size">The width and height of a block.</param>
+/// <returns>The block statistics.</returns>
+statsgrid_t Application::calculateBlockStatistics(const ImageView& image, const samplecount_t& block_size) const
+{
+    assert(block_size > 0);
+
+    const samplecount_t samples = image.samples;
+    const linecount_t lines = image.lines;
+    const bandcount_t bands = image.bands;
+    const size_t step = image.sample_stride;
+
+    statsgrid_t grid(new StatsGrid(samples, lines, bands, block_size));
+    const samplecount_t blocks_x = grid->samples;
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_rows = grid->lines;
+
+    #pragma omp parallel for
+    for (omp_linecount_t row=0; row<omp_rows; ++row)
     {
-        // update minimum
-        stats_t& lineMin = intermediate_min[y];
-        if (lineMin < min) {
-            min = lineMin;
+        // partial statistics of each block of the row, band by band
+        vector<LineStats> blocks(static_cast<size_t>(blocks_x) * bands);
+        for (size_t i=0; i<blocks.size(); ++i)
+        {
+            clearLineStats(blocks[i]);
         }
 
-        // update maximum
-        stats_t& lineMax = intermediate_max[y];
-        if (lineMax > max) {
-            max = lineMax;
+        const linecount_t y_first = static_cast<linecount_t>(row) * block_size;
+        const linecount_t y_end = min<linecount_t>(y_first + block_size, lines);
+
+        // line by line, so that the image is streamed through once
+        for (linecount_t y=y_first; y<y_end; ++y)
+        {
+            for (bandcount_t b=0; b<bands; ++b)
+            {
+                const sample_t* line = image.line(y, b);
+                for (samplecount_t bx=0; bx<blocks_x; ++bx)
+                {
+                    const samplecount_t x_first = bx * block_size;
+                    const samplecount_t block_samples = min<samplecount_t>(block_size, samples - x_first);
+
+                    LineStats line_stats;
+                    accumulateBandLine(line + x_first * step, step, block_samples, line_stats);
+                    mergeLineStats(blocks[bx * bands + b], line_stats);
+                }
+            }
         }
 
-        // update mean
-        sum += intermediate_sum[y];
-        squareSum += intermediate_ssq[y];
+        // one sample per block in each raster
+        for (bandcount_t b=0; b<bands; ++b)
+        {
+            sample_t* min_line  = grid->min->line(row, b);
+            sample_t* max_line  = grid->max->line(row, b);
+            sample_t* mean_line = grid->mean->line(row, b);
+            sample_t* std_line  = grid->standard_deviation->line(row, b);
+
+            for (samplecount_t bx=0; bx<blocks_x; ++bx)
+            {
+                const LineStats& block = blocks[bx * bands + b];
+                const Stats stats = finalizeStats(block.count, block.mean, block.m2, block.min, block.max);
+
+                min_line[bx]  = stats.min;
+                max_line[bx]  = stats.max;
+                mean_line[bx] = stats.mean;
+                std_line[bx]  = stats.standard_deviation;
+            }
+        }
     }
 
-    // augment
-    mean = sum / count;
-    variance = (squareSum - (mean*sum))/(count-1);
-
-    // and finalize
-    stdDev = sqrt(variance);
+    return grid;
+}
 
-    // up, up and away
-    return shared_ptr<Stats>(new Stats(min, max, mean, stdDev));
+/// <summary>
+/// Looks up the statistics of all bands in the cache; If they are missing, they are calculated in a single pass and stored.
+/// </summary>
+/// <param name="cache">The cache of the image.</param>
+/// <param name="key">The key of the statistics.</param>
+/// <param name="image">The image or image region.</param>
+/// <param name="cached">true if the statistics were taken from the cache.</param>
+/// <returns>The statistics, one per band.</returns>
+bandstats_t Application::cachedStatistics(StatsCache& cache, const string& key, const ImageView& image, out bool& cached) const
+{
+    bandstats_t stats;
+    cached = cache.findStats(key, out stats) && stats.size() == image.bands;
+    if (!cached)
+    {
+        stats = calculateBandStatistics(image);
+        cache.storeStats(key, stats);
+    }
+    return stats;
 }
+
+/// <summary>
+/// Calculates the statistics and the histogram of all bands of a file in a single pass over its strips;
+/// Only one strip is held in memory at a time.
+/// </summary>
+/// <param name="reader">The strip reader of the file.</param>
+/// <param name="low_value">The lower boundary of the first histogram class.</param>
+/// <param name="high_value">The upper boundary of the last histogram class.</param>
+/// <param name="histogram">The histogram classes, band by band (<paramref name="class_count"/> classes per band).</param>
+/// <param name="class_count">The number of histogram classes.</param>
+/// <returns>The statistics, one per band.</returns>
+bandstats_t Application::calculateStreamingStatistics(ENVIStripReader& reader, const stats_t low_value, const stats_t high_value, out unique_ptr<histogram_bin[]>& histogram, const uint_fast8_t class_count) const
+{
+    BandStatsAccumulator stats(reader.bands);
+    HistogramAccumulator classes(reader.bands, low_value, high_value, class_count);
+
+    for (image_t strip = reader.next(); strip; strip = reader.next())
+    {
+        const ImageView block = strip->view();
+        stats.add(block);
+        classes.add(block);
+    }
+
+    histogram = classes.result();
+    return stats.result();
+}
\ No newline at end of file
@@ -1,3 +1,9 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <emmintrin.h>
+
 #include "ENVIFileReader.h"
 
 using namespace std;
@@ -6,11 +12,19 @@ using namespace envi;
 /// <summary>
 /// Initializes a new instance of the <see cref="ENVIFileReader"/> class.
 /// </summary>
-ENVIFileReader::ENVIFileReader(samplecount_t samples, linecount_t lines, bandcount_t bands)
-    : _samples(samples), _lines(lines), _bands(bands)
+ENVIFileReader::ENVIFileReader(samplecount_t samples, linecount_t lines, bandcount_t bands, Interleave interleave, size_t header_offset, ByteOrder byte_order, DataType data_type)
+    : _samples(samples), _lines(lines), _bands(bands), _interleave(interleave), _header_offset(header_offset), _byte_order(byte_order), _data_type(data_type)
 {
 }
 
+/// <summary>
+/// Initializes a new instance of the <see cref="ENVIFileReader"/> class from a parsed header.
+/// </summary>
+/// <param name="header">The ENVI header of the file.</param>
+ENVIFileReader::ENVIFileReader(const ENVIHeader& header)
+    : _samples(header.samples), _lines(header.lines), _bands(header.bands), _interleave(header.interleave), _header_offset(header.header_offset), _byte_order(header.byte_order), _data_type(header.data_type)
+{
+}
 
 /// <summary>
 /// Finalizes an instance of the <see cref="ENVIFileReader"/> class.
@@ -20,31 +34,254 @@ ENVIFileReader::~ENVIFileReader(void)
 }
 
 /// <summary>
-/// Reads the image from the given stream
+/// Reverses the byte order of each value in a vector of 16, 32 or 64 bit values
+/// </summary>
+/// <param name="value">The vector.</param>
+/// <returns>The byte-swapped vector.</returns>
+template <size_t SIZE>
+static inline __m128i swapVector(__m128i value)
+{
+    // reorder the 16 bit words within each value ...
+    if (SIZE == 4)
+    {
+        value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+        value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+    }
+    else if (SIZE == 8)
+    {
+        value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+        value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+    }
+
+    // ... then swap the bytes within each word
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+
+/// <summary>
+/// Reverses the byte order of all given values (in-place)
+/// </summary>
+/// <param name="data">The values.</param>
+/// <param name="count">The number of values.</param>
+template <size_t SIZE>
+static void swapByteOrder(char* data, const size_t& count)
+{
+    static_assert(SIZE == 1 || SIZE == 2 || SIZE == 4 || SIZE == 8, "only 8, 16, 32 and 64 bit values can be byte-swapped");
+    if (SIZE == 1) return;
+
+    const size_t vector_count = count * SIZE / sizeof(__m128i);
+
+    // sixteen bytes at a time ...
+    for (size_t i = 0; i < vector_count; ++i)
+    {
+        __m128i* vector = reinterpret_cast<__m128i*>(data) + i;
+        _mm_storeu_si128(vector, swapVector<SIZE>(_mm_loadu_si128(vector)));
+    }
+
+    // ... and the remaining values one by one
+    for (char* value = data + vector_count * sizeof(__m128i); value < data + count * SIZE; value += SIZE)
+    {
+        reverse(value, value + SIZE);
+    }
+}
+
+/// <summary>
+/// Converts samples of the given type from the file into float samples
+/// </summary>
+/// <param name="source">The samples in the file.</param>
+/// <param name="target">The float samples.</param>
+/// <param name="count">The number of samples.</param>
+/// <param name="swap">Whether the samples in the file need to be byte-swapped.</param>
+template <typename T>
+static void convertSamples(const char* source, sample_t* target, const size_t& count, const bool swap)
+{
+    // the file is processed in blocks small enough to stay in the cache while being swapped and converted
+    const size_t block_size = 4096;
+
+    typedef int_fast64_t omp_blockcount_t; // OpenMP needs signed integral type
+    const omp_blockcount_t omp_blocks = static_cast<omp_blockcount_t>((count + block_size - 1) / block_size);
+
+    #pragma omp parallel for
+    for (omp_blockcount_t block = 0; block < omp_blocks; ++block)
+    {
+        const size_t first = static_cast<size_t>(block) * block_size;
+        const size_t block_count = min(block_size, count - first);
+
+        T values[block_size];
+        memcpy(values, source + first * sizeof(T), block_count * sizeof(T));
+        if (swap) swapByteOrder<sizeof(T)>(reinterpret_cast<char*>(values), block_count);
+
+        sample_t* block_target = target + first;
+        for (size_t i = 0; i < block_count; ++i)
+        {
+            block_target[i] = static_cast<sample_t>(values[i]);
+        }
+    }
+}
+
+/// <summary>
+/// Converts samples from the file into float samples
+/// </summary>
+/// <param name="source">The samples in the file.</param>
+/// <param name="data_type">The type of the samples in the file.</param>
+/// <param name="target">The float samples.</param>
+/// <param name="count">The number of samples.</param>
+/// <param name="swap">Whether the samples in the file need to be byte-swapped.</param>
+static void convertSamples(const char* source, const DataType& data_type, sample_t* target, const size_t& count, const bool swap)
+{
+    switch (data_type)
+    {
+        case UInt8:   convertSamples<uint8_t>(source, target, count, swap); break;
+        case Int16:   convertSamples<int16_t>(source, target, count, swap); break;
+        case UInt16:  convertSamples<uint16_t>(source, target, count, swap); break;
+        case Int32:   convertSamples<int32_t>(source, target, count, swap); break;
+        case Float32: convertSamples<float>(source, target, count, swap); break;
+        case Float64: convertSamples<double>(source, target, count, swap); break;
+        default:      throw runtime_error("unsupported ENVI data type");
+    }
+}
+
+/// <summary>
+/// Determines whether the byte order of the file differs from the one of this machine
+/// </summary>
+/// <returns>true if the samples need to be byte-swapped.</returns>
+bool ENVIFileReader::needsByteSwap() const
+{
+    const uint16_t probe = 1;
+    const ByteOrder host_byte_order = (*reinterpret_cast<const uint8_t*>(&probe) == 1) ? LittleEndian : BigEndian;
+    return _byte_order != host_byte_order;
+}
+
+/// <summary>
+/// Reads consecutive samples from the current position of the stream and converts them to float
 /// </summary>
 /// <param name="stream">The input stream.</param>
-image_t ENVIFileReader::read(istream& stream)
+/// <param name="target">The float samples.</param>
+/// <param name="count">The number of samples.</param>
+void ENVIFileReader::readSamples(istream& stream, sample_t* target, const size_t& count) const
 {
-    // create the line array
-    image_t image = image_t(new line_t[_lines]);
-    if (!image) throw runtime_error("not enough memory to create ENVI line array");
+    static_assert(sizeof(sample_t) == sizeof(float), "sample type must be float");
+    const size_t sample_size = dataTypeSize(_data_type);
+
+    // large scenes are read in chunks, since not every stream implementation handles reads of several GiB at once
+    const size_t chunk_count = (64U << 20) / sample_size;
 
-    // for each line, create the sample array
-    for (linecount_t lineIndex = 0; lineIndex < _lines; ++lineIndex)
+    // float samples are read straight into the target and byte-swapped there
+    if (_data_type == Float32)
     {
-        image[lineIndex].reset(new sample_t[_samples]);
-        if (!image[lineIndex]) throw runtime_error("not enough memory to create ENVI sample array");
+        for (size_t first = 0; first < count && stream.good(); first += chunk_count)
+        {
+            const size_t chunk = min(chunk_count, count - first);
+            stream.read(reinterpret_cast<char*>(target + first), static_cast<streamsize>(chunk * sample_size));
+        }
+
+        if (needsByteSwap())
+        {
+            typedef int_fast64_t omp_chunkcount_t; // OpenMP needs signed integral type
+            const omp_chunkcount_t omp_chunks = static_cast<omp_chunkcount_t>((count + chunk_count - 1) / chunk_count);
+
+            #pragma omp parallel for
+            for (omp_chunkcount_t c = 0; c < omp_chunks; ++c)
+            {
+                const size_t first = static_cast<size_t>(c) * chunk_count;
+                swapByteOrder<sizeof(sample_t)>(reinterpret_cast<char*>(target + first), min(chunk_count, count - first));
+            }
+        }
+        return;
     }
 
-    // read the stream
-    // for each line, create the sample array
-    for (linecount_t lineIndex = 0; lineIndex < _lines; ++lineIndex)
+    // all other types are read chunk by chunk and converted
+    vector<char> buffer(min(count, chunk_count) * sample_size);
+    for (size_t first = 0; first < count && stream.good(); first += chunk_count)
     {
-        sample_t *line = image[lineIndex].get();
-        char* pointer = reinterpret_cast<char*>(line);
+        const size_t chunk = min(chunk_count, count - first);
+        stream.read(buffer.data(), static_cast<streamsize>(chunk * sample_size));
+        convertSamples(buffer.data(), _data_type, target + first, chunk, needsByteSwap());
+    }
+}
 
-        stream.read(pointer, _samples*sizeof(sample_t));
+/// <summary>
+/// Reads the image from the given stream
+/// </summary>
+/// <param name="stream">The input stream, positioned at the beginning of the file.</param>
+/// <returns>The image, in the band order of the file.</returns>
+image_t ENVIFileReader::read(istream& stream)
+{
+    if (dataTypeSize(_data_type) == 0) throw runtime_error("unsupported ENVI data type");
+
+    // create the image
+    image_t image(new Image(_samples, _lines, _bands, _interleave));
+
+    // skip the embedded header
+    stream.ignore(static_cast<streamsize>(_header_offset));
+
+    // the image uses the file's layout, so all values are stored back to back
+    readSamples(stream, image->data(), static_cast<size_t>(_samples) * _lines * _bands);
+
+    if (!stream) throw runtime_error("could not read ENVI image");
+    return image;
+}
+
+/// <summary>
+/// Reads a block of consecutive lines (of all bands) from the given stream
+/// </summary>
+/// <param name="stream">The input stream; Must be seekable.</param>
+/// <param name="first_line">The first line to read.</param>
+/// <param name="line_count">The number of lines to read.</param>
+/// <returns>The lines as an image of <paramref name="line_count"/> lines, in the band order of the file.</returns>
+image_t ENVIFileReader::readLines(istream& stream, const linecount_t& first_line, const linecount_t& line_count)
+{
+    const size_t sample_size = dataTypeSize(_data_type);
+    if (sample_size == 0) throw runtime_error("unsupported ENVI data type");
+    if (first_line + line_count > _lines) throw runtime_error("lines exceed the ENVI image");
+
+    image_t image(new Image(_samples, line_count, _bands, _interleave));
+
+    if (_interleave == BSQ)
+    {
+        // each band is a separate run of lines in the file
+        for (bandcount_t b = 0; b < _bands; ++b)
+        {
+            const size_t first = (static_cast<size_t>(b) * _lines + first_line) * _samples;
+            stream.seekg(static_cast<streamoff>(_header_offset + first * sample_size));
+            readSamples(stream, image->line(0, b), static_cast<size_t>(_samples) * line_count);
+        }
+    }
+    else
+    {
+        // lines interleaved by line or by pixel hold all bands back to back
+        const size_t first = static_cast<size_t>(first_line) * _samples * _bands;
+        stream.seekg(static_cast<streamoff>(_header_offset + first * sample_size));
+        readSamples(stream, image->data(), static_cast<size_t>(_samples) * line_count * _bands);
+    }
+
+    if (!stream) throw runtime_error("could not read lines from ENVI image");
+    return image;
+}
+
+/// <summary>
+/// Maps the given file into memory and uses its samples directly, without copying them.
+/// </summary>
+/// <param name="path">The path of the image file.</param>
+/// <returns>The image, in the band order of the file.</returns>
+image_t ENVIFileReader::map(const string& path)
+{
+    const size_t sample_size = dataTypeSize(_data_type);
+    if (sample_size == 0) throw runtime_error("unsupported ENVI data type");
+
+    shared_ptr<MappedFile> file(new MappedFile(path));
+
+    const size_t count = static_cast<size_t>(_samples) * _lines * _bands;
+    if (_header_offset + count * sample_size > file->size()) throw runtime_error("ENVI image file is too small");
+
+    // zero-copy if the samples can be used as they are
+    const bool aligned = (_header_offset % sizeof(sample_t)) == 0;
+    if (_data_type == Float32 && aligned && !needsByteSwap())
+    {
+        return image_t(new Image(_samples, _lines, _bands, _interleave, file, _header_offset));
     }
 
+    // otherwise convert (and fix) the samples; the mapping is released afterwards
+    image_t image(new Image(_samples, _lines, _bands, _interleave));
+    convertSamples(file->data() + _header_offset, _data_type, image->data(), count, needsByteSwap());
     return image;
 }
\ No newline at end of file
@@ -7,19 +7,15 @@
 #include <exception>
 #include <iostream>
 #include <memory>
+#include <string>
 
-namespace envi {
-
-typedef uint_fast16_t   linecount_t;
-typedef uint_fast16_t   samplecount_t;
-typedef uint_fast8_t    bandcount_t;
+#include "ENVIHeader.h"
+#include "ENVIImage.h"
 
-typedef float                         sample_t;
-typedef std::unique_ptr<sample_t[]>   line_t;
-typedef std::unique_ptr<line_t[]>     image_t;
+namespace envi {
 
 /// <summary>
-/// Reader for band-sequential ENVI HDR files with data type 4, "float"
+/// Reader for ENVI HDR files of data type 1, 2, 3, 4, 5 or 12 in any band order and byte order; All samples are converted to float.
 /// </summary>
 class ENVIFileReader
 {
@@ -27,18 +23,38 @@ private:
     /// <summary>
     /// The number of samples per line
     /// </summary>
-    const linecount_t _samples;
+    const samplecount_t _samples;
 
     /// <summary>
     /// The number of lines per image
     /// </summary>
-    const samplecount_t _lines;
+    const linecount_t _lines;
     
     /// <summary>
     /// The number of bands per sample
     /// </summary>
     const bandcount_t _bands;
 
+    /// <summary>
+    /// The order of the bands in the file
+    /// </summary>
+    const Interleave _interleave;
+
+    /// <summary>
+    /// The number of bytes preceding the image data in the file
+    /// </summary>
+    const size_t _header_offset;
+
+    /// <summary>
+    /// The byte order of the samples in the file
+    /// </summary>
+    const ByteOrder _byte_order;
+
+    /// <summary>
+    /// The type of the samples in the file
+    /// </summary>
+    const DataType _data_type;
+
 public:
     /// <summary>
     /// Initializes a new instance of the <see cref="ENVIFileReader"/> class.
@@ -46,7 +62,17 @@ public:
     /// <param name="samples">The number of samples.</param>
     /// <param name="lines">The number of lines.</param>
     /// <param name="bands">The number of bands.</param>
-    ENVIFileReader(samplecount_t samples, linecount_t lines, bandcount_t bands);
+    /// <param name="interleave">The order of the bands in the file.</param>
+    /// <param name="header_offset">The number of bytes preceding the image data in the file.</param>
+    /// <param name="byte_order">The byte order of the samples in the file.</param>
+    /// <param name="data_type">The type of the samples in the file.</param>
+    ENVIFileReader(samplecount_t samples, linecount_t lines, bandcount_t bands, Interleave interleave = BSQ, size_t header_offset = 0, ByteOrder byte_order = LittleEndian, DataType data_type = Float32);
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ENVIFileReader"/> class from a parsed header.
+    /// </summary>
+    /// <param name="header">The ENVI header of the file.</param>
+    explicit ENVIFileReader(const ENVIHeader& header);
     
     /// <summary>
     /// Finalizes an instance of the <see cref="ENVIFileReader"/> class.
@@ -56,8 +82,41 @@ public:
     /// <summary>
     /// Reads the image from the given stream
     /// </summary>
-    /// <param name="stream">The input stream.</param>
+    /// <param name="stream">The input stream, positioned at the beginning of the file.</param>
+    /// <returns>The image, in the band order of the file.</returns>
     image_t read(std::istream& stream) throw(std::runtime_error);
+
+    /// <summary>
+    /// Reads a block of consecutive lines (of all bands) from the given stream
+    /// </summary>
+    /// <param name="stream">The input stream; Must be seekable.</param>
+    /// <param name="first_line">The first line to read.</param>
+    /// <param name="line_count">The number of lines to read.</param>
+    /// <returns>The lines as an image of <paramref name="line_count"/> lines, in the band order of the file.</returns>
+    image_t readLines(std::istream& stream, const linecount_t& first_line, const linecount_t& line_count) throw(std::runtime_error);
+
+    /// <summary>
+    /// Maps the given file into memory and uses its samples directly, without copying them.
+    /// The samples are only copied if they are not float, need to be byte-swapped or are not aligned within the file.
+    /// </summary>
+    /// <param name="path">The path of the image file.</param>
+    /// <returns>The image, in the band order of the file.</returns>
+    image_t map(const std::string& path) throw(std::runtime_error);
+
+private:
+    /// <summary>
+    /// Determines whether the byte order of the file differs from the one of this machine
+    /// </summary>
+    /// <returns>true if the samples need to be byte-swapped.</returns>
+    bool needsByteSwap() const;
+
+    /// <summary>
+    /// Reads consecutive samples from the current position of the stream and converts them to float
+    /// </summary>
+    /// <param name="stream">The input stream.</param>
+    /// <param name="target">The float samples.</param>
+    /// <param name="count">The number of samples.</param>
+    void readSamples(std::istream& stream, sample_t* target, const size_t& count) const;
 };
 
 }
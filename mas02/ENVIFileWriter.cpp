@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "ENVIFileWriter.h"
+
+using namespace std;
+using namespace envi;
+
+/// <summary>
+/// Initializes a new instance of the <see cref="ENVIFileWriter"/> class.
+/// </summary>
+/// <param name="parallel">If true, strips of the file are gathered and written concurrently.</param>
+ENVIFileWriter::ENVIFileWriter(const bool parallel)
+    : _parallel(parallel)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="ENVIFileWriter"/> class.
+/// </summary>
+ENVIFileWriter::~ENVIFileWriter(void)
+{
+}
+
+/// <summary>
+/// Gets a record of the file, i.e. a run of samples that is contiguous in the file:
+/// a line of a band for BSQ and BIL, a line of pixels for BIP.
+/// </summary>
+/// <param name="image">The image region.</param>
+/// <param name="record">The index of the record in the file.</param>
+/// <returns>The first sample of the record.</returns>
+static inline const sample_t* record(const ImageView& image, const size_t& record)
+{
+    switch (image.interleave)
+    {
+        case BSQ: return image.line(record % image.lines, static_cast<bandcount_t>(record / image.lines));
+        case BIL: return image.line(record / image.bands, static_cast<bandcount_t>(record % image.bands));
+        default:  return image.line(record);
+    }
+}
+
+/// <summary>
+/// Copies consecutive records of the file into a contiguous buffer
+/// </summary>
+/// <param name="image">The image region.</param>
+/// <param name="first">The first record.</param>
+/// <param name="count">The number of records.</param>
+/// <param name="record_size">The size of a record in bytes.</param>
+/// <param name="target">The buffer.</param>
+static inline void gatherRecords(const ImageView& image, const size_t& first, const size_t& count, const size_t& record_size, char* target)
+{
+    // single bands selected from a pixel-interleaved image are the only regions with gaps between their samples
+    const bool contiguous = image.sample_stride == (image.interleave == BIP ? image.bands : 1);
+
+    for (size_t r = first; r < first + count; ++r)
+    {
+        char* record_target = target + (r - first) * record_size;
+        if (contiguous)
+        {
+            memcpy(record_target, record(image, r), record_size);
+            continue;
+        }
+
+        const sample_t* source = record(image, r);
+        sample_t* samples = reinterpret_cast<sample_t*>(record_target);
+        for (samplecount_t x = 0; x < image.samples; ++x)
+        {
+            samples[x] = source[x * image.sample_stride];
+        }
+    }
+}
+
+/// <summary>
+/// Writes an image region to <paramref name="base_path"/>.img and its header to <paramref name="base_path"/>.hdr
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="base_path">The path of both files without extension.</param>
+void ENVIFileWriter::write(const ImageView& image, const string& base_path) const
+{
+    const uint16_t probe = 1;
+    const ByteOrder host_byte_order = (*reinterpret_cast<const uint8_t*>(&probe) == 1) ? LittleEndian : BigEndian;
+
+    ENVIHeader(image.samples, image.lines, image.bands, 0, Float32, image.interleave, host_byte_order).save(base_path + ".hdr");
+
+    // records are gathered into strips of about 4 MiB, which are written as a whole
+    const size_t record_size = static_cast<size_t>(image.samples) * (image.interleave == BIP ? image.bands : 1) * sizeof(sample_t);
+    const size_t records = static_cast<size_t>(image.lines) * (image.interleave == BIP ? 1 : image.bands);
+    const size_t strip_records = max<size_t>(1, (4U << 20) / record_size);
+    const size_t strips = (records + strip_records - 1) / strip_records;
+
+    const string path = base_path + ".img";
+    ofstream file(path, ios_base::binary | ios_base::trunc);
+    if (!file.is_open()) throw runtime_error("Could not open ENVI image file for writing");
+
+    if (!_parallel)
+    {
+        vector<char> buffer(min(strip_records, records) * record_size);
+        for (size_t first = 0; first < records; first += strip_records)
+        {
+            const size_t count = min(strip_records, records - first);
+            gatherRecords(image, first, count, record_size, buffer.data());
+            file.write(buffer.data(), static_cast<streamsize>(count * record_size));
+        }
+
+        if (!file) throw runtime_error("Could not write ENVI image file");
+        return;
+    }
+
+    // fix the size of the file up front, so that every strip can be written at its own offset
+    if (records > 0)
+    {
+        file.seekp(static_cast<streamoff>(records * record_size - 1));
+        file.put('\0');
+    }
+    file.close();
+    if (!file) throw runtime_error("Could not write ENVI image file");
+
+    typedef int_fast64_t omp_stripcount_t; // OpenMP needs signed integral type
+    const omp_stripcount_t omp_strips = static_cast<omp_stripcount_t>(strips);
+
+    // exceptions must not leave the parallel region, so failures are collected per strip
+    vector<uint8_t> failed(strips, 0);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_stripcount_t s = 0; s < omp_strips; ++s)
+    {
+        const size_t first = static_cast<size_t>(s) * strip_records;
+        const size_t count = min(strip_records, records - first);
+
+        vector<char> buffer(count * record_size);
+        gatherRecords(image, first, count, record_size, buffer.data());
+
+        // opening for input as well keeps the existing contents
+        ofstream part(path, ios_base::in | ios_base::binary);
+        part.seekp(static_cast<streamoff>(first * record_size));
+        part.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+        if (!part) failed[s] = 1;
+    }
+
+    if (find(failed.begin(), failed.end(), 1) != failed.end()) throw runtime_error("Could not write ENVI image file");
+}
\ No newline at end of file
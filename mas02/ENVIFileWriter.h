@@ -0,0 +1,48 @@
+#ifndef _ENVIFILEWRITER_H_
+#define _ENVIFILEWRITER_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <stdexcept>
+#include <string>
+
+#include "ENVIHeader.h"
+#include "ENVIImage.h"
+
+namespace envi {
+
+/// <summary>
+/// Writer for ENVI HDR files of data type 4, "float", in the band order of the written region and the byte order of this machine.
+/// The samples go to a .img file, the generated header to a .hdr file next to it.
+/// </summary>
+class ENVIFileWriter
+{
+private:
+    /// <summary>
+    /// Whether strips of the file are written concurrently
+    /// </summary>
+    const bool _parallel;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ENVIFileWriter"/> class.
+    /// </summary>
+    /// <param name="parallel">If true, strips of the file are gathered and written concurrently.</param>
+    explicit ENVIFileWriter(const bool parallel = false);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="ENVIFileWriter"/> class.
+    /// </summary>
+    ~ENVIFileWriter(void);
+
+    /// <summary>
+    /// Writes an image region to <paramref name="base_path"/>.img and its header to <paramref name="base_path"/>.hdr
+    /// </summary>
+    /// <param name="image">The image or image region.</param>
+    /// <param name="base_path">The path of both files without extension.</param>
+    void write(const ImageView& image, const std::string& base_path) const throw(std::runtime_error);
+};
+
+}
+
+#endif
\ No newline at end of file
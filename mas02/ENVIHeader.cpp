@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "ENVIHeader.h"
+
+using namespace std;
+using namespace envi;
+
+typedef map<string, string> fields_t;
+
+/// <summary>
+/// Removes leading and trailing whitespace
+/// </summary>
+/// <param name="value">The value.</param>
+/// <returns>The trimmed value.</returns>
+static string trim(const string& value)
+{
+    const size_t first = value.find_first_not_of(" \t\r\n");
+    if (first == string::npos) return string();
+
+    const size_t last = value.find_last_not_of(" \t\r\n");
+    return value.substr(first, last - first + 1);
+}
+
+/// <summary>
+/// Converts the value to lower case
+/// </summary>
+/// <param name="value">The value.</param>
+/// <returns>The lower case value.</returns>
+static string toLower(string value)
+{
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        value[i] = static_cast<char>(tolower(static_cast<unsigned char>(value[i])));
+    }
+    return value;
+}
+
+/// <summary>
+/// Gets a field as an unsigned number
+/// </summary>
+/// <param name="fields">The header fields.</param>
+/// <param name="name">The field name.</param>
+/// <param name="required">If true, a missing field is an error.</param>
+/// <param name="fallback">The value of a missing field.</param>
+/// <returns>The value.</returns>
+static uint64_t numberField(const fields_t& fields, const string& name, const bool required, const uint64_t fallback = 0)
+{
+    const fields_t::const_iterator field = fields.find(name);
+    if (field == fields.end())
+    {
+        if (required) throw runtime_error("ENVI header is missing the field \"" + name + "\"");
+        return fallback;
+    }
+
+    const char* text = field->second.c_str();
+    char* end;
+    const uint64_t value = strtoull(text, &end, 10);
+    if (end == text || *end != '\0') throw runtime_error("ENVI header field \"" + name + "\" is not a number");
+
+    return value;
+}
+
+/// <summary>
+/// Parses a header
+/// </summary>
+/// <param name="stream">The header stream.</param>
+/// <returns>The header.</returns>
+ENVIHeader ENVIHeader::parse(istream& stream)
+{
+    string line;
+    if (!getline(stream, line) || trim(line) != "ENVI") throw runtime_error("not an ENVI header");
+
+    // collect all "name = value" fields; values in braces may span several lines
+    fields_t fields;
+    while (getline(stream, line))
+    {
+        const size_t equals = line.find('=');
+        if (equals == string::npos) continue;
+
+        const string name = toLower(trim(line.substr(0, equals)));
+        string value = trim(line.substr(equals + 1));
+
+        if (!value.empty() && value[0] == '{')
+        {
+            while (value.find('}') == string::npos && getline(stream, line))
+            {
+                value += "\n" + line;
+            }
+        }
+
+        fields[name] = value;
+    }
+
+    const uint64_t samples       = numberField(fields, "samples", true);
+    const uint64_t lines         = numberField(fields, "lines", true);
+    const uint64_t bands         = numberField(fields, "bands", true);
+    const uint64_t header_offset = numberField(fields, "header offset", false, 0);
+    const uint64_t data_type     = numberField(fields, "data type", true);
+    const uint64_t byte_order    = numberField(fields, "byte order", false, LittleEndian);
+
+    if (samples == 0 || lines == 0) throw runtime_error("ENVI header describes an empty image");
+    if (bands == 0 || bands > 255) throw runtime_error("unsupported number of bands in ENVI header");
+    if (dataTypeSize(static_cast<DataType>(data_type)) == 0) throw runtime_error("unsupported data type in ENVI header");
+    if (byte_order > BigEndian) throw runtime_error("unsupported byte order in ENVI header");
+
+    Interleave interleave = BSQ;
+    const fields_t::const_iterator interleave_field = fields.find("interleave");
+    if (interleave_field != fields.end())
+    {
+        const string value = toLower(interleave_field->second);
+        if      (value == "bsq") interleave = BSQ;
+        else if (value == "bil") interleave = BIL;
+        else if (value == "bip") interleave = BIP;
+        else throw runtime_error("unsupported interleave in ENVI header");
+    }
+
+    return ENVIHeader(static_cast<samplecount_t>(samples), static_cast<linecount_t>(lines), static_cast<bandcount_t>(bands),
+                      static_cast<size_t>(header_offset), static_cast<DataType>(data_type), interleave, static_cast<ByteOrder>(byte_order));
+}
+
+/// <summary>
+/// Loads a header file
+/// </summary>
+/// <param name="path">The path of the header file.</param>
+/// <returns>The header.</returns>
+ENVIHeader ENVIHeader::load(const string& path)
+{
+    ifstream file;
+    file.open(path, ios_base::in);
+    if (!file.is_open()) throw runtime_error("Could not open ENVI header file");
+
+    return parse(file);
+}
+
+/// <summary>
+/// Writes the header
+/// </summary>
+/// <param name="stream">The header stream.</param>
+void ENVIHeader::write(ostream& stream) const
+{
+    static const char* interleave_names[] = { "bsq", "bil", "bip" };
+
+    stream << "ENVI" << endl
+           << "samples = " << samples << endl
+           << "lines = " << lines << endl
+           << "bands = " << static_cast<int>(bands) << endl
+           << "header offset = " << header_offset << endl
+           << "file type = ENVI Standard" << endl
+           << "data type = " << static_cast<int>(data_type) << endl
+           << "interleave = " << interleave_names[interleave] << endl
+           << "byte order = " << static_cast<int>(byte_order) << endl;
+}
+
+/// <summary>
+/// Saves the header to a file
+/// </summary>
+/// <param name="path">The path of the header file.</param>
+void ENVIHeader::save(const string& path) const
+{
+    ofstream file;
+    file.open(path);
+    if (!file.is_open()) throw runtime_error("Could not open ENVI header file for writing");
+
+    write(file);
+    if (!file) throw runtime_error("Could not write ENVI header file");
+}
+
+/// <summary>
+/// Determines the path of a header file without its .hdr extension
+/// </summary>
+/// <param name="header_path">The path of the header file.</param>
+/// <returns>The path without extension.</returns>
+string ENVIHeader::basePath(const string& header_path)
+{
+    const string extension = ".hdr";
+    string base = header_path;
+    if (base.size() > extension.size() && toLower(base.substr(base.size() - extension.size())) == extension)
+    {
+        base.erase(base.size() - extension.size());
+    }
+    return base;
+}
+
+/// <summary>
+/// Determines the path of the data file belonging to a header file
+/// </summary>
+/// <param name="header_path">The path of the header file.</param>
+/// <returns>The path of the data file.</returns>
+string ENVIHeader::dataFilePath(const string& header_path)
+{
+    const string base = basePath(header_path);
+
+    // prefer the common .img extension, fall back to the bare name
+    const string image_path = base + ".img";
+    ifstream probe(image_path, ios_base::in | ios_base::binary);
+    return probe.is_open() ? image_path : base;
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+#ifndef _ENVIHEADER_H_
+#define _ENVIHEADER_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "ENVIImage.h"
+
+namespace envi {
+
+/// <summary>
+/// The type of the samples in a file, as given by the ENVI header's "data type" field
+/// </summary>
+enum DataType
+{
+    /// <summary>8-bit unsigned integer</summary>
+    UInt8 = 1,
+
+    /// <summary>16-bit signed integer</summary>
+    Int16 = 2,
+
+    /// <summary>32-bit signed integer</summary>
+    Int32 = 3,
+
+    /// <summary>32-bit floating point</summary>
+    Float32 = 4,
+
+    /// <summary>64-bit floating point</summary>
+    Float64 = 5,
+
+    /// <summary>16-bit unsigned integer</summary>
+    UInt16 = 12
+};
+
+/// <summary>
+/// The byte order of the samples in a file, as given by the ENVI header's "byte order" field
+/// </summary>
+enum ByteOrder
+{
+    /// <summary>Least significant byte first (Intel)</summary>
+    LittleEndian = 0,
+
+    /// <summary>Most significant byte first (IEEE, Motorola)</summary>
+    BigEndian = 1
+};
+
+/// <summary>
+/// Gets the size of a sample of the given type in bytes
+/// </summary>
+/// <param name="data_type">The data type.</param>
+/// <returns>The size in bytes.</returns>
+inline size_t dataTypeSize(const DataType& data_type)
+{
+    switch (data_type)
+    {
+        case UInt8:   return 1;
+        case Int16:   return 2;
+        case UInt16:  return 2;
+        case Int32:   return 4;
+        case Float32: return 4;
+        case Float64: return 8;
+        default:      return 0;
+    }
+}
+
+/// <summary>
+/// The contents of an ENVI header (.hdr) file that are needed to read the image data
+/// </summary>
+class ENVIHeader
+{
+public:
+    /// <summary>
+    /// The number of samples per line
+    /// </summary>
+    const samplecount_t samples;
+
+    /// <summary>
+    /// The number of lines
+    /// </summary>
+    const linecount_t lines;
+
+    /// <summary>
+    /// The number of bands
+    /// </summary>
+    const bandcount_t bands;
+
+    /// <summary>
+    /// The number of bytes preceding the image data in the data file
+    /// </summary>
+    const size_t header_offset;
+
+    /// <summary>
+    /// The type of the samples
+    /// </summary>
+    const DataType data_type;
+
+    /// <summary>
+    /// The order of the bands
+    /// </summary>
+    const Interleave interleave;
+
+    /// <summary>
+    /// The byte order of the samples
+    /// </summary>
+    const ByteOrder byte_order;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ENVIHeader"/> class.
+    /// </summary>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="bands">The number of bands.</param>
+    /// <param name="header_offset">The number of bytes preceding the image data.</param>
+    /// <param name="data_type">The type of the samples.</param>
+    /// <param name="interleave">The order of the bands.</param>
+    /// <param name="byte_order">The byte order of the samples.</param>
+    ENVIHeader(const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands, const size_t& header_offset, const DataType& data_type, const Interleave& interleave, const ByteOrder& byte_order)
+        : samples(samples), lines(lines), bands(bands), header_offset(header_offset), data_type(data_type), interleave(interleave), byte_order(byte_order)
+    {}
+
+    /// <summary>
+    /// Parses a header
+    /// </summary>
+    /// <param name="stream">The header stream.</param>
+    /// <returns>The header.</returns>
+    static ENVIHeader parse(std::istream& stream) throw(std::runtime_error);
+
+    /// <summary>
+    /// Loads a header file
+    /// </summary>
+    /// <param name="path">The path of the header file.</param>
+    /// <returns>The header.</returns>
+    static ENVIHeader load(const std::string& path) throw(std::runtime_error);
+
+    /// <summary>
+    /// Writes the header
+    /// </summary>
+    /// <param name="stream">The header stream.</param>
+    void write(std::ostream& stream) const;
+
+    /// <summary>
+    /// Saves the header to a file
+    /// </summary>
+    /// <param name="path">The path of the header file.</param>
+    void save(const std::string& path) const throw(std::runtime_error);
+
+    /// <summary>
+    /// Determines the path of a header file without its .hdr extension
+    /// </summary>
+    /// <param name="header_path">The path of the header file.</param>
+    /// <returns>The path without extension.</returns>
+    static std::string basePath(const std::string& header_path);
+
+    /// <summary>
+    /// Determines the path of the data file belonging to a header file: the header path without its .hdr
+    /// extension, with an .img extension if such a file exists.
+    /// </summary>
+    /// <param name="header_path">The path of the header file.</param>
+    /// <returns>The path of the data file.</returns>
+    static std::string dataFilePath(const std::string& header_path);
+};
+
+}
+
+#endif
\ No newline at end of file
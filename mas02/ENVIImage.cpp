@@ -0,0 +1,165 @@
+#include <cstring>
+#include <limits>
+
+#include "ENVIImage.h"
+
+using namespace std;
+using namespace envi;
+
+/// <summary>
+/// Calculates the number of values of an image in 64 bits; Images that don't fit into the address space of the process are rejected.
+/// </summary>
+/// <param name="samples">The number of samples.</param>
+/// <param name="lines">The number of lines.</param>
+/// <param name="bands">The number of bands.</param>
+/// <returns>The number of values.</returns>
+static uint64_t valueCount(const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands)
+{
+    const uint64_t count = static_cast<uint64_t>(samples) * lines * bands;
+    if (count > numeric_limits<size_t>::max() / sizeof(sample_t)) throw runtime_error("ENVI image is too large for the address space");
+    return count;
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="Image"/> class.
+/// </summary>
+/// <param name="samples">The number of samples.</param>
+/// <param name="lines">The number of lines.</param>
+/// <param name="bands">The number of bands.</param>
+/// <param name="interleave">The order of the bands.</param>
+Image::Image(const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands, const Interleave& interleave)
+    : samples(samples), lines(lines), bands(bands), interleave(interleave)
+{
+    const uint64_t count = valueCount(samples, lines, bands);
+    _data.reset(new sample_t[static_cast<size_t>(count)]);
+    if (!_data) throw runtime_error("not enough memory to create ENVI image");
+    _origin = _data.get();
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="Image"/> class on the samples of a memory-mapped file, without copying them.
+/// </summary>
+/// <param name="samples">The number of samples.</param>
+/// <param name="lines">The number of lines.</param>
+/// <param name="bands">The number of bands.</param>
+/// <param name="interleave">The order of the bands.</param>
+/// <param name="file">The file; The image keeps it mapped.</param>
+/// <param name="offset">The offset of the first sample in bytes; Must be a multiple of the sample size.</param>
+Image::Image(const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands, const Interleave& interleave, const shared_ptr<MappedFile>& file, const size_t& offset)
+    : _file(file), samples(samples), lines(lines), bands(bands), interleave(interleave)
+{
+    assert(offset % sizeof(sample_t) == 0);
+    const uint64_t count = valueCount(samples, lines, bands);
+    if (offset + count * sizeof(sample_t) > file->size()) throw runtime_error("ENVI image exceeds the mapped file");
+
+    _origin = reinterpret_cast<sample_t*>(file->data() + offset);
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="Image"/> class.
+/// </summary>
+Image::~Image()
+{
+    _data.reset();
+    _file.reset();
+}
+
+/// <summary>
+/// Copies a line of a single band into a contiguous line
+/// </summary>
+/// <param name="source">The first sample of the source line.</param>
+/// <param name="source_stride">The distance between two samples of the source line.</param>
+/// <param name="target">The target line.</param>
+/// <param name="samples">The number of samples.</param>
+static inline void gatherLine(const sample_t* source, const size_t& source_stride, sample_t* target, const samplecount_t& samples)
+{
+    if (source_stride == 1)
+    {
+        memcpy(target, source, samples * sizeof(sample_t));
+        return;
+    }
+
+    for (samplecount_t x = 0; x < samples; ++x)
+    {
+        target[x] = source[x * source_stride];
+    }
+}
+
+/// <summary>
+/// Interleaves the lines of all bands into a single line of pixels.
+/// A compile-time band count (three or four bands) lets the compiler unroll the band loop.
+/// </summary>
+/// <param name="source">The source region.</param>
+/// <param name="y">The line.</param>
+/// <param name="target">The target line.</param>
+template <bandcount_t BANDS>
+static inline void interleaveLine(const ImageView& source, const linecount_t& y, sample_t* target)
+{
+    const bandcount_t bands = (BANDS > 0) ? BANDS : source.bands;
+    const size_t source_stride = source.sample_stride;
+    const samplecount_t samples = source.samples;
+
+    const sample_t* lines[BANDS > 0 ? BANDS : 256];
+    for (bandcount_t b = 0; b < bands; ++b)
+    {
+        lines[b] = source.line(y, b);
+    }
+
+    for (samplecount_t x = 0; x < samples; ++x)
+    {
+        sample_t* pixel = target + x * bands;
+        for (bandcount_t b = 0; b < bands; ++b)
+        {
+            pixel[b] = lines[b][x * source_stride];
+        }
+    }
+}
+
+/// <summary>
+/// Copies an image region into a new image with the given band order
+/// </summary>
+/// <param name="source">The image region.</param>
+/// <param name="interleave">The band order of the new image.</param>
+/// <returns>The image.</returns>
+image_t Image::copy(const ImageView& source, const Interleave& interleave)
+{
+    const samplecount_t samples = source.samples;
+    const linecount_t lines = source.lines;
+    const bandcount_t bands = source.bands;
+
+    image_t target(new Image(samples, lines, bands, interleave));
+
+    // whole lines of pixels can be copied at once if both sides interleave by pixel
+    const bool pixel_copy = (interleave == BIP) && (source.interleave == BIP) && (source.sample_stride == bands);
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
+    {
+        if (pixel_copy)
+        {
+            memcpy(target->line(y), source.line(y), static_cast<size_t>(samples) * bands * sizeof(sample_t));
+        }
+        else if (interleave == BIP)
+        {
+            switch (bands)
+            {
+                case 3:  interleaveLine<3>(source, y, target->line(y)); break;
+                case 4:  interleaveLine<4>(source, y, target->line(y)); break;
+                default: interleaveLine<0>(source, y, target->line(y)); break;
+            }
+        }
+        else
+        {
+            // band sequential and band interleaved by line both store contiguous band lines
+            for (bandcount_t b = 0; b < bands; ++b)
+            {
+                gatherLine(source.line(y, b), source.sample_stride, target->line(y, b), samples);
+            }
+        }
+    }
+
+    return target;
+}
\ No newline at end of file
@@ -0,0 +1,387 @@
+#ifndef _ENVIIMAGE_H_
+#define _ENVIIMAGE_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include "MappedFile.h"
+
+namespace envi {
+
+typedef uint_fast64_t   linecount_t;
+typedef uint_fast64_t   samplecount_t;
+typedef uint_fast8_t    bandcount_t;
+
+typedef float                         sample_t;
+typedef std::unique_ptr<sample_t[]>   imagedata_t;
+
+/// <summary>
+/// The order in which the bands of an image are stored
+/// </summary>
+enum Interleave
+{
+    /// <summary>Band sequential: all lines of the first band, then all lines of the next band</summary>
+    BSQ,
+
+    /// <summary>Band interleaved by line: each line holds the first band's samples, then the next band's samples</summary>
+    BIL,
+
+    /// <summary>Band interleaved by pixel: each sample holds all of its bands back to back</summary>
+    BIP
+};
+
+class Image;
+
+/// <summary>
+/// Non-owning, read-only view of a rectangular region of an <see cref="Image"/>.
+/// The view does not extend the lifetime of its parent image; It must not outlive it.
+/// </summary>
+class ImageView
+{
+private:
+    /// <summary>
+    /// The first sample of the region
+    /// </summary>
+    const sample_t* _origin;
+
+    /// <summary>
+    /// The image the region belongs to
+    /// </summary>
+    const Image* _parent;
+
+public:
+    /// <summary>
+    /// The number of samples per line
+    /// </summary>
+    const samplecount_t samples;
+
+    /// <summary>
+    /// The number of lines
+    /// </summary>
+    const linecount_t lines;
+
+    /// <summary>
+    /// The number of bands per sample
+    /// </summary>
+    const bandcount_t bands;
+
+    /// <summary>
+    /// The distance between two consecutive lines in values
+    /// </summary>
+    const size_t stride;
+
+    /// <summary>
+    /// The distance between two consecutive bands in values
+    /// </summary>
+    const size_t band_stride;
+
+    /// <summary>
+    /// The distance between two consecutive samples of a band in values; One unless the bands are interleaved by pixel
+    /// </summary>
+    const bandcount_t sample_stride;
+
+    /// <summary>
+    /// The order of the bands
+    /// </summary>
+    const Interleave interleave;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ImageView"/> class.
+    /// </summary>
+    /// <param name="parent">The image the region belongs to.</param>
+    /// <param name="origin">The first sample of the region.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="bands">The number of bands.</param>
+    /// <param name="stride">The line stride in values.</param>
+    /// <param name="band_stride">The band stride in values.</param>
+    /// <param name="interleave">The order of the bands.</param>
+    ImageView(const Image* parent, const sample_t* origin, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands, const size_t& stride, const size_t& band_stride, const Interleave& interleave)
+        : _origin(origin), _parent(parent), samples(samples), lines(lines), bands(bands), stride(stride), band_stride(band_stride),
+          sample_stride(interleave == BIP ? bands : 1), interleave(interleave)
+    {}
+
+    /// <summary>
+    /// Gets the image the region belongs to
+    /// </summary>
+    /// <returns>The parent image.</returns>
+    inline const Image& parent() const
+    {
+        return *_parent;
+    }
+
+    /// <summary>
+    /// Gets the given line of the region
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>Pointer to the first sample of the line within the region.</returns>
+    inline const sample_t* line(const linecount_t& line) const
+    {
+        return _origin + line * stride;
+    }
+
+    /// <summary>
+    /// Gets the given line of a band of the region; Consecutive samples are <see cref="sample_stride"/> values apart.
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>Pointer to the first sample of the line within the region.</returns>
+    inline const sample_t* line(const linecount_t& line, const bandcount_t& band) const
+    {
+        return _origin + line * stride + band * band_stride;
+    }
+
+    /// <summary>
+    /// Gets the sample at the given position
+    /// </summary>
+    /// <param name="sample">The sample.</param>
+    /// <param name="line">The line.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>The sample.</returns>
+    inline const sample_t& sample(const samplecount_t& sample, const linecount_t& line, const bandcount_t& band = 0) const
+    {
+        return _origin[line * stride + band * band_stride + sample * sample_stride];
+    }
+
+    /// <summary>
+    /// Gets the given line of the region
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>Pointer to the first sample of the line within the region.</returns>
+    inline const sample_t* operator[](const linecount_t& line) const
+    {
+        return this->line(line);
+    }
+
+    /// <summary>
+    /// Gets a view of a region within this region
+    /// </summary>
+    /// <param name="sample_first">The first sample, relative to this region.</param>
+    /// <param name="line_first">The first line, relative to this region.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>The view.</returns>
+    inline ImageView view(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines) const
+    {
+        assert(sample_first + samples <= this->samples);
+        assert(line_first + lines <= this->lines);
+        return ImageView(_parent, _origin + line_first * stride + sample_first * sample_stride, samples, lines, bands, stride, band_stride, interleave, sample_stride);
+    }
+
+    /// <summary>
+    /// Gets a single-band view of the given band of the region
+    /// </summary>
+    /// <param name="band">The band.</param>
+    /// <returns>The view.</returns>
+    inline ImageView band(const bandcount_t& band) const
+    {
+        assert(band < bands);
+        return ImageView(_parent, _origin + band * band_stride, samples, lines, 1, stride, band_stride, interleave, sample_stride);
+    }
+
+private:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ImageView"/> class with an explicit sample stride.
+    /// </summary>
+    ImageView(const Image* parent, const sample_t* origin, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands, const size_t& stride, const size_t& band_stride, const Interleave& interleave, const bandcount_t& sample_stride)
+        : _origin(origin), _parent(parent), samples(samples), lines(lines), bands(bands), stride(stride), band_stride(band_stride),
+          sample_stride(sample_stride), interleave(interleave)
+    {}
+};
+
+/// <summary>
+/// Multi-band image with all lines of all bands in a single allocation, stored in the given band order.
+/// The samples are either owned by the image or taken directly from a memory-mapped file.
+/// </summary>
+class Image
+{
+private:
+    /// <summary>
+    /// The image data, unless the image is mapped
+    /// </summary>
+    imagedata_t _data;
+
+    /// <summary>
+    /// The file the image is mapped from, if any
+    /// </summary>
+    std::shared_ptr<MappedFile> _file;
+
+    /// <summary>
+    /// The first sample
+    /// </summary>
+    sample_t* _origin;
+
+public:
+    /// <summary>
+    /// The number of samples per line
+    /// </summary>
+    const samplecount_t samples;
+
+    /// <summary>
+    /// The number of lines
+    /// </summary>
+    const linecount_t lines;
+
+    /// <summary>
+    /// The number of bands per sample
+    /// </summary>
+    const bandcount_t bands;
+
+    /// <summary>
+    /// The order of the bands
+    /// </summary>
+    const Interleave interleave;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="Image"/> class.
+    /// </summary>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="bands">The number of bands.</param>
+    /// <param name="interleave">The order of the bands.</param>
+    Image(const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands, const Interleave& interleave = BSQ) throw(std::runtime_error);
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="Image"/> class on the samples of a memory-mapped file, without copying them.
+    /// </summary>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="bands">The number of bands.</param>
+    /// <param name="interleave">The order of the bands.</param>
+    /// <param name="file">The file; The image keeps it mapped.</param>
+    /// <param name="offset">The offset of the first sample in bytes; Must be a multiple of the sample size.</param>
+    Image(const samplecount_t& samples, const linecount_t& lines, const bandcount_t& bands, const Interleave& interleave, const std::shared_ptr<MappedFile>& file, const size_t& offset) throw(std::runtime_error);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="Image"/> class.
+    /// </summary>
+    ~Image();
+
+    /// <summary>
+    /// Gets a pointer to the first sample
+    /// </summary>
+    /// <returns>sample_t *.</returns>
+    inline sample_t* data() const
+    {
+        return _origin;
+    }
+
+    /// <summary>
+    /// Determines whether the samples are taken directly from a memory-mapped file
+    /// </summary>
+    /// <returns>true if mapped.</returns>
+    inline bool mapped() const
+    {
+        return static_cast<bool>(_file);
+    }
+
+    /// <summary>
+    /// Gets the given line
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>Pointer to the first sample of the line.</returns>
+    inline sample_t* line(const linecount_t& line) const
+    {
+        return _origin + line * stride();
+    }
+
+    /// <summary>
+    /// Gets the given line of a band; Consecutive samples are one value apart, or <see cref="bands"/> values if the bands are interleaved by pixel.
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>Pointer to the first sample of the line.</returns>
+    inline sample_t* line(const linecount_t& line, const bandcount_t& band) const
+    {
+        return _origin + line * stride() + band * bandStride();
+    }
+
+    /// <summary>
+    /// Gets the distance between two consecutive lines in values
+    /// </summary>
+    /// <returns>The stride.</returns>
+    inline size_t stride() const
+    {
+        return (interleave == BSQ) ? samples : static_cast<size_t>(samples) * bands;
+    }
+
+    /// <summary>
+    /// Gets the distance between two consecutive bands in values
+    /// </summary>
+    /// <returns>The stride.</returns>
+    inline size_t bandStride() const
+    {
+        switch (interleave)
+        {
+            case BSQ: return static_cast<size_t>(samples) * lines;
+            case BIL: return samples;
+            default:  return 1;
+        }
+    }
+
+    /// <summary>
+    /// Gets the given line
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>Pointer to the first sample of the line.</returns>
+    inline sample_t* operator[](const linecount_t& line) const
+    {
+        return this->line(line);
+    }
+
+    /// <summary>
+    /// Gets a view of the whole image
+    /// </summary>
+    /// <returns>The view.</returns>
+    inline ImageView view() const
+    {
+        return ImageView(this, _origin, samples, lines, bands, stride(), bandStride(), interleave);
+    }
+
+    /// <summary>
+    /// Gets a view of a region of the image
+    /// </summary>
+    /// <param name="sample_first">The first sample.</param>
+    /// <param name="line_first">The first line.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>The view.</returns>
+    inline ImageView view(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines) const
+    {
+        return view().view(sample_first, line_first, samples, lines);
+    }
+
+    /// <summary>
+    /// Copies the image into a new image with the given band order
+    /// </summary>
+    /// <param name="interleave">The band order of the new image.</param>
+    /// <returns>The image.</returns>
+    inline std::unique_ptr<Image> convert(const Interleave& interleave) const
+    {
+        return copy(view(), interleave);
+    }
+
+    /// <summary>
+    /// Copies an image region into a new image with the given band order
+    /// </summary>
+    /// <param name="source">The image region.</param>
+    /// <param name="interleave">The band order of the new image.</param>
+    /// <returns>The image.</returns>
+    static std::unique_ptr<Image> copy(const ImageView& source, const Interleave& interleave);
+
+private:
+    Image(const Image&);
+    Image& operator=(const Image&);
+};
+
+typedef std::unique_ptr<Image> image_t;
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include <algorithm>
+
+#include "ENVIStripReader.h"
+
+using namespace std;
+using namespace envi;
+
+/// <summary>
+/// Initializes a new instance of the <see cref="ENVIStripReader"/> class.
+/// </summary>
+/// <param name="header">The ENVI header of the file.</param>
+/// <param name="path">The path of the image file.</param>
+/// <param name="strip_lines">The number of lines per strip.</param>
+/// <param name="prefetch">If true, the next strip is read in the background while the current one is processed.</param>
+ENVIStripReader::ENVIStripReader(const ENVIHeader& header, const string& path, const linecount_t& strip_lines, const bool prefetch)
+    : _reader(header), _next_line(0), _prefetch(prefetch), lines(header.lines), bands(header.bands), strip_lines(max<linecount_t>(strip_lines, 1))
+{
+    _stream.open(path, ios_base::in | ios_base::binary);
+    if (!_stream.is_open()) throw runtime_error("Could not open ENVI image file");
+
+    // start reading the first strip right away
+    if (_prefetch && lines > 0)
+    {
+        _pending = async(launch::async, &ENVIStripReader::readStrip, this, _next_line);
+    }
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="ENVIStripReader"/> class; Waits for a strip still being read.
+/// </summary>
+ENVIStripReader::~ENVIStripReader()
+{
+    if (_pending.valid()) _pending.wait();
+}
+
+/// <summary>
+/// Reads the strip starting at the given line
+/// </summary>
+/// <param name="first_line">The first line of the strip.</param>
+/// <returns>The strip.</returns>
+image_t ENVIStripReader::readStrip(const linecount_t first_line)
+{
+    const linecount_t line_count = min(strip_lines, lines - first_line);
+    return _reader.readLines(_stream, first_line, line_count);
+}
+
+/// <summary>
+/// Reads the next strip
+/// </summary>
+/// <returns>The strip, or an empty pointer if all lines have been read.</returns>
+image_t ENVIStripReader::next()
+{
+    if (_next_line >= lines) return image_t();
+
+    // take the prefetched strip, if any; only one read is in flight at a time, so the stream is never shared
+    image_t strip = _pending.valid() ? _pending.get() : readStrip(_next_line);
+    _next_line += strip->lines;
+
+    // and read the following one while the caller works on this one
+    if (_prefetch && _next_line < lines)
+    {
+        _pending = async(launch::async, &ENVIStripReader::readStrip, this, _next_line);
+    }
+
+    return strip;
+}
+
+/// <summary>
+/// Determines the number of lines per strip such that two strips (as float samples), the current and the prefetched one, fit the given memory budget
+/// </summary>
+/// <param name="header">The ENVI header of the file.</param>
+/// <param name="budget">The memory budget in bytes.</param>
+/// <returns>The number of lines; At least one.</returns>
+linecount_t ENVIStripReader::linesForBudget(const ENVIHeader& header, const size_t& budget)
+{
+    // the budget covers both float strips; files of other types additionally use a conversion buffer of at most 64 MiB
+    const size_t line_size = static_cast<size_t>(header.samples) * header.bands * sizeof(sample_t);
+    return max<linecount_t>(budget / (2 * line_size), 1);
+}
\ No newline at end of file
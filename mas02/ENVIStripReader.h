@@ -0,0 +1,120 @@
+#ifndef _ENVISTRIPREADER_H_
+#define _ENVISTRIPREADER_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <string>
+
+#include "ENVIFileReader.h"
+#include "ENVIHeader.h"
+#include "ENVIImage.h"
+
+namespace envi {
+
+/// <summary>
+/// Reads an ENVI file as a sequence of strips of consecutive lines, so that scenes larger than
+/// the available memory can be processed in a single pass. While the caller processes one strip,
+/// the next one is read in the background, so at most two strips are held at a time.
+/// </summary>
+class ENVIStripReader
+{
+private:
+    /// <summary>
+    /// The image file
+    /// </summary>
+    std::ifstream _stream;
+
+    /// <summary>
+    /// The reader for the file's layout
+    /// </summary>
+    ENVIFileReader _reader;
+
+    /// <summary>
+    /// The first line of the next strip
+    /// </summary>
+    linecount_t _next_line;
+
+    /// <summary>
+    /// Whether the next strip is read in the background
+    /// </summary>
+    const bool _prefetch;
+
+    /// <summary>
+    /// The strip being read in the background
+    /// </summary>
+    std::future<image_t> _pending;
+
+public:
+    /// <summary>
+    /// The number of lines of the whole image
+    /// </summary>
+    const linecount_t lines;
+
+    /// <summary>
+    /// The number of bands
+    /// </summary>
+    const bandcount_t bands;
+
+    /// <summary>
+    /// The number of lines per strip; The last strip may be shorter.
+    /// </summary>
+    const linecount_t strip_lines;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ENVIStripReader"/> class.
+    /// </summary>
+    /// <param name="header">The ENVI header of the file.</param>
+    /// <param name="path">The path of the image file.</param>
+    /// <param name="strip_lines">The number of lines per strip.</param>
+    /// <param name="prefetch">If true, the next strip is read in the background while the current one is processed.</param>
+    ENVIStripReader(const ENVIHeader& header, const std::string& path, const linecount_t& strip_lines, const bool prefetch = true) throw(std::runtime_error);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="ENVIStripReader"/> class; Waits for a strip still being read.
+    /// </summary>
+    ~ENVIStripReader();
+
+    /// <summary>
+    /// Reads the next strip
+    /// </summary>
+    /// <returns>The strip, or an empty pointer if all lines have been read.</returns>
+    image_t next() throw(std::runtime_error);
+
+    /// <summary>
+    /// Gets the first line of the next strip
+    /// </summary>
+    /// <returns>The line.</returns>
+    inline linecount_t position() const
+    {
+        return _next_line;
+    }
+
+    /// <summary>
+    /// Determines the number of lines per strip such that two strips (as float samples), the current and the prefetched one, fit the given memory budget
+    /// </summary>
+    /// <param name="header">The ENVI header of the file.</param>
+    /// <param name="budget">The memory budget in bytes.</param>
+    /// <returns>The number of lines; At least one.</returns>
+    static linecount_t linesForBudget(const ENVIHeader& header, const size_t& budget);
+
+private:
+    /// <summary>
+    /// Reads the strip starting at the given line
+    /// </summary>
+    /// <param name="first_line">The first line of the strip.</param>
+    /// <returns>The strip.</returns>
+    image_t readStrip(const linecount_t first_line);
+
+
+private:
+    ENVIStripReader(const ENVIStripReader&);
+    ENVIStripReader& operator=(const ENVIStripReader&);
+};
+
+}
+
+#endif
\ No newline at end of file
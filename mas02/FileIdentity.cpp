@@ -0,0 +1,120 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "FileIdentity.h"
+
+using namespace std;
+
+/// <summary>
+/// Determines the identity of a file
+/// </summary>
+/// <param name="path">The path of the file.</param>
+/// <returns>The identity.</returns>
+FileIdentity FileIdentity::of(const string& path)
+{
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(path.c_str(), &info) != 0) throw runtime_error("Could not determine the identity of the file");
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) throw runtime_error("Could not determine the identity of the file");
+#endif
+
+    FileIdentity identity;
+    identity.path = path;
+    identity.size = static_cast<uint64_t>(info.st_size);
+    identity.modified = static_cast<int64_t>(info.st_mtime);
+
+    ifstream file(path, ios_base::in | ios_base::binary);
+    if (!file.is_open()) throw runtime_error("Could not open file");
+
+    // hashing a few spread blocks is enough to tell edited files apart without reading all of them
+    const uint64_t block_size = 64U << 10;
+    const uint64_t block_count = 18;
+    vector<char> block(static_cast<size_t>(block_size));
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t i = 0; i < block_count; ++i)
+    {
+        const uint64_t offset = (identity.size > block_size) ? (identity.size - block_size) * i / (block_count - 1) : 0;
+        file.seekg(static_cast<streamoff>(offset));
+        file.read(block.data(), static_cast<streamsize>(min(block_size, identity.size)));
+        if (!file) throw runtime_error("Could not read file");
+
+        const size_t count = static_cast<size_t>(file.gcount());
+        for (size_t k = 0; k < count; ++k)
+        {
+            hash ^= static_cast<uint8_t>(block[k]);
+            hash *= 1099511628211ULL;
+        }
+
+        if (identity.size <= block_size) break;
+    }
+
+    identity.hash = hash;
+    return identity;
+}
+
+/// <summary>
+/// Reads a "name = value" line
+/// </summary>
+/// <param name="stream">The stream.</param>
+/// <param name="name">The expected name.</param>
+/// <returns>The value.</returns>
+static string readField(istream& stream, const string& name)
+{
+    string line;
+    getline(stream, line);
+
+    const string prefix = name + " = ";
+    if (line.compare(0, prefix.size(), prefix) != 0) throw runtime_error("Unexpected field in statistics cache");
+    return line.substr(prefix.size());
+}
+
+/// <summary>
+/// Reads a "name = value" line with a numeric value
+/// </summary>
+/// <param name="stream">The stream.</param>
+/// <param name="name">The expected name.</param>
+/// <returns>The value.</returns>
+template <typename T>
+static T readNumericField(istream& stream, const string& name)
+{
+    istringstream text(readField(stream, name));
+
+    T value;
+    if (!(text >> value) || !(text >> ws).eof()) throw runtime_error("Invalid field in statistics cache");
+    return value;
+}
+
+/// <summary>
+/// Reads an identity written by <see cref="FileIdentity::write"/>
+/// </summary>
+/// <param name="stream">The stream.</param>
+/// <returns>The identity.</returns>
+FileIdentity FileIdentity::read(istream& stream)
+{
+    FileIdentity identity;
+    identity.path     = readField(stream, "path");
+    identity.size     = readNumericField<uint64_t>(stream, "size");
+    identity.modified = readNumericField<int64_t>(stream, "modified");
+    identity.hash     = readNumericField<uint64_t>(stream, "hash");
+    return identity;
+}
+
+/// <summary>
+/// Writes the identity as "name = value" lines
+/// </summary>
+/// <param name="stream">The stream.</param>
+void FileIdentity::write(ostream& stream) const
+{
+    stream << "path = " << path << '\n';
+    stream << "size = " << size << '\n';
+    stream << "modified = " << modified << '\n';
+    stream << "hash = " << hash << '\n';
+}
\ No newline at end of file
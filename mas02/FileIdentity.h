@@ -0,0 +1,60 @@
+#ifndef _FILEIDENTITY_H_
+#define _FILEIDENTITY_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+/// <summary>
+/// Identifies the contents of a file without reading all of it; Files derived from another file (caches, overviews)
+/// store its identity to tell whether they still belong to it.
+/// </summary>
+struct FileIdentity
+{
+    /// <summary>The path of the file, as given; For information only, it is not part of the comparison</summary>
+    std::string path;
+
+    /// <summary>The size of the file in bytes</summary>
+    uint64_t size;
+
+    /// <summary>The time of the last modification, in seconds since the epoch</summary>
+    int64_t modified;
+
+    /// <summary>FNV-1a hash of the first and last 64 KiB of the file and of 64 KiB blocks spread evenly in between</summary>
+    uint64_t hash;
+
+    /// <summary>
+    /// Determines the identity of a file
+    /// </summary>
+    /// <param name="path">The path of the file.</param>
+    /// <returns>The identity.</returns>
+    static FileIdentity of(const std::string& path) throw(std::runtime_error);
+
+    /// <summary>
+    /// Reads an identity written by <see cref="write"/>
+    /// </summary>
+    /// <param name="stream">The stream.</param>
+    /// <returns>The identity.</returns>
+    static FileIdentity read(std::istream& stream) throw(std::runtime_error);
+
+    /// <summary>
+    /// Writes the identity as "name = value" lines
+    /// </summary>
+    /// <param name="stream">The stream.</param>
+    void write(std::ostream& stream) const;
+
+    /// <summary>
+    /// Determines whether two identities describe the same file contents; The path is ignored, so the same file
+    /// opened from another working directory or through another relative path still matches.
+    /// </summary>
+    inline bool operator==(const FileIdentity& other) const
+    {
+        return size == other.size && modified == other.modified && hash == other.hash;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "ENVIFileReader.h"
+#include "ENVIFileWriter.h"
+#include "ENVIHeader.h"
+#include "FileIdentity.h"
+#include "ImagePyramid.h"
+
+using namespace std;
+using namespace envi;
+
+/// <summary>The first line of every overview identity file; The version changes whenever its layout does</summary>
+static const string overview_signature = "ENVI overview pyramid, version 1";
+
+/// <summary>
+/// Determines the path of the file holding the identity of the image the overview files were built from
+/// </summary>
+/// <param name="header_path">The path of the ENVI header file of the image.</param>
+/// <returns>The path.</returns>
+static string identityPath(const string& header_path)
+{
+    return ENVIHeader::basePath(header_path) + ".ovr";
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="ImagePyramid"/> class and builds all levels.
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="min_size">Levels are added until neither side of the last level exceeds this number of samples.</param>
+ImagePyramid::ImagePyramid(const ImageView& image, const samplecount_t& min_size)
+    : _base(image)
+{
+    build(min_size);
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="ImagePyramid"/> class from the overview files next to an ENVI file;
+/// If they are missing, don't fit the image or were built from different file contents, all levels are built and the overview files are written.
+/// </summary>
+/// <param name="image">The image.</param>
+/// <param name="header_path">The path of the ENVI header file of the image.</param>
+/// <param name="min_size">Levels are added until neither side of the last level exceeds this number of samples.</param>
+ImagePyramid::ImagePyramid(const ImageView& image, const string& header_path, const samplecount_t& min_size)
+    : _base(image)
+{
+    if (load(header_path, min_size)) return;
+
+    build(min_size);
+    save(header_path);
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="ImagePyramid"/> class.
+/// </summary>
+ImagePyramid::~ImagePyramid(void)
+{
+    _levels.clear();
+}
+
+/// <summary>
+/// Halves the width and height of an image region by averaging 2x2 blocks of samples; An odd last line or sample
+/// is averaged on its own.
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <returns>The reduced image, in the same band order.</returns>
+image_t ImagePyramid::reduce(const ImageView& image)
+{
+    const samplecount_t samples = image.samples;
+    const linecount_t lines = image.lines;
+    const bandcount_t bands = image.bands;
+
+    const samplecount_t new_samples = (samples + 1) / 2;
+    const linecount_t new_lines = (lines + 1) / 2;
+
+    image_t target(new Image(new_samples, new_lines, bands, image.interleave));
+    const size_t source_step = image.sample_stride;
+    const size_t target_step = (image.interleave == BIP) ? bands : 1;
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = new_lines;
+
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
+    {
+        // a missing partner line or sample is replaced by its neighbour, which averages the edge on its own
+        const linecount_t upper_y = 2 * y;
+        const linecount_t lower_y = min<linecount_t>(upper_y + 1, lines - 1);
+
+        for (bandcount_t b = 0; b < bands; ++b)
+        {
+            const sample_t* upper = image.line(upper_y, b);
+            const sample_t* lower = image.line(lower_y, b);
+            sample_t* target_line = target->line(y, b);
+
+            for (samplecount_t x = 0; x < new_samples; ++x)
+            {
+                const size_t left  = 2 * x * source_step;
+                const size_t right = min<samplecount_t>(2 * x + 1, samples - 1) * source_step;
+                target_line[x * target_step] = 0.25F * ((upper[left] + upper[right]) + (lower[left] + lower[right]));
+            }
+        }
+    }
+
+    return target;
+}
+
+/// <summary>
+/// Builds the reduced levels; The full-resolution samples are read only once, each further level is reduced from the previous one.
+/// </summary>
+/// <param name="min_size">Levels are added until neither side of the last level exceeds this number of samples.</param>
+void ImagePyramid::build(const samplecount_t& min_size)
+{
+    const samplecount_t size = max<samplecount_t>(min_size, 1);
+
+    _levels.clear();
+    for (;;)
+    {
+        const ImageView current = level(levels() - 1);
+        if (max<samplecount_t>(current.samples, current.lines) <= size) break;
+
+        _levels.push_back(reduce(current));
+    }
+}
+
+/// <summary>
+/// Maps the reduced levels from the overview files next to an ENVI file
+/// </summary>
+/// <param name="header_path">The path of the ENVI header file of the image.</param>
+/// <param name="min_size">Levels are added until neither side of the last level exceeds this number of samples.</param>
+/// <returns>false if an overview file is missing, doesn't fit the image or was built from different file contents.</returns>
+bool ImagePyramid::load(const string& header_path, const samplecount_t& min_size)
+{
+    const samplecount_t size = max<samplecount_t>(min_size, 1);
+
+    // overviews of an earlier version of the scene may have the same size, so they are tied to the contents of the image file
+    ifstream identity_file(identityPath(header_path), ios_base::in);
+    if (!identity_file.is_open()) return false;
+
+    string signature;
+    getline(identity_file, signature);
+    if (signature != overview_signature) return false;
+
+    try
+    {
+        if (!(FileIdentity::read(identity_file) == FileIdentity::of(ENVIHeader::dataFilePath(header_path)))) return false;
+    }
+    catch (const runtime_error&)
+    {
+        return false;
+    }
+
+    vector<image_t> levels;
+    samplecount_t samples = _base.samples;
+    linecount_t lines = _base.lines;
+
+    for (size_t level = 1; max<samplecount_t>(samples, lines) > size; ++level)
+    {
+        samples = (samples + 1) / 2;
+        lines = (lines + 1) / 2;
+
+        const string level_header_path = levelPath(header_path, level) + ".hdr";
+        ifstream probe(level_header_path, ios_base::in);
+        if (!probe.is_open()) return false;
+        probe.close();
+
+        try
+        {
+            const ENVIHeader header = ENVIHeader::load(level_header_path);
+            if (header.samples != samples || header.lines != lines || header.bands != _base.bands) return false;
+
+            levels.push_back(ENVIFileReader(header).map(ENVIHeader::dataFilePath(level_header_path)));
+        }
+        catch (const runtime_error&)
+        {
+            return false;
+        }
+    }
+
+    _levels.swap(levels);
+    return true;
+}
+
+/// <summary>
+/// Determines the level closest to the given scale factor that is not coarser than it
+/// </summary>
+/// <param name="scale_factor">The scale factor; Scaling will be 1/scale_factor.</param>
+/// <returns>The level.</returns>
+size_t ImagePyramid::levelFor(const float& scale_factor) const
+{
+    size_t level = 0;
+    while (level + 1 < levels() && scaleFactor(level + 1) <= scale_factor)
+    {
+        ++level;
+    }
+    return level;
+}
+
+/// <summary>
+/// Writes the reduced levels as ENVI files next to an ENVI file, named after its header with an .ovr suffix and the level,
+/// and the identity of the image file they were built from (the header name with an .ovr suffix)
+/// </summary>
+/// <param name="header_path">The path of the ENVI header file of the image.</param>
+void ImagePyramid::save(const string& header_path) const
+{
+    // the levels are only valid once the identity is written after them
+    const string identity_path = identityPath(header_path);
+    remove(identity_path.c_str());
+
+    const ENVIFileWriter writer(true);
+    for (size_t level = 1; level < levels(); ++level)
+    {
+        writer.write(this->level(level), levelPath(header_path, level));
+    }
+
+    ofstream file(identity_path, ios_base::trunc);
+    if (!file.is_open()) throw runtime_error("Could not open overview identity file for writing");
+
+    file << overview_signature << '\n';
+    FileIdentity::of(ENVIHeader::dataFilePath(header_path)).write(file);
+    if (!file) throw runtime_error("Could not write overview identity file");
+}
+
+/// <summary>
+/// Determines the path of an overview file without extension
+/// </summary>
+/// <param name="header_path">The path of the ENVI header file of the image.</param>
+/// <param name="level">The level.</param>
+/// <returns>The path.</returns>
+string ImagePyramid::levelPath(const string& header_path, const size_t& level)
+{
+    return ENVIHeader::basePath(header_path) + ".ovr" + to_string(static_cast<unsigned long long>(level));
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#ifndef _IMAGEPYRAMID_H_
+#define _IMAGEPYRAMID_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ENVIImage.h"
+
+namespace envi {
+
+/// <summary>
+/// Multi-resolution overview of an image: level 0 is the image itself, each further level halves the width and height
+/// of the previous one by averaging 2x2 blocks of samples. Overview work (display, previews, coarse searches) picks the
+/// level closest to the scale it needs instead of touching the full-resolution samples.
+/// The pyramid keeps a view of the image; It must not outlive the image.
+/// </summary>
+class ImagePyramid
+{
+private:
+    /// <summary>
+    /// The full-resolution image
+    /// </summary>
+    const ImageView _base;
+
+    /// <summary>
+    /// The reduced levels, starting with level 1
+    /// </summary>
+    std::vector<image_t> _levels;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ImagePyramid"/> class and builds all levels.
+    /// </summary>
+    /// <param name="image">The image or image region.</param>
+    /// <param name="min_size">Levels are added until neither side of the last level exceeds this number of samples.</param>
+    explicit ImagePyramid(const ImageView& image, const samplecount_t& min_size = 64) throw(std::runtime_error);
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ImagePyramid"/> class from the overview files next to an ENVI file;
+    /// If they are missing, don't fit the image or were built from different file contents, all levels are built and the overview files are written.
+    /// </summary>
+    /// <param name="image">The image.</param>
+    /// <param name="header_path">The path of the ENVI header file of the image.</param>
+    /// <param name="min_size">Levels are added until neither side of the last level exceeds this number of samples.</param>
+    ImagePyramid(const ImageView& image, const std::string& header_path, const samplecount_t& min_size = 64) throw(std::runtime_error);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="ImagePyramid"/> class.
+    /// </summary>
+    ~ImagePyramid(void);
+
+    /// <summary>
+    /// Gets the number of levels, including the full-resolution image
+    /// </summary>
+    /// <returns>The number of levels.</returns>
+    inline size_t levels() const
+    {
+        return _levels.size() + 1;
+    }
+
+    /// <summary>
+    /// Gets the given level
+    /// </summary>
+    /// <param name="level">The level; 0 is the full-resolution image.</param>
+    /// <returns>The view of the level.</returns>
+    inline ImageView level(const size_t& level) const
+    {
+        assert(level < levels());
+        return (level == 0) ? _base : _levels[level - 1]->view();
+    }
+
+    /// <summary>
+    /// Gets the factor by which the given level is reduced
+    /// </summary>
+    /// <param name="level">The level.</param>
+    /// <returns>The factor.</returns>
+    static inline float scaleFactor(const size_t& level)
+    {
+        return static_cast<float>(1U << level);
+    }
+
+    /// <summary>
+    /// Determines the level closest to the given scale factor that is not coarser than it
+    /// </summary>
+    /// <param name="scale_factor">The scale factor; Scaling will be 1/scale_factor.</param>
+    /// <returns>The level.</returns>
+    size_t levelFor(const float& scale_factor) const;
+
+    /// <summary>
+    /// Gets the level closest to the given scale factor that is not coarser than it
+    /// </summary>
+    /// <param name="scale_factor">The scale factor; Scaling will be 1/scale_factor.</param>
+    /// <returns>The view of the level.</returns>
+    inline ImageView closest(const float& scale_factor) const
+    {
+        return level(levelFor(scale_factor));
+    }
+
+    /// <summary>
+    /// Writes the reduced levels as ENVI files next to an ENVI file, named after its header with an .ovr suffix and the level,
+    /// and the identity of the image file they were built from (the header name with an .ovr suffix)
+    /// </summary>
+    /// <param name="header_path">The path of the ENVI header file of the image.</param>
+    void save(const std::string& header_path) const throw(std::runtime_error);
+
+    /// <summary>
+    /// Determines the path of an overview file without extension
+    /// </summary>
+    /// <param name="header_path">The path of the ENVI header file of the image.</param>
+    /// <param name="level">The level.</param>
+    /// <returns>The path.</returns>
+    static std::string levelPath(const std::string& header_path, const size_t& level);
+
+    /// <summary>
+    /// Halves the width and height of an image region by averaging 2x2 blocks of samples; An odd last line or sample
+    /// is averaged on its own.
+    /// </summary>
+    /// <param name="image">The image or image region.</param>
+    /// <returns>The reduced image, in the same band order.</returns>
+    static image_t reduce(const ImageView& image);
+
+private:
+    /// <summary>
+    /// Builds the reduced levels
+    /// </summary>
+    /// <param name="min_size">Levels are added until neither side of the last level exceeds this number of samples.</param>
+    void build(const samplecount_t& min_size);
+
+    /// <summary>
+    /// Maps the reduced levels from the overview files next to an ENVI file
+    /// </summary>
+    /// <param name="header_path">The path of the ENVI header file of the image.</param>
+    /// <param name="min_size">Levels are added until neither side of the last level exceeds this number of samples.</param>
+    /// <returns>false if an overview file is missing, doesn't fit the image or was built from different file contents.</returns>
+    bool load(const std::string& header_path, const samplecount_t& min_size);
+
+    ImagePyramid(const ImagePyramid&);
+    ImagePyramid& operator=(const ImagePyramid&);
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include <algorithm>
+
+#include "IntegralImage.h"
+
+using namespace std;
+using namespace envi;
+
+/// <summary>
+/// The number of columns summed up by a single thread in the vertical pass; 64 entries span 16 cache lines
+/// </summary>
+static const samplecount_t COLUMN_BLOCK = 64;
+
+/// <summary>
+/// Initializes a new instance of the <see cref="IntegralImage"/> class and builds the tables; Lines and columns are summed up in parallel.
+/// </summary>
+/// <param name="image">The image or image region; Positions of later queries are relative to it.</param>
+IntegralImage::IntegralImage(const ImageView& image)
+    : samples(image.samples), lines(image.lines), bands(image.bands)
+{
+    const size_t columns = static_cast<size_t>(samples) + 1;
+    const size_t plane = columns * (lines + 1);
+
+    _entries.reset(new Entry[plane * bands]);
+    _shift.reset(new double[bands]);
+    if (!_entries || !_shift) throw runtime_error("not enough memory to create integral image");
+
+    // the first sample of each band is close enough to the band's values to keep the sums small
+    for (bandcount_t b = 0; b < bands; ++b)
+    {
+        _shift[b] = (samples > 0 && lines > 0) ? static_cast<double>(image.sample(0, 0, b)) : 0.0;
+
+        Entry* zero_line = &_entries[b * plane];
+        for (size_t x = 0; x < columns; ++x)
+        {
+            zero_line[x].sum = 0.0;
+            zero_line[x].sum_sq = 0.0;
+        }
+    }
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    // horizontal pass: every line of every table holds the running sums of its own image line
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
+    {
+        for (bandcount_t b = 0; b < bands; ++b)
+        {
+            const sample_t* line = image.line(y, b);
+            const size_t step = image.sample_stride;
+            const double shift = _shift[b];
+
+            Entry* row = &_entries[b * plane + (y + 1) * columns];
+            row[0].sum = 0.0;
+            row[0].sum_sq = 0.0;
+
+            double sum = 0.0, sum_sq = 0.0;
+            for (samplecount_t x = 0; x < samples; ++x)
+            {
+                const double value = static_cast<double>(line[x * step]) - shift;
+                sum += value;
+                sum_sq += value * value;
+
+                row[x + 1].sum = sum;
+                row[x + 1].sum_sq = sum_sq;
+            }
+        }
+    }
+
+    // vertical pass: blocks of columns are added up line by line, so each thread streams through whole cache lines
+    const samplecount_t blocks = (columns + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+
+    typedef int_fast64_t omp_blockcount_t; // OpenMP needs signed integral type
+    omp_blockcount_t omp_blocks = static_cast<omp_blockcount_t>(blocks) * bands;
+
+    #pragma omp parallel for
+    for (omp_blockcount_t i = 0; i < omp_blocks; ++i)
+    {
+        const bandcount_t b = static_cast<bandcount_t>(i / blocks);
+        const size_t x_first = static_cast<size_t>(i % blocks) * COLUMN_BLOCK;
+        const size_t x_last = min<size_t>(x_first + COLUMN_BLOCK, columns);
+
+        Entry* above = &_entries[b * plane + columns];
+        for (linecount_t y = 1; y < lines; ++y)
+        {
+            Entry* row = above + columns;
+            for (size_t x = x_first; x < x_last; ++x)
+            {
+                row[x].sum += above[x].sum;
+                row[x].sum_sq += above[x].sum_sq;
+            }
+            above = row;
+        }
+    }
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="IntegralImage"/> class.
+/// </summary>
+IntegralImage::~IntegralImage(void)
+{
+    _entries.reset();
+    _shift.reset();
+}
+
+/// <summary>
+/// Calculates the number of samples, the mean and the variance of a rectangle
+/// </summary>
+/// <param name="sample_first">The first sample.</param>
+/// <param name="line_first">The first line.</param>
+/// <param name="samples">The number of samples.</param>
+/// <param name="lines">The number of lines.</param>
+/// <param name="band">The band.</param>
+/// <returns>The moments.</returns>
+RegionMoments IntegralImage::moments(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& band) const
+{
+    RegionMoments moments;
+    moments.count = static_cast<uint64_t>(samples) * lines;
+    moments.mean = 0.0;
+    moments.variance = 0.0;
+    if (moments.count == 0) return moments;
+
+    const Entry total = rectangle(sample_first, line_first, samples, lines, band);
+    const double count = static_cast<double>(moments.count);
+
+    // the shifted sums have a small mean, so subtracting it doesn't cancel the squared deviations
+    moments.mean = _shift[band] + total.sum / count;
+    if (moments.count > 1)
+    {
+        moments.variance = max(total.sum_sq - total.sum * total.sum / count, 0.0) / (count - 1);
+    }
+
+    return moments;
+}
+
+/// <summary>
+/// Applies a box filter to all bands: Every sample is replaced by the mean of the window of 2*radius+1 samples
+/// and lines around it; Windows are clipped at the borders of the image.
+/// </summary>
+/// <param name="radius">The radius of the window.</param>
+/// <returns>The filtered image, band sequential.</returns>
+image_t IntegralImage::boxMean(const samplecount_t& radius) const
+{
+    image_t target(new Image(samples, lines, bands, BSQ));
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
+    {
+        const linecount_t y_first = (static_cast<linecount_t>(y) > radius) ? y - radius : 0;
+        const linecount_t y_last = min<linecount_t>(y + radius + 1, lines);
+
+        for (bandcount_t b = 0; b < bands; ++b)
+        {
+            sample_t* target_line = target->line(y, b);
+            const double shift = _shift[b];
+
+            for (samplecount_t x = 0; x < samples; ++x)
+            {
+                const samplecount_t x_first = (x > radius) ? x - radius : 0;
+                const samplecount_t x_last = min<samplecount_t>(x + radius + 1, samples);
+
+                const Entry total = rectangle(x_first, y_first, x_last - x_first, y_last - y_first, b);
+                const double count = static_cast<double>((x_last - x_first) * (y_last - y_first));
+                target_line[x] = static_cast<sample_t>(shift + total.sum / count);
+            }
+        }
+    }
+
+    return target;
+}
\ No newline at end of file
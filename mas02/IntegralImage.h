@@ -0,0 +1,197 @@
+#ifndef _INTEGRALIMAGE_H_
+#define _INTEGRALIMAGE_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include "ENVIImage.h"
+
+namespace envi {
+
+/// <summary>
+/// Number of samples, mean and variance of a rectangular region
+/// </summary>
+struct RegionMoments
+{
+    /// <summary>The number of samples</summary>
+    uint64_t count;
+
+    /// <summary>The mean value</summary>
+    double mean;
+
+    /// <summary>The sample variance; 0 for fewer than two samples</summary>
+    double variance;
+
+    /// <summary>
+    /// Gets the standard deviation
+    /// </summary>
+    /// <returns>The standard deviation.</returns>
+    inline double standardDeviation() const
+    {
+        return sqrt(variance);
+    }
+};
+
+/// <summary>
+/// Summed-area tables of the samples and of the squared samples of all bands of an image. Once built, the sum, the sum
+/// of squares, the mean and the variance of any rectangle are read from four entries per table, independent of the size
+/// of the rectangle; This serves region queries as well as box filters and the window energies of a normalized
+/// cross-correlation.
+/// The tables hold double-precision sums of the samples minus a per-band shift (the band's first sample), which keeps
+/// the sums small and the variance free of cancellation. Each entry takes 16 bytes per band, i.e. the tables are four
+/// times the size of the float image.
+/// </summary>
+class IntegralImage
+{
+private:
+    /// <summary>
+    /// Inclusive sums of all samples above and left of a position
+    /// </summary>
+    struct Entry
+    {
+        /// <summary>The sum of the shifted samples</summary>
+        double sum;
+
+        /// <summary>The sum of the squared shifted samples</summary>
+        double sum_sq;
+    };
+
+    /// <summary>
+    /// The tables, band by band; Each has <see cref="samples"/>+1 columns and <see cref="lines"/>+1 lines, the first line and column are zero
+    /// </summary>
+    std::unique_ptr<Entry[]> _entries;
+
+    /// <summary>
+    /// The value subtracted from every sample, per band
+    /// </summary>
+    std::unique_ptr<double[]> _shift;
+
+public:
+    /// <summary>
+    /// The number of samples per line of the image
+    /// </summary>
+    const samplecount_t samples;
+
+    /// <summary>
+    /// The number of lines of the image
+    /// </summary>
+    const linecount_t lines;
+
+    /// <summary>
+    /// The number of bands of the image
+    /// </summary>
+    const bandcount_t bands;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="IntegralImage"/> class and builds the tables; Lines and columns are summed up in parallel.
+    /// </summary>
+    /// <param name="image">The image or image region; Positions of later queries are relative to it.</param>
+    explicit IntegralImage(const ImageView& image) throw(std::runtime_error);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="IntegralImage"/> class.
+    /// </summary>
+    ~IntegralImage(void);
+
+    /// <summary>
+    /// Calculates the sum of the samples of a rectangle
+    /// </summary>
+    /// <param name="sample_first">The first sample.</param>
+    /// <param name="line_first">The first line.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>The sum.</returns>
+    inline double sum(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& band = 0) const
+    {
+        const Entry total = rectangle(sample_first, line_first, samples, lines, band);
+        return total.sum + static_cast<double>(samples * lines) * _shift[band];
+    }
+
+    /// <summary>
+    /// Calculates the sum of the squared samples of a rectangle
+    /// </summary>
+    /// <param name="sample_first">The first sample.</param>
+    /// <param name="line_first">The first line.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>The sum of squares.</returns>
+    inline double sumOfSquares(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& band = 0) const
+    {
+        // (v - c)^2 summed up, expanded back to v^2
+        const Entry total = rectangle(sample_first, line_first, samples, lines, band);
+        const double shift = _shift[band];
+        return total.sum_sq + 2.0 * shift * total.sum + static_cast<double>(samples * lines) * shift * shift;
+    }
+
+    /// <summary>
+    /// Calculates the number of samples, the mean and the variance of a rectangle
+    /// </summary>
+    /// <param name="sample_first">The first sample.</param>
+    /// <param name="line_first">The first line.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>The moments.</returns>
+    RegionMoments moments(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& band = 0) const;
+
+    /// <summary>
+    /// Applies a box filter to all bands: Every sample is replaced by the mean of the window of 2*radius+1 samples
+    /// and lines around it; Windows are clipped at the borders of the image.
+    /// </summary>
+    /// <param name="radius">The radius of the window.</param>
+    /// <returns>The filtered image, band sequential.</returns>
+    image_t boxMean(const samplecount_t& radius) const;
+
+private:
+    /// <summary>
+    /// Gets the entry of a table
+    /// </summary>
+    /// <param name="sample">The column; 0 is the zero column.</param>
+    /// <param name="line">The line; 0 is the zero line.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>The entry.</returns>
+    inline const Entry& entry(const samplecount_t& sample, const linecount_t& line, const bandcount_t& band) const
+    {
+        return _entries[(static_cast<size_t>(band) * (lines + 1) + line) * (samples + 1) + sample];
+    }
+
+    /// <summary>
+    /// Sums up the shifted samples of a rectangle from the four corners of the table
+    /// </summary>
+    /// <param name="sample_first">The first sample.</param>
+    /// <param name="line_first">The first line.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>The sums.</returns>
+    inline Entry rectangle(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines, const bandcount_t& band) const
+    {
+        assert(sample_first + samples <= this->samples);
+        assert(line_first + lines <= this->lines);
+        assert(band < bands);
+
+        const Entry& top_left     = entry(sample_first, line_first, band);
+        const Entry& top_right    = entry(sample_first + samples, line_first, band);
+        const Entry& bottom_left  = entry(sample_first, line_first + lines, band);
+        const Entry& bottom_right = entry(sample_first + samples, line_first + lines, band);
+
+        Entry total;
+        total.sum    = (bottom_right.sum - top_right.sum) - (bottom_left.sum - top_left.sum);
+        total.sum_sq = (bottom_right.sum_sq - top_right.sum_sq) - (bottom_left.sum_sq - top_left.sum_sq);
+        return total;
+    }
+
+    IntegralImage(const IntegralImage&);
+    IntegralImage& operator=(const IntegralImage&);
+};
+
+}
+
+#endif
\ No newline at end of file
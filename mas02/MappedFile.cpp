@@ -0,0 +1,123 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <limits>
+
+#include "MappedFile.h"
+
+using namespace std;
+using namespace envi;
+
+#ifdef _WIN32
+
+/// <summary>
+/// Initializes a new instance of the <see cref="MappedFile"/> class by mapping the whole file.
+/// </summary>
+/// <param name="path">The path of the file.</param>
+MappedFile::MappedFile(const string& path)
+    : _file(INVALID_HANDLE_VALUE), _mapping(NULL), _data(NULL), _size(0)
+{
+    _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (_file == INVALID_HANDLE_VALUE) throw runtime_error("Could not open file for mapping");
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size))
+    {
+        CloseHandle(_file);
+        throw runtime_error("Could not determine the size of the file");
+    }
+
+    // a 32-bit process cannot map files of 4 GiB and more
+    if (static_cast<unsigned long long>(size.QuadPart) > numeric_limits<size_t>::max())
+    {
+        CloseHandle(_file);
+        throw runtime_error("File is too large to be mapped into the address space");
+    }
+    _size = static_cast<size_t>(size.QuadPart);
+
+    // empty files cannot be mapped, but there is nothing to map either
+    if (_size == 0) return;
+
+    _mapping = CreateFileMappingA(_file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (_mapping == NULL)
+    {
+        CloseHandle(_file);
+        throw runtime_error("Could not map file");
+    }
+
+    _data = static_cast<char*>(MapViewOfFile(_mapping, FILE_MAP_COPY, 0, 0, 0));
+    if (_data == NULL)
+    {
+        CloseHandle(_mapping);
+        CloseHandle(_file);
+        throw runtime_error("Could not map file");
+    }
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="MappedFile"/> class.
+/// </summary>
+MappedFile::~MappedFile()
+{
+    if (_data != NULL) UnmapViewOfFile(_data);
+    if (_mapping != NULL) CloseHandle(_mapping);
+    if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+}
+
+#else
+
+/// <summary>
+/// Initializes a new instance of the <see cref="MappedFile"/> class by mapping the whole file.
+/// </summary>
+/// <param name="path">The path of the file.</param>
+MappedFile::MappedFile(const string& path)
+    : _file(-1), _data(NULL), _size(0)
+{
+    _file = open(path.c_str(), O_RDONLY);
+    if (_file < 0) throw runtime_error("Could not open file for mapping");
+
+    struct stat status;
+    if (fstat(_file, &status) != 0)
+    {
+        close(_file);
+        throw runtime_error("Could not determine the size of the file");
+    }
+
+    // a 32-bit process cannot map files of 4 GiB and more
+    if (static_cast<unsigned long long>(status.st_size) > numeric_limits<size_t>::max())
+    {
+        close(_file);
+        throw runtime_error("File is too large to be mapped into the address space");
+    }
+    _size = static_cast<size_t>(status.st_size);
+
+    // empty files cannot be mapped, but there is nothing to map either
+    if (_size == 0) return;
+
+    void* data = mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, _file, 0);
+    if (data == MAP_FAILED)
+    {
+        close(_file);
+        throw runtime_error("Could not map file");
+    }
+    _data = static_cast<char*>(data);
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="MappedFile"/> class.
+/// </summary>
+MappedFile::~MappedFile()
+{
+    if (_data != NULL) munmap(_data, _size);
+    if (_file >= 0) close(_file);
+}
+
+#endif
\ No newline at end of file
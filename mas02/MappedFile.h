@@ -0,0 +1,84 @@
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace envi {
+
+/// <summary>
+/// A file mapped into memory.
+/// The file is opened read-only and mapped copy-on-write: all processes mapping the same file share its pages
+/// in the page cache, and writes to the mapping stay private to the process and never reach the file.
+/// </summary>
+class MappedFile
+{
+private:
+#ifdef _WIN32
+    /// <summary>
+    /// The file handle
+    /// </summary>
+    void* _file;
+
+    /// <summary>
+    /// The file mapping handle
+    /// </summary>
+    void* _mapping;
+#else
+    /// <summary>
+    /// The file descriptor
+    /// </summary>
+    int _file;
+#endif
+
+    /// <summary>
+    /// The first byte of the mapping
+    /// </summary>
+    char* _data;
+
+    /// <summary>
+    /// The size of the file in bytes
+    /// </summary>
+    size_t _size;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="MappedFile"/> class by mapping the whole file.
+    /// </summary>
+    /// <param name="path">The path of the file.</param>
+    explicit MappedFile(const std::string& path) throw(std::runtime_error);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="MappedFile"/> class.
+    /// </summary>
+    ~MappedFile();
+
+    /// <summary>
+    /// Gets a pointer to the first byte of the file
+    /// </summary>
+    /// <returns>char *.</returns>
+    inline char* data() const
+    {
+        return _data;
+    }
+
+    /// <summary>
+    /// Gets the size of the file in bytes
+    /// </summary>
+    /// <returns>The size.</returns>
+    inline size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+}
+
+#endif
\ No newline at end of file
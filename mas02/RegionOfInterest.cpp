@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cmath>
+
+#include "RegionOfInterest.h"
+
+using namespace std;
+using namespace envi;
+
+/// <summary>
+/// Initializes a new instance of the <see cref="RegionOfInterest"/> class.
+/// </summary>
+/// <param name="vertices">The corners.</param>
+/// <param name="rectangle">Whether the corners form an axis-aligned rectangle.</param>
+RegionOfInterest::RegionOfInterest(const vector<Vertex>& vertices, const bool rectangle)
+    : _vertices(vertices), _rectangle(rectangle), _top(vertices[0].y), _bottom(vertices[0].y)
+{
+    for (size_t i = 1; i < _vertices.size(); ++i)
+    {
+        _top = min(_top, _vertices[i].y);
+        _bottom = max(_bottom, _vertices[i].y);
+    }
+}
+
+/// <summary>
+/// Creates a rectangular region
+/// </summary>
+/// <param name="sample_first">The first sample.</param>
+/// <param name="line_first">The first line.</param>
+/// <param name="samples">The number of samples.</param>
+/// <param name="lines">The number of lines.</param>
+/// <returns>The region.</returns>
+RegionOfInterest RegionOfInterest::rectangle(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines)
+{
+    const double left = static_cast<double>(sample_first);
+    const double top = static_cast<double>(line_first);
+    const double right = left + static_cast<double>(samples);
+    const double bottom = top + static_cast<double>(lines);
+
+    vector<Vertex> corners(4);
+    corners[0].x = left;  corners[0].y = top;
+    corners[1].x = right; corners[1].y = top;
+    corners[2].x = right; corners[2].y = bottom;
+    corners[3].x = left;  corners[3].y = bottom;
+    return RegionOfInterest(corners, true);
+}
+
+/// <summary>
+/// Creates a polygonal region; The outline is closed from the last corner back to the first one.
+/// </summary>
+/// <param name="vertices">The corners; At least three.</param>
+/// <returns>The region.</returns>
+RegionOfInterest RegionOfInterest::polygon(const vector<Vertex>& vertices)
+{
+    if (vertices.size() < 3) throw runtime_error("a polygon needs at least three corners");
+    return RegionOfInterest(vertices, false);
+}
+
+/// <summary>
+/// Converts a position to the first sample or line whose center lies at or after it
+/// </summary>
+/// <param name="position">The position.</param>
+/// <returns>The sample or line; 0 for positions before the first center.</returns>
+static inline uint_fast64_t firstCenterFrom(const double& position)
+{
+    return (position <= 0.5) ? 0 : static_cast<uint_fast64_t>(ceil(position - 0.5));
+}
+
+/// <summary>
+/// Adds the samples whose centers lie between two horizontal positions
+/// </summary>
+/// <param name="left">The left position.</param>
+/// <param name="right">The right position; Samples centered on it are not included.</param>
+/// <param name="samples">The number of samples per line.</param>
+/// <param name="spans">The spans.</param>
+static inline void addSpan(const double& left, const double& right, const samplecount_t& samples, vector<Span>& spans)
+{
+    const samplecount_t first = min<samplecount_t>(firstCenterFrom(left), samples);
+    const samplecount_t end = min<samplecount_t>(firstCenterFrom(right), samples);
+    if (end <= first) return;
+
+    const Span span = { first, end - first };
+    spans.push_back(span);
+}
+
+/// <summary>
+/// Gets the first line the region may cover
+/// </summary>
+/// <returns>The line.</returns>
+linecount_t RegionOfInterest::firstLine() const
+{
+    return firstCenterFrom(_top);
+}
+
+/// <summary>
+/// Gets the line after the last line the region may cover
+/// </summary>
+/// <returns>The line.</returns>
+linecount_t RegionOfInterest::endLine() const
+{
+    return max<linecount_t>(firstCenterFrom(_bottom), firstLine());
+}
+
+/// <summary>
+/// Determines the samples of a line that belong to the region
+/// </summary>
+/// <param name="line">The line.</param>
+/// <param name="samples">The number of samples per line of the image; Spans are clipped to it.</param>
+/// <param name="spans">Receives the runs of samples from left to right; Cleared first.</param>
+void RegionOfInterest::spans(const linecount_t& line, const samplecount_t& samples, vector<Span>& spans) const
+{
+    spans.clear();
+
+    // samples belong to the region if their centers do
+    const double center = static_cast<double>(line) + 0.5;
+    if (center < _top || center >= _bottom) return;
+
+    if (_rectangle)
+    {
+        addSpan(_vertices[0].x, _vertices[1].x, samples, spans);
+        return;
+    }
+
+    // crossings of the outline with the line through the sample centers
+    vector<double> crossings;
+    for (size_t i = 0, j = _vertices.size() - 1; i < _vertices.size(); j = i++)
+    {
+        const Vertex& a = _vertices[j];
+        const Vertex& b = _vertices[i];
+
+        // half-open edges, so a corner on the line is counted once
+        if ((a.y <= center) != (b.y <= center))
+        {
+            crossings.push_back(a.x + (center - a.y) * (b.x - a.x) / (b.y - a.y));
+        }
+    }
+    sort(crossings.begin(), crossings.end());
+
+    // even-odd rule: the samples between each pair of crossings are inside
+    for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+    {
+        addSpan(crossings[i], crossings[i + 1], samples, spans);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef _REGIONOFINTEREST_H_
+#define _REGIONOFINTEREST_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <stdexcept>
+#include <vector>
+
+#include "ENVIImage.h"
+
+namespace envi {
+
+/// <summary>
+/// A corner of a polygon, in samples and lines; (0, 0) is the upper left corner of the first sample
+/// </summary>
+struct Vertex
+{
+    /// <summary>The horizontal position</summary>
+    double x;
+
+    /// <summary>The vertical position</summary>
+    double y;
+};
+
+/// <summary>
+/// A run of consecutive samples of a line
+/// </summary>
+struct Span
+{
+    /// <summary>The first sample</summary>
+    samplecount_t first;
+
+    /// <summary>The number of samples</summary>
+    samplecount_t samples;
+};
+
+/// <summary>
+/// A region of interest: a rectangle or a polygon. A sample belongs to a polygon if its center lies inside (even-odd rule),
+/// so polygons may be concave or have holes drawn as a single outline.
+/// </summary>
+class RegionOfInterest
+{
+private:
+    /// <summary>
+    /// The corners; Four corners for a rectangle
+    /// </summary>
+    std::vector<Vertex> _vertices;
+
+    /// <summary>
+    /// Whether the region is an axis-aligned rectangle
+    /// </summary>
+    bool _rectangle;
+
+    /// <summary>
+    /// The lowest and highest vertical position of all corners
+    /// </summary>
+    double _top, _bottom;
+
+public:
+    /// <summary>
+    /// Creates a rectangular region
+    /// </summary>
+    /// <param name="sample_first">The first sample.</param>
+    /// <param name="line_first">The first line.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>The region.</returns>
+    static RegionOfInterest rectangle(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines);
+
+    /// <summary>
+    /// Creates a polygonal region; The outline is closed from the last corner back to the first one.
+    /// </summary>
+    /// <param name="vertices">The corners; At least three.</param>
+    /// <returns>The region.</returns>
+    static RegionOfInterest polygon(const std::vector<Vertex>& vertices) throw(std::runtime_error);
+
+    /// <summary>
+    /// Gets the first line the region may cover
+    /// </summary>
+    /// <returns>The line.</returns>
+    linecount_t firstLine() const;
+
+    /// <summary>
+    /// Gets the line after the last line the region may cover
+    /// </summary>
+    /// <returns>The line.</returns>
+    linecount_t endLine() const;
+
+    /// <summary>
+    /// Determines the samples of a line that belong to the region
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <param name="samples">The number of samples per line of the image; Spans are clipped to it.</param>
+    /// <param name="spans">Receives the runs of samples from left to right; Cleared first.</param>
+    void spans(const linecount_t& line, const samplecount_t& samples, std::vector<Span>& spans) const;
+
+private:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="RegionOfInterest"/> class.
+    /// </summary>
+    /// <param name="vertices">The corners.</param>
+    /// <param name="rectangle">Whether the corners form an axis-aligned rectangle.</param>
+    RegionOfInterest(const std::vector<Vertex>& vertices, const bool rectangle);
+};
+
+}
+
+#endif
\ No newline at end of file
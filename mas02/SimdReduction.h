@@ -0,0 +1,83 @@
+#ifndef _SIMDREDUCTION_H_
+#define _SIMDREDUCTION_H_
+
+#include <cstddef>
+
+/// <summary>
+/// The instruction set extensions the reduction kernels can use
+/// </summary>
+enum SimdLevel
+{
+    /// <summary>Plain scalar code</summary>
+    SimdScalar,
+
+    /// <summary>SSE2, 128-bit registers</summary>
+    SimdSSE2,
+
+    /// <summary>AVX2 and FMA, 256-bit registers</summary>
+    SimdAVX2,
+
+    /// <summary>AVX-512 foundation, 512-bit registers</summary>
+    SimdAVX512
+};
+
+/// <summary>
+/// Result of reducing a run of values: their range, and the sum and sum of squares of their
+/// differences to a shift value. Shifting by a value close to the mean keeps the sums small,
+/// so the variance can be taken from them without cancellation. The values are widened to double
+/// precision before the shift is subtracted, so the differences are exact.
+/// </summary>
+struct Reduction
+{
+    /// <summary>The minimum value</summary>
+    float min;
+
+    /// <summary>The maximum value</summary>
+    float max;
+
+    /// <summary>The sum of (value - shift)</summary>
+    double sum;
+
+    /// <summary>The sum of (value - shift)^2</summary>
+    double sum_sq;
+};
+
+/// <summary>
+/// Determines the widest instruction set extension supported by both the processor and the operating system
+/// </summary>
+/// <returns>The level.</returns>
+SimdLevel detectSimdLevel();
+
+/// <summary>
+/// Gets the instruction set extension the kernels were selected for at startup
+/// </summary>
+/// <returns>The level.</returns>
+SimdLevel simdLevel();
+
+/// <summary>
+/// Gets the name of an instruction set level
+/// </summary>
+/// <param name="level">The level.</param>
+/// <returns>The name.</returns>
+const char* simdLevelName(const SimdLevel level);
+
+/// <summary>
+/// Determines the range of contiguous values; NaN values are skipped.
+/// An empty run yields FLT_MAX as minimum and -FLT_MAX as maximum.
+/// </summary>
+/// <param name="values">The values.</param>
+/// <param name="count">The number of values.</param>
+/// <param name="min">The minimum value.</param>
+/// <param name="max">The maximum value.</param>
+void reduceMinMax(const float* values, const size_t count, float& min, float& max);
+
+/// <summary>
+/// Determines the range of contiguous values, and the sum and sum of squares of their differences to a shift value, in a single pass
+/// </summary>
+/// <param name="values">The values.</param>
+/// <param name="count">The number of values.</param>
+/// <param name="shift">The shift; Ideally close to the mean, e.g. the first value.</param>
+/// <param name="reduction">The reduction.</param>
+void reduceMinMaxSums(const float* values, const size_t count, const float shift, Reduction& reduction);
+
+#endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <memory>
+#include <vector>
 
 /// <summary>Data type used for statistics</summary>
 typedef float stats_t;
@@ -44,4 +45,7 @@ struct Stats {
     friend std::ostream& operator<< (std::ostream& stream, const std::shared_ptr<Stats>& stats);
 };
 
+/// <summary>Statistics of each band of an image</summary>
+typedef std::vector<std::shared_ptr<Stats>> bandstats_t;
+
 #endif
\ No newline at end of file
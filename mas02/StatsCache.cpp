@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <fstream>
+
+#include "StatsCache.h"
+
+using namespace std;
+using namespace envi;
+
+/// <summary>The first line of every sidecar file; The version changes whenever the layout of the entries does</summary>
+static const string cache_signature = "ENVI statistics cache, version 2";
+
+/// <summary>
+/// Initializes a new instance of the <see cref="StatsCache"/> class and loads the sidecar file of an image file if it still matches.
+/// </summary>
+/// <param name="image_path">The path of the image file.</param>
+StatsCache::StatsCache(const string& image_path)
+    : _path(image_path + ".stats"), _identity(FileIdentity::of(image_path)), _dirty(false), _tile_size(0), _tiles_x(0)
+{
+    bool loaded = false;
+    try
+    {
+        loaded = load();
+    }
+    catch (const exception&)
+    {
+        // a damaged sidecar file is simply rebuilt
+        loaded = false;
+    }
+
+    if (!loaded)
+    {
+        _stats.clear();
+        _histograms.clear();
+        _tiles.clear();
+        _tile_size = 0;
+        _tiles_x = 0;
+    }
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="StatsCache"/> class.
+/// </summary>
+StatsCache::~StatsCache(void)
+{
+}
+
+/// <summary>
+/// Loads the sidecar file
+/// </summary>
+/// <returns>false if there is no sidecar file or it belongs to different file contents.</returns>
+bool StatsCache::load()
+{
+    ifstream file(_path, ios_base::in);
+    if (!file.is_open()) return false;
+
+    string signature;
+    getline(file, signature);
+    if (signature != cache_signature) return false;
+
+    if (!(FileIdentity::read(file) == _identity)) return false;
+
+    string entry;
+    while (file >> entry)
+    {
+        if (entry == "stats")
+        {
+            string key;
+            size_t bands;
+            file >> key >> bands;
+
+            bandstats_t stats;
+            for (size_t b = 0; b < bands && file; ++b)
+            {
+                stats_t min, max, mean, std;
+                file >> min >> max >> mean >> std;
+                stats.push_back(shared_ptr<Stats>(new Stats(min, max, mean, std)));
+            }
+            _stats[key] = stats;
+        }
+        else if (entry == "histogram")
+        {
+            string key;
+            size_t size;
+            file >> key >> size;
+
+            vector<histogram_bin> histogram(size);
+            for (size_t i = 0; i < size && file; ++i)
+            {
+                file >> histogram[i];
+            }
+            _histograms[key].swap(histogram);
+        }
+        else if (entry == "tiles")
+        {
+            size_t count, bands;
+            file >> _tile_size >> _tiles_x >> count >> bands;
+            if (!file || bands == 0 || bands > 255) throw runtime_error("Invalid tiles in statistics cache");
+
+            _tiles.clear();
+            for (size_t t = 0; t < count && file; ++t)
+            {
+                _tiles.push_back(BandStatsAccumulator(static_cast<bandcount_t>(bands)));
+                _tiles.back().read(file);
+            }
+        }
+        else
+        {
+            throw runtime_error("Unknown entry in statistics cache");
+        }
+
+        if (!file) throw runtime_error("Could not read statistics cache");
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Writes the sidecar file if anything was stored since it was loaded
+/// </summary>
+void StatsCache::save() const
+{
+    if (!_dirty) return;
+
+    ofstream file(_path, ios_base::trunc);
+    if (!file.is_open()) throw runtime_error("Could not open statistics cache for writing");
+
+    file << cache_signature << '\n';
+    _identity.write(file);
+
+    // enough digits to read back the exact values
+    file.precision(9);
+
+    for (map<string, bandstats_t>::const_iterator it = _stats.begin(); it != _stats.end(); ++it)
+    {
+        file << "stats " << it->first << ' ' << it->second.size();
+        for (size_t b = 0; b < it->second.size(); ++b)
+        {
+            const Stats& stats = *it->second[b];
+            file << ' ' << stats.min << ' ' << stats.max << ' ' << stats.mean << ' ' << stats.standard_deviation;
+        }
+        file << '\n';
+    }
+
+    for (map<string, vector<histogram_bin>>::const_iterator it = _histograms.begin(); it != _histograms.end(); ++it)
+    {
+        file << "histogram " << it->first << ' ' << it->second.size();
+        for (size_t i = 0; i < it->second.size(); ++i)
+        {
+            file << ' ' << it->second[i];
+        }
+        file << '\n';
+    }
+
+    if (hasTiles() && !_tiles.empty())
+    {
+        file << "tiles " << _tile_size << ' ' << _tiles_x << ' ' << _tiles.size() << ' ' << static_cast<int>(_tiles[0].bands()) << '\n';
+        for (size_t t = 0; t < _tiles.size(); ++t)
+        {
+            _tiles[t].write(file);
+        }
+    }
+
+    if (!file) throw runtime_error("Could not write statistics cache");
+}
+
+/// <summary>
+/// Looks up statistics
+/// </summary>
+/// <param name="key">The key.</param>
+/// <param name="stats">The statistics, one per band.</param>
+/// <returns>true if the statistics are cached.</returns>
+bool StatsCache::findStats(const string& key, out bandstats_t& stats) const
+{
+    map<string, bandstats_t>::const_iterator it = _stats.find(key);
+    if (it == _stats.end()) return false;
+
+    stats = it->second;
+    return true;
+}
+
+/// <summary>
+/// Stores statistics
+/// </summary>
+/// <param name="key">The key.</param>
+/// <param name="stats">The statistics, one per band.</param>
+void StatsCache::storeStats(const string& key, const bandstats_t& stats)
+{
+    _stats[key] = stats;
+    _dirty = true;
+}
+
+/// <summary>
+/// Looks up a histogram
+/// </summary>
+/// <param name="key">The key.</param>
+/// <param name="histogram">The histogram classes, band by band.</param>
+/// <returns>true if the histogram is cached.</returns>
+bool StatsCache::findHistogram(const string& key, out unique_ptr<histogram_bin[]>& histogram) const
+{
+    map<string, vector<histogram_bin>>::const_iterator it = _histograms.find(key);
+    if (it == _histograms.end()) return false;
+
+    histogram.reset(new histogram_bin[it->second.size()]);
+    copy(it->second.begin(), it->second.end(), histogram.get());
+    return true;
+}
+
+/// <summary>
+/// Stores a histogram
+/// </summary>
+/// <param name="key">The key.</param>
+/// <param name="histogram">The histogram classes, band by band.</param>
+/// <param name="size">The number of classes of all bands.</param>
+void StatsCache::storeHistogram(const string& key, const histogram_bin* histogram, const size_t& size)
+{
+    _histograms[key].assign(histogram, histogram + size);
+    _dirty = true;
+}
+
+/// <summary>
+/// Calculates and stores the statistics of each tile of an image; Tiles are processed in parallel.
+/// </summary>
+/// <param name="image">The image the cache belongs to.</param>
+/// <param name="tile_size">The width and height of a tile.</param>
+void StatsCache::buildTiles(const ImageView& image, const samplecount_t& tile_size)
+{
+    if (tile_size == 0) throw runtime_error("invalid tile size for statistics cache");
+
+    const size_t tiles_x = static_cast<size_t>((image.samples + tile_size - 1) / tile_size);
+    const size_t tiles_y = static_cast<size_t>((image.lines + tile_size - 1) / tile_size);
+    vector<BandStatsAccumulator> tiles(tiles_x * tiles_y, BandStatsAccumulator(image.bands));
+
+    typedef int_fast64_t omp_tilecount_t; // OpenMP needs signed integral type
+    const omp_tilecount_t omp_tiles = static_cast<omp_tilecount_t>(tiles.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_tilecount_t t = 0; t < omp_tiles; ++t)
+    {
+        const samplecount_t x = (static_cast<size_t>(t) % tiles_x) * tile_size;
+        const linecount_t   y = (static_cast<size_t>(t) / tiles_x) * tile_size;
+        tiles[t].add(image.view(x, y, min<samplecount_t>(tile_size, image.samples - x), min<linecount_t>(tile_size, image.lines - y)));
+    }
+
+    _tiles.swap(tiles);
+    _tile_size = tile_size;
+    _tiles_x = tiles_x;
+    _dirty = true;
+}
+
+/// <summary>
+/// Calculates the statistics of a region from the tile statistics; Only the parts of the region that
+/// don't cover whole tiles are read from the image.
+/// </summary>
+/// <param name="image">The image the cache belongs to.</param>
+/// <param name="sample_first">The first sample.</param>
+/// <param name="line_first">The first line.</param>
+/// <param name="samples">The number of samples.</param>
+/// <param name="lines">The number of lines.</param>
+/// <returns>The statistics, one per band.</returns>
+bandstats_t StatsCache::regionStats(const ImageView& image, const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines) const
+{
+    if (samples == 0 || lines == 0 || sample_first + samples > image.samples || line_first + lines > image.lines) throw runtime_error("region exceeds the image");
+
+    BandStatsAccumulator accumulator(image.bands);
+    const samplecount_t sample_last = sample_first + samples;
+    const linecount_t   line_last = line_first + lines;
+
+    // the whole tiles within the region; A tile at the border of the image is whole if the region reaches the border
+    samplecount_t inner_x0 = 0, inner_x1 = 0;
+    linecount_t   inner_y0 = 0, inner_y1 = 0;
+    if (hasTiles())
+    {
+        const size_t tiles_y = (_tiles_x > 0) ? _tiles.size() / _tiles_x : 0;
+        if (_tiles_x != (image.samples + _tile_size - 1) / _tile_size || tiles_y != (image.lines + _tile_size - 1) / _tile_size || _tiles[0].bands() != image.bands)
+        {
+            throw runtime_error("tile statistics don't belong to the image");
+        }
+
+        inner_x0 = (sample_first + _tile_size - 1) / _tile_size * _tile_size;
+        inner_y0 = (line_first + _tile_size - 1) / _tile_size * _tile_size;
+        inner_x1 = (sample_last == image.samples) ? sample_last : sample_last / _tile_size * _tile_size;
+        inner_y1 = (line_last == image.lines) ? line_last : line_last / _tile_size * _tile_size;
+    }
+
+    if (inner_x1 <= inner_x0 || inner_y1 <= inner_y0)
+    {
+        accumulator.add(image.view(sample_first, line_first, samples, lines));
+        return accumulator.result();
+    }
+
+    for (size_t ty = static_cast<size_t>(inner_y0 / _tile_size); ty * _tile_size < inner_y1; ++ty)
+    {
+        for (size_t tx = static_cast<size_t>(inner_x0 / _tile_size); tx * _tile_size < inner_x1; ++tx)
+        {
+            accumulator.merge(_tiles[ty * _tiles_x + tx]);
+        }
+    }
+
+    // the border around the whole tiles
+    if (inner_y0 > line_first)  accumulator.add(image.view(sample_first, line_first, samples, inner_y0 - line_first));
+    if (line_last > inner_y1)   accumulator.add(image.view(sample_first, inner_y1, samples, line_last - inner_y1));
+    if (inner_x0 > sample_first) accumulator.add(image.view(sample_first, inner_y0, inner_x0 - sample_first, inner_y1 - inner_y0));
+    if (sample_last > inner_x1)  accumulator.add(image.view(inner_x1, inner_y0, sample_last - inner_x1, inner_y1 - inner_y0));
+
+    return accumulator.result();
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+#ifndef _STATSCACHE_H_
+#define _STATSCACHE_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Accumulators.h"
+#include "ENVIImage.h"
+#include "FileIdentity.h"
+#include "Stats.h"
+
+/// <summary>Marks a variable as output</summary>
+#define out
+
+/// <summary>
+/// Sidecar cache of the statistics, histograms and per-tile statistics of an image file. The cache is stored as
+/// text next to the image file (the image path with a .stats suffix) and is discarded as soon as size,
+/// modification time or content hash of the image file change; The path it was opened by doesn't matter.
+/// Keys name what was computed, e.g. the statistics method or the histogram's range; They must not contain whitespace.
+/// </summary>
+class StatsCache
+{
+private:
+    /// <summary>
+    /// The path of the sidecar file
+    /// </summary>
+    const std::string _path;
+
+    /// <summary>
+    /// The identity of the image file
+    /// </summary>
+    const FileIdentity _identity;
+
+    /// <summary>
+    /// Whether the cache changed since it was loaded
+    /// </summary>
+    bool _dirty;
+
+    /// <summary>
+    /// The statistics by key
+    /// </summary>
+    std::map<std::string, bandstats_t> _stats;
+
+    /// <summary>
+    /// The histograms by key, band by band
+    /// </summary>
+    std::map<std::string, std::vector<histogram_bin>> _histograms;
+
+    /// <summary>
+    /// The width and height of a statistics tile; 0 if there are no tile statistics
+    /// </summary>
+    envi::samplecount_t _tile_size;
+
+    /// <summary>
+    /// The number of tiles per row
+    /// </summary>
+    size_t _tiles_x;
+
+    /// <summary>
+    /// The running totals of each tile, row by row
+    /// </summary>
+    std::vector<BandStatsAccumulator> _tiles;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="StatsCache"/> class and loads the sidecar file of an image file if it still matches.
+    /// </summary>
+    /// <param name="image_path">The path of the image file.</param>
+    explicit StatsCache(const std::string& image_path) throw(std::runtime_error);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="StatsCache"/> class.
+    /// </summary>
+    ~StatsCache(void);
+
+    /// <summary>
+    /// Looks up statistics
+    /// </summary>
+    /// <param name="key">The key.</param>
+    /// <param name="stats">The statistics, one per band.</param>
+    /// <returns>true if the statistics are cached.</returns>
+    bool findStats(const std::string& key, out bandstats_t& stats) const;
+
+    /// <summary>
+    /// Stores statistics
+    /// </summary>
+    /// <param name="key">The key.</param>
+    /// <param name="stats">The statistics, one per band.</param>
+    void storeStats(const std::string& key, const bandstats_t& stats);
+
+    /// <summary>
+    /// Looks up a histogram
+    /// </summary>
+    /// <param name="key">The key.</param>
+    /// <param name="histogram">The histogram classes, band by band.</param>
+    /// <returns>true if the histogram is cached.</returns>
+    bool findHistogram(const std::string& key, out std::unique_ptr<histogram_bin[]>& histogram) const;
+
+    /// <summary>
+    /// Stores a histogram
+    /// </summary>
+    /// <param name="key">The key.</param>
+    /// <param name="histogram">The histogram classes, band by band.</param>
+    /// <param name="size">The number of classes of all bands.</param>
+    void storeHistogram(const std::string& key, const histogram_bin* histogram, const size_t& size);
+
+    /// <summary>
+    /// Determines whether per-tile statistics are cached
+    /// </summary>
+    /// <returns>true if there are tile statistics.</returns>
+    inline bool hasTiles() const
+    {
+        return _tile_size > 0;
+    }
+
+    /// <summary>
+    /// Calculates and stores the statistics of each tile of an image; Tiles are processed in parallel.
+    /// </summary>
+    /// <param name="image">The image the cache belongs to.</param>
+    /// <param name="tile_size">The width and height of a tile.</param>
+    void buildTiles(const envi::ImageView& image, const envi::samplecount_t& tile_size = 256) throw(std::runtime_error);
+
+    /// <summary>
+    /// Calculates the statistics of a region from the tile statistics; Only the parts of the region that
+    /// don't cover whole tiles are read from the image.
+    /// </summary>
+    /// <param name="image">The image the cache belongs to.</param>
+    /// <param name="sample_first">The first sample.</param>
+    /// <param name="line_first">The first line.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>The statistics, one per band.</returns>
+    bandstats_t regionStats(const envi::ImageView& image, const envi::samplecount_t& sample_first, const envi::linecount_t& line_first, const envi::samplecount_t& samples, const envi::linecount_t& lines) const throw(std::runtime_error);
+
+    /// <summary>
+    /// Writes the sidecar file if anything was stored since it was loaded
+    /// </summary>
+    void save() const throw(std::runtime_error);
+
+private:
+    /// <summary>
+    /// Loads the sidecar file
+    /// </summary>
+    /// <returns>false if there is no sidecar file or it belongs to different file contents.</returns>
+    bool load() throw(std::runtime_error);
+
+    StatsCache(const StatsCache&);
+    StatsCache& operator=(const StatsCache&);
+};
+
+#endif
\ No newline at end of file
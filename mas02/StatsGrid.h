@@ -0,0 +1,71 @@
+#ifndef _STATSGRID_H_
+#define _STATSGRID_H_
+
+#include <memory>
+
+#include "ENVIImage.h"
+
+/// <summary>
+/// Coarse raster of the statistics of square blocks of an image: one sample per block and band in each of four
+/// small images, so that operators working on local statistics don't have to touch the full-resolution samples.
+/// Blocks at the right and bottom border may be smaller than the others.
+/// </summary>
+struct StatsGrid
+{
+    /// <summary>
+    /// The width and height of a block in samples and lines of the image
+    /// </summary>
+    const envi::samplecount_t block_size;
+
+    /// <summary>
+    /// The number of blocks per line
+    /// </summary>
+    const envi::samplecount_t samples;
+
+    /// <summary>
+    /// The number of lines of blocks
+    /// </summary>
+    const envi::linecount_t lines;
+
+    /// <summary>
+    /// The minimum value of each block, band sequential
+    /// </summary>
+    const envi::image_t min;
+
+    /// <summary>
+    /// The maximum value of each block, band sequential
+    /// </summary>
+    const envi::image_t max;
+
+    /// <summary>
+    /// The mean value of each block, band sequential
+    /// </summary>
+    const envi::image_t mean;
+
+    /// <summary>
+    /// The standard deviation of each block, band sequential
+    /// </summary>
+    const envi::image_t standard_deviation;
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="StatsGrid"/> struct with uninitialized rasters.
+    /// </summary>
+    /// <param name="samples">The number of samples per line of the image.</param>
+    /// <param name="lines">The number of lines of the image.</param>
+    /// <param name="bands">The number of bands of the image.</param>
+    /// <param name="block_size">The width and height of a block; Must be larger than 0.</param>
+    StatsGrid(const envi::samplecount_t& samples, const envi::linecount_t& lines, const envi::bandcount_t& bands, const envi::samplecount_t& block_size)
+        : block_size(block_size), samples((samples + block_size - 1) / block_size), lines((lines + block_size - 1) / block_size),
+          min(new envi::Image(this->samples, this->lines, bands)), max(new envi::Image(this->samples, this->lines, bands)),
+          mean(new envi::Image(this->samples, this->lines, bands)), standard_deviation(new envi::Image(this->samples, this->lines, bands))
+    {}
+
+private:
+    StatsGrid(const StatsGrid&);
+    StatsGrid& operator=(const StatsGrid&);
+};
+
+/// <summary>Block statistics of an image</summary>
+typedef std::unique_ptr<StatsGrid> statsgrid_t;
+
+#endif
\ No newline at end of file
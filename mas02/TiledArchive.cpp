@@ -0,0 +1,464 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "TiledArchive.h"
+
+using namespace std;
+using namespace envi;
+
+/// <summary>The first bytes of every tiled archive</summary>
+static const char archive_magic[8] = { 'E', 'N', 'V', 'I', 'T', 'I', 'L', 'E' };
+
+/// <summary>The version of the archive layout</summary>
+static const uint32_t archive_version = 1;
+
+/// <summary>The size of the archive header in bytes; The tile index follows directly</summary>
+static const size_t archive_header_size = 48;
+
+/// <summary>The size of an entry of the tile index in bytes</summary>
+static const size_t archive_tile_entry_size = 16;
+
+/// <summary>
+/// Stores a value at the given position of a buffer
+/// </summary>
+template <typename T>
+static inline void putValue(char* target, const T& value)
+{
+    memcpy(target, &value, sizeof(T));
+}
+
+/// <summary>
+/// Loads a value from the given position of a buffer
+/// </summary>
+template <typename T>
+static inline T getValue(const char* source)
+{
+    T value;
+    memcpy(&value, source, sizeof(T));
+    return value;
+}
+
+/// <summary>
+/// Determines the byte order of this machine
+/// </summary>
+/// <returns>The byte order.</returns>
+static inline ByteOrder hostByteOrder()
+{
+    const uint16_t probe = 1;
+    return (*reinterpret_cast<const uint8_t*>(&probe) == 1) ? LittleEndian : BigEndian;
+}
+
+/// <summary>
+/// Reorders the bytes of the samples so that all first bytes come first, then all second bytes, and so on.
+/// Neighbouring samples mostly share their sign and exponent bytes, which then form long runs.
+/// </summary>
+/// <param name="source">The samples.</param>
+/// <param name="target">The shuffled bytes.</param>
+/// <param name="count">The number of samples.</param>
+static void shuffleBytes(const sample_t* source, char* target, const size_t& count)
+{
+    const char* bytes = reinterpret_cast<const char*>(source);
+    for (size_t k = 0; k < sizeof(sample_t); ++k)
+    {
+        char* plane = target + k * count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            plane[i] = bytes[i * sizeof(sample_t) + k];
+        }
+    }
+}
+
+/// <summary>
+/// Restores samples from shuffled bytes
+/// </summary>
+/// <param name="source">The shuffled bytes.</param>
+/// <param name="target">The samples.</param>
+/// <param name="count">The number of samples.</param>
+static void unshuffleBytes(const char* source, sample_t* target, const size_t& count)
+{
+    char* bytes = reinterpret_cast<char*>(target);
+    for (size_t k = 0; k < sizeof(sample_t); ++k)
+    {
+        const char* plane = source + k * count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            bytes[i * sizeof(sample_t) + k] = plane[i];
+        }
+    }
+}
+
+/// <summary>
+/// Run-length encodes bytes: A control byte below 128 is followed by that many plus one literal bytes,
+/// a control byte of 128 or more is followed by a single byte that is repeated (control - 125) times.
+/// </summary>
+/// <param name="source">The bytes.</param>
+/// <param name="size">The number of bytes.</param>
+/// <param name="target">The encoded bytes; Appended to.</param>
+static void encodeRuns(const char* source, const size_t& size, vector<char>& target)
+{
+    size_t i = 0;
+    while (i < size)
+    {
+        // a run of at least three equal bytes is worth a repeat
+        size_t run = 1;
+        while (i + run < size && run < 130 && source[i + run] == source[i]) ++run;
+
+        if (run >= 3)
+        {
+            target.push_back(static_cast<char>(125 + run));
+            target.push_back(source[i]);
+            i += run;
+            continue;
+        }
+
+        // otherwise take literals up to the next run
+        const size_t first = i;
+        size_t count = 0;
+        while (i < size && count < 128)
+        {
+            if (i + 2 < size && source[i] == source[i + 1] && source[i] == source[i + 2]) break;
+            ++i;
+            ++count;
+        }
+
+        target.push_back(static_cast<char>(count - 1));
+        target.insert(target.end(), source + first, source + first + count);
+    }
+}
+
+/// <summary>
+/// Decodes run-length encoded bytes
+/// </summary>
+/// <param name="source">The encoded bytes.</param>
+/// <param name="size">The number of encoded bytes.</param>
+/// <param name="target">The decoded bytes.</param>
+/// <param name="target_size">The expected number of decoded bytes.</param>
+/// <returns>false if the encoded bytes are corrupt.</returns>
+static bool decodeRuns(const char* source, const size_t& size, char* target, const size_t& target_size)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < size)
+    {
+        const uint8_t control = static_cast<uint8_t>(source[in++]);
+        if (control < 128)
+        {
+            const size_t count = control + 1U;
+            if (in + count > size || out + count > target_size) return false;
+
+            memcpy(target + out, source + in, count);
+            in += count;
+            out += count;
+        }
+        else
+        {
+            const size_t count = control - 125U;
+            if (in >= size || out + count > target_size) return false;
+
+            memset(target + out, source[in++], count);
+            out += count;
+        }
+    }
+
+    return out == target_size;
+}
+
+/// <summary>
+/// Compresses a tile of a region; The tile's samples are stored band by band, line by line.
+/// </summary>
+/// <param name="image">The image region.</param>
+/// <param name="sample_first">The first sample of the tile.</param>
+/// <param name="line_first">The first line of the tile.</param>
+/// <param name="samples">The width of the tile.</param>
+/// <param name="lines">The height of the tile.</param>
+/// <param name="target">The tile's data.</param>
+/// <returns>The encoding of the tile's data.</returns>
+static uint32_t compressTile(const ImageView& image, const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines, vector<char>& target)
+{
+    const size_t count = static_cast<size_t>(samples) * lines * image.bands;
+    vector<sample_t> values(count);
+
+    sample_t* value = values.data();
+    for (bandcount_t b = 0; b < image.bands; ++b)
+    {
+        for (linecount_t y = 0; y < lines; ++y)
+        {
+            const sample_t* line = image.line(line_first + y, b) + sample_first * image.sample_stride;
+            for (samplecount_t x = 0; x < samples; ++x)
+            {
+                *value++ = line[x * image.sample_stride];
+            }
+        }
+    }
+
+    vector<char> shuffled(count * sizeof(sample_t));
+    shuffleBytes(values.data(), shuffled.data(), count);
+
+    target.clear();
+    encodeRuns(shuffled.data(), shuffled.size(), target);
+
+    // incompressible tiles are stored as they are
+    if (target.size() >= count * sizeof(sample_t))
+    {
+        const char* bytes = reinterpret_cast<const char*>(values.data());
+        target.assign(bytes, bytes + count * sizeof(sample_t));
+        return 0;
+    }
+
+    return 1;
+}
+
+/// <summary>
+/// Decompresses a tile
+/// </summary>
+/// <param name="source">The tile's data.</param>
+/// <param name="tile">The tile's index entry.</param>
+/// <param name="target">The tile's samples, band by band, line by line.</param>
+/// <param name="count">The number of samples of the tile.</param>
+/// <returns>false if the tile's data is corrupt.</returns>
+static bool decompressTile(const char* source, const TiledArchiveTile& tile, sample_t* target, const size_t& count)
+{
+    const size_t size = count * sizeof(sample_t);
+    switch (tile.encoding)
+    {
+        case 0:
+        {
+            if (tile.size != size) return false;
+            memcpy(target, source, size);
+            return true;
+        }
+        case 1:
+        {
+            vector<char> shuffled(size);
+            if (!decodeRuns(source, tile.size, shuffled.data(), size)) return false;
+            unshuffleBytes(shuffled.data(), target, count);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="TiledArchiveWriter"/> class.
+/// </summary>
+/// <param name="tile_size">The width and height of a tile.</param>
+TiledArchiveWriter::TiledArchiveWriter(const samplecount_t& tile_size)
+    : _tile_size(tile_size)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="TiledArchiveWriter"/> class.
+/// </summary>
+TiledArchiveWriter::~TiledArchiveWriter(void)
+{
+}
+
+/// <summary>
+/// Writes an image region into an archive; The tiles of each row of tiles are compressed in parallel.
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="path">The path of the archive.</param>
+void TiledArchiveWriter::write(const ImageView& image, const string& path) const
+{
+    if (_tile_size == 0 || _tile_size * _tile_size * image.bands * sizeof(sample_t) > UINT32_MAX) throw runtime_error("unsupported tile size for tiled archive");
+    if (image.samples == 0 || image.lines == 0) throw runtime_error("cannot archive an empty image");
+
+    const size_t tiles_x = static_cast<size_t>((image.samples + _tile_size - 1) / _tile_size);
+    const size_t tiles_y = static_cast<size_t>((image.lines + _tile_size - 1) / _tile_size);
+
+    ofstream file(path, ios_base::binary | ios_base::trunc);
+    if (!file.is_open()) throw runtime_error("Could not open tiled archive for writing");
+
+    // the header
+    char header[archive_header_size] = { 0 };
+    memcpy(header, archive_magic, sizeof(archive_magic));
+    putValue<uint32_t>(header + 8,  archive_version);
+    putValue<uint32_t>(header + 12, hostByteOrder());
+    putValue<uint64_t>(header + 16, image.samples);
+    putValue<uint64_t>(header + 24, image.lines);
+    putValue<uint32_t>(header + 32, image.bands);
+    putValue<uint32_t>(header + 36, image.interleave);
+    putValue<uint32_t>(header + 40, static_cast<uint32_t>(_tile_size));
+    file.write(header, archive_header_size);
+
+    // room for the tile index, which is only known once all tiles are written
+    vector<char> index(tiles_x * tiles_y * archive_tile_entry_size, 0);
+    file.write(index.data(), static_cast<streamsize>(index.size()));
+
+    uint64_t offset = archive_header_size + index.size();
+    vector<vector<char>> row(tiles_x);
+    vector<uint32_t> encodings(tiles_x);
+
+    typedef int_fast64_t omp_tilecount_t; // OpenMP needs signed integral type
+    const omp_tilecount_t omp_tiles_x = static_cast<omp_tilecount_t>(tiles_x);
+
+    for (size_t ty = 0; ty < tiles_y; ++ty)
+    {
+        const linecount_t line_first = ty * _tile_size;
+        const linecount_t lines = min<linecount_t>(_tile_size, image.lines - line_first);
+
+        #pragma omp parallel for schedule(dynamic)
+        for (omp_tilecount_t tx = 0; tx < omp_tiles_x; ++tx)
+        {
+            const samplecount_t sample_first = tx * _tile_size;
+            const samplecount_t samples = min<samplecount_t>(_tile_size, image.samples - sample_first);
+            encodings[tx] = compressTile(image, sample_first, line_first, samples, lines, row[tx]);
+        }
+
+        // the tiles are appended in order
+        for (size_t tx = 0; tx < tiles_x; ++tx)
+        {
+            char* entry = index.data() + (ty * tiles_x + tx) * archive_tile_entry_size;
+            putValue<uint64_t>(entry,      offset);
+            putValue<uint32_t>(entry + 8,  static_cast<uint32_t>(row[tx].size()));
+            putValue<uint32_t>(entry + 12, encodings[tx]);
+
+            file.write(row[tx].data(), static_cast<streamsize>(row[tx].size()));
+            offset += row[tx].size();
+        }
+    }
+
+    file.seekp(static_cast<streamoff>(archive_header_size));
+    file.write(index.data(), static_cast<streamsize>(index.size()));
+    if (!file) throw runtime_error("Could not write tiled archive");
+}
+
+/// <summary>
+/// Reads and validates the header of a tiled archive
+/// </summary>
+/// <param name="file">The archive.</param>
+/// <returns>The header.</returns>
+static TiledArchiveHeader readArchiveHeader(const MappedFile& file)
+{
+    const char* data = file.data();
+    if (file.size() < archive_header_size || memcmp(data, archive_magic, sizeof(archive_magic)) != 0) throw runtime_error("not a tiled archive");
+    if (getValue<uint32_t>(data + 8) != archive_version) throw runtime_error("unsupported tiled archive version");
+    if (getValue<uint32_t>(data + 12) != static_cast<uint32_t>(hostByteOrder())) throw runtime_error("tiled archive was written in a different byte order");
+
+    TiledArchiveHeader header;
+    header.samples    = getValue<uint64_t>(data + 16);
+    header.lines      = getValue<uint64_t>(data + 24);
+    header.bands      = static_cast<bandcount_t>(getValue<uint32_t>(data + 32));
+    header.interleave = static_cast<Interleave>(getValue<uint32_t>(data + 36));
+    header.tile_size  = getValue<uint32_t>(data + 40);
+    header.byte_order = hostByteOrder();
+
+    if (header.bands == 0 || getValue<uint32_t>(data + 32) > 255) throw runtime_error("unsupported number of bands in tiled archive");
+    if (getValue<uint32_t>(data + 36) > BIP) throw runtime_error("unsupported interleave in tiled archive");
+    if (header.samples == 0 || header.lines == 0) throw runtime_error("tiled archive is empty");
+
+    // the same bound as in the writer, so a single tile never exceeds the size entry of the index; Divided, so it cannot overflow
+    const uint64_t tile_limit = UINT32_MAX / (static_cast<uint64_t>(header.bands) * sizeof(sample_t));
+    if (header.tile_size == 0 || header.tile_size > tile_limit / header.tile_size) throw runtime_error("unsupported tile size in tiled archive");
+
+    return header;
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="TiledArchiveReader"/> class and reads the tile index.
+/// </summary>
+/// <param name="path">The path of the archive.</param>
+TiledArchiveReader::TiledArchiveReader(const string& path)
+    : _file(new MappedFile(path)), _header(readArchiveHeader(*_file)),
+      samples(_header.samples), lines(_header.lines), bands(_header.bands), interleave(_header.interleave), tile_size(_header.tile_size)
+{
+    // the tile index must fit into the file; Divisions instead of products, so huge dimensions cannot overflow
+    const uint64_t tiles_x = samples / tile_size + (samples % tile_size != 0 ? 1 : 0);
+    const uint64_t tiles_y = lines / tile_size + (lines % tile_size != 0 ? 1 : 0);
+    const uint64_t entries = (_file->size() - archive_header_size) / archive_tile_entry_size;
+    if (tiles_x > entries || tiles_y > entries / tiles_x) throw runtime_error("tiled archive is truncated");
+
+    _tiles.resize(static_cast<size_t>(tiles_x * tiles_y));
+    for (size_t t = 0; t < _tiles.size(); ++t)
+    {
+        const char* entry = _file->data() + archive_header_size + t * archive_tile_entry_size;
+        _tiles[t].offset   = getValue<uint64_t>(entry);
+        _tiles[t].size     = getValue<uint32_t>(entry + 8);
+        _tiles[t].encoding = getValue<uint32_t>(entry + 12);
+
+        if (_tiles[t].offset > _file->size() || _tiles[t].size > _file->size() - _tiles[t].offset) throw runtime_error("tiled archive is truncated");
+    }
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="TiledArchiveReader"/> class.
+/// </summary>
+TiledArchiveReader::~TiledArchiveReader(void)
+{
+    _file.reset();
+}
+
+/// <summary>
+/// Reads a region of the archived image
+/// </summary>
+/// <param name="sample_first">The first sample.</param>
+/// <param name="line_first">The first line.</param>
+/// <param name="samples">The number of samples.</param>
+/// <param name="lines">The number of lines.</param>
+/// <returns>The region as an image of its own.</returns>
+image_t TiledArchiveReader::read(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines) const
+{
+    if (samples == 0 || lines == 0 || sample_first + samples > this->samples || line_first + lines > this->lines) throw runtime_error("region exceeds the tiled archive");
+
+    image_t image(new Image(samples, lines, bands, interleave));
+    const size_t step = (interleave == BIP) ? bands : 1;
+
+    // only the tiles touched by the region
+    const size_t tiles_x = static_cast<size_t>((this->samples + tile_size - 1) / tile_size);
+    const size_t tx_first = static_cast<size_t>(sample_first / tile_size);
+    const size_t ty_first = static_cast<size_t>(line_first / tile_size);
+    const size_t touched_x = static_cast<size_t>((sample_first + samples - 1) / tile_size) - tx_first + 1;
+    const size_t touched_y = static_cast<size_t>((line_first + lines - 1) / tile_size) - ty_first + 1;
+
+    typedef int_fast64_t omp_tilecount_t; // OpenMP needs signed integral type
+    const omp_tilecount_t omp_tiles = static_cast<omp_tilecount_t>(touched_x * touched_y);
+
+    // exceptions must not leave the parallel region, so corrupt tiles are collected
+    vector<uint8_t> corrupt(static_cast<size_t>(omp_tiles), 0);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_tilecount_t t = 0; t < omp_tiles; ++t)
+    {
+        const size_t tx = tx_first + static_cast<size_t>(t) % touched_x;
+        const size_t ty = ty_first + static_cast<size_t>(t) / touched_x;
+        const TiledArchiveTile& tile = _tiles[ty * tiles_x + tx];
+
+        const samplecount_t tile_x = tx * tile_size;
+        const linecount_t   tile_y = ty * tile_size;
+        const samplecount_t tile_samples = min<samplecount_t>(tile_size, this->samples - tile_x);
+        const linecount_t   tile_lines = min<linecount_t>(tile_size, this->lines - tile_y);
+
+        const size_t count = static_cast<size_t>(tile_samples) * tile_lines * bands;
+        vector<sample_t> values(count);
+        if (!decompressTile(_file->data() + tile.offset, tile, values.data(), count))
+        {
+            corrupt[t] = 1;
+            continue;
+        }
+
+        // copy the part of the tile that overlaps the region
+        const samplecount_t x_first = max(sample_first, tile_x);
+        const samplecount_t x_last  = min(sample_first + samples, tile_x + tile_samples);
+        const linecount_t   y_first = max(line_first, tile_y);
+        const linecount_t   y_last  = min(line_first + lines, tile_y + tile_lines);
+
+        for (bandcount_t b = 0; b < bands; ++b)
+        {
+            for (linecount_t y = y_first; y < y_last; ++y)
+            {
+                const sample_t* source = values.data() + (static_cast<size_t>(b) * tile_lines + (y - tile_y)) * tile_samples;
+                sample_t* target = image->line(y - line_first, b);
+                for (samplecount_t x = x_first; x < x_last; ++x)
+                {
+                    target[(x - sample_first) * step] = source[x - tile_x];
+                }
+            }
+        }
+    }
+
+    if (find(corrupt.begin(), corrupt.end(), 1) != corrupt.end()) throw runtime_error("tiled archive contains a corrupt tile");
+    return image;
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+#ifndef _TILEDARCHIVE_H_
+#define _TILEDARCHIVE_H_
+
+#pragma warning( disable : 4290 ) // disable throw() not implemented by MSVC
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ENVIHeader.h"
+#include "ENVIImage.h"
+#include "MappedFile.h"
+
+namespace envi {
+
+/// <summary>
+/// The fixed-size header of a tiled archive
+/// </summary>
+struct TiledArchiveHeader
+{
+    /// <summary>The number of samples per line</summary>
+    samplecount_t samples;
+
+    /// <summary>The number of lines</summary>
+    linecount_t lines;
+
+    /// <summary>The number of bands</summary>
+    bandcount_t bands;
+
+    /// <summary>The band order of images read from the archive</summary>
+    Interleave interleave;
+
+    /// <summary>The width and height of a tile</summary>
+    samplecount_t tile_size;
+
+    /// <summary>The byte order the archive was written in</summary>
+    ByteOrder byte_order;
+};
+
+/// <summary>
+/// An entry of the tile index of a tiled archive
+/// </summary>
+struct TiledArchiveTile
+{
+    /// <summary>The position of the tile's data in the file</summary>
+    uint64_t offset;
+
+    /// <summary>The size of the tile's data in bytes</summary>
+    uint32_t size;
+
+    /// <summary>How the tile's data is encoded: 0 for plain samples, 1 for byte-shuffled and run-length encoded samples</summary>
+    uint32_t encoding;
+};
+
+/// <summary>
+/// Writes images into a tiled archive. The image is cut into square tiles, each of which is compressed independently
+/// (byte shuffle followed by run-length encoding, or stored as is if that doesn't help); A tile index after the header
+/// locates every tile, so that regions can be read without touching the other tiles.
+/// </summary>
+class TiledArchiveWriter
+{
+private:
+    /// <summary>
+    /// The width and height of a tile
+    /// </summary>
+    const samplecount_t _tile_size;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="TiledArchiveWriter"/> class.
+    /// </summary>
+    /// <param name="tile_size">The width and height of a tile.</param>
+    explicit TiledArchiveWriter(const samplecount_t& tile_size = 256);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="TiledArchiveWriter"/> class.
+    /// </summary>
+    ~TiledArchiveWriter(void);
+
+    /// <summary>
+    /// Writes an image region into an archive; The tiles of each row of tiles are compressed in parallel.
+    /// </summary>
+    /// <param name="image">The image or image region.</param>
+    /// <param name="path">The path of the archive.</param>
+    void write(const ImageView& image, const std::string& path) const throw(std::runtime_error);
+};
+
+/// <summary>
+/// Reads regions from a tiled archive. The archive is mapped into memory; Only the tiles a region touches are
+/// decompressed, in parallel.
+/// </summary>
+class TiledArchiveReader
+{
+private:
+    /// <summary>
+    /// The archive
+    /// </summary>
+    std::unique_ptr<MappedFile> _file;
+
+    /// <summary>
+    /// The header of the archive
+    /// </summary>
+    const TiledArchiveHeader _header;
+
+    /// <summary>
+    /// The tile index, row by row
+    /// </summary>
+    std::vector<TiledArchiveTile> _tiles;
+
+public:
+    /// <summary>
+    /// The number of samples per line
+    /// </summary>
+    const samplecount_t samples;
+
+    /// <summary>
+    /// The number of lines
+    /// </summary>
+    const linecount_t lines;
+
+    /// <summary>
+    /// The number of bands
+    /// </summary>
+    const bandcount_t bands;
+
+    /// <summary>
+    /// The band order of images read from the archive
+    /// </summary>
+    const Interleave interleave;
+
+    /// <summary>
+    /// The width and height of a tile
+    /// </summary>
+    const samplecount_t tile_size;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="TiledArchiveReader"/> class and reads the tile index.
+    /// </summary>
+    /// <param name="path">The path of the archive.</param>
+    explicit TiledArchiveReader(const std::string& path) throw(std::runtime_error);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="TiledArchiveReader"/> class.
+    /// </summary>
+    ~TiledArchiveReader(void);
+
+    /// <summary>
+    /// Reads a region of the archived image
+    /// </summary>
+    /// <param name="sample_first">The first sample.</param>
+    /// <param name="line_first">The first line.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>The region as an image of its own.</returns>
+    image_t read(const samplecount_t& sample_first, const linecount_t& line_first, const samplecount_t& samples, const linecount_t& lines) const throw(std::runtime_error);
+
+    /// <summary>
+    /// Reads the whole archived image
+    /// </summary>
+    /// <returns>The image.</returns>
+    inline image_t read() const throw(std::runtime_error)
+    {
+        return read(0, 0, samples, lines);
+    }
+
+    /// <summary>
+    /// Gets the size of the archive in bytes
+    /// </summary>
+    /// <returns>The size.</returns>
+    inline size_t size() const
+    {
+        return _file->size();
+    }
+
+private:
+    TiledArchiveReader(const TiledArchiveReader&);
+    TiledArchiveReader& operator=(const TiledArchiveReader&);
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -8,15 +8,17 @@
 /// <summary>
 /// Main entry point
 /// </summary>
+/// <param name="argc">The number of arguments.</param>
+/// <param name="argv">The arguments; The first one optionally names the ENVI header file of the image, the second one a tiled archive to write.</param>
 /// <returns>int.</returns>
-int main(void) 
+int main(int argc, char* argv[]) 
 {
     using namespace std;
 
     try 
     {
         unique_ptr<Application> application(new Application());
-        application->run();
+        application->run(argc > 1 ? argv[1] : "./images/rued_corr_flt.hdr", argc > 2 ? argv[2] : "");
     }
     catch(exception& e)
     {
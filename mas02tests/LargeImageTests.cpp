@@ -0,0 +1,206 @@
+#pragma warning(disable: 4996) // Disable deprecation
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "ENVIFileReader.h"
+#include "ENVIHeader.h"
+#include "ENVIImage.h"
+#include "MappedFile.h"
+
+using namespace std;
+using namespace envi;
+
+/// <summary>The number of failed checks</summary>
+static int failures = 0;
+
+/// <summary>Records a failed check, with the expression and the line it is on</summary>
+#define CHECK(condition) \
+    do { if (!(condition)) { ++failures; cerr << "FAILED (line " << __LINE__ << "): " << #condition << endl; } } while (false)
+
+/// <summary>
+/// A distinct value for every position, exact in single precision for the positions used in the tests
+/// </summary>
+/// <param name="sample">The sample.</param>
+/// <param name="line">The line.</param>
+/// <param name="band">The band.</param>
+/// <returns>The value.</returns>
+static inline sample_t valueAt(const samplecount_t& sample, const linecount_t& line, const bandcount_t& band)
+{
+    return static_cast<sample_t>((sample % 4096) + 4096 * (line % 256) + 1048576 * band);
+}
+
+/// <summary>
+/// Fills a few lines of an image, sample by sample, through <see cref="Image::line"/>
+/// </summary>
+/// <param name="image">The image.</param>
+static void fill(Image& image)
+{
+    const size_t step = image.view().sample_stride;
+    for (linecount_t y = 0; y < image.lines; ++y)
+    {
+        for (bandcount_t b = 0; b < image.bands; ++b)
+        {
+            sample_t* line = image.line(y, b);
+            for (samplecount_t x = 0; x < image.samples; ++x)
+            {
+                line[x * step] = valueAt(x, y, b);
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Images wider than 65535 samples, in all band orders: line, band and sample offsets, views and conversion between the orders
+/// </summary>
+static void testWideImages()
+{
+    const samplecount_t samples = 70000;
+    const linecount_t lines = 3;
+    const bandcount_t bands = 2;
+
+    const Interleave orders[] = { BSQ, BIL, BIP };
+    for (size_t i = 0; i < 3; ++i)
+    {
+        Image image(samples, lines, bands, orders[i]);
+        fill(image);
+
+        const ImageView view = image.view();
+        CHECK(view.sample(69999, 2, 1) == valueAt(69999, 2, 1));
+        CHECK(view.sample(65536, 1, 0) == valueAt(65536, 1, 0));
+
+        // views starting beyond 65535 samples
+        const ImageView region = view.view(66000, 1, 4000, 2);
+        CHECK(region.sample(0, 0, 1) == valueAt(66000, 1, 1));
+        CHECK(region.sample(3999, 1, 0) == valueAt(69999, 2, 0));
+        CHECK(region.band(1).sample(10, 1) == valueAt(66010, 2, 1));
+
+        // conversion to every other band order
+        for (size_t j = 0; j < 3; ++j)
+        {
+            const image_t converted = image.convert(orders[j]);
+            const ImageView target = converted->view();
+            CHECK(target.sample(69999, 2, 1) == valueAt(69999, 2, 1));
+            CHECK(target.sample(65537, 0, 0) == valueAt(65537, 0, 0));
+        }
+    }
+}
+
+/// <summary>
+/// Images taller than 65535 lines: line offsets and views
+/// </summary>
+static void testTallImages()
+{
+    const samplecount_t samples = 3;
+    const linecount_t lines = 70000;
+
+    Image image(samples, lines, 1, BSQ);
+    fill(image);
+
+    CHECK(image.line(69999) == image.data() + static_cast<size_t>(69999) * samples);
+    CHECK(image.view().sample(2, 69999) == valueAt(2, 69999, 0));
+    CHECK(image.view(1, 66000, 2, 4000).sample(1, 3999) == valueAt(2, 69999, 0));
+}
+
+/// <summary>
+/// A single-band image of more than 4 GiB, mapped from a sparse file: offsets beyond 32 bits on 64-bit builds,
+/// a clean error instead of a truncated mapping on 32-bit builds
+/// </summary>
+/// <param name="directory">The directory for the temporary file.</param>
+static void testMappedImageAbove4GiB(const string& directory)
+{
+    // 65600 x 16400 float samples are 4 303 360 000 bytes, the last sample lies beyond 4 GiB
+    const samplecount_t samples = 65600;
+    const linecount_t lines = 16400;
+    const size_t header_offset = 512;
+    const string path = directory + "/mas02tests_large.img";
+
+    const uint64_t last = static_cast<uint64_t>(lines - 1) * samples + (samples - 1);
+    const uint64_t beyond = (4ULL << 30) / sizeof(sample_t) + 12345;
+    const linecount_t beyond_line = static_cast<linecount_t>(beyond / samples);
+    const samplecount_t beyond_sample = static_cast<samplecount_t>(beyond % samples);
+
+    // only the samples written here occupy disk space
+    {
+        ofstream file(path.c_str(), ios_base::out | ios_base::binary | ios_base::trunc);
+        const sample_t first_value = valueAt(0, 0, 0);
+        const sample_t beyond_value = valueAt(beyond_sample, beyond_line, 0);
+        const sample_t last_value = valueAt(samples - 1, lines - 1, 0);
+
+        file.seekp(static_cast<streamoff>(header_offset));
+        file.write(reinterpret_cast<const char*>(&first_value), sizeof(sample_t));
+        file.seekp(static_cast<streamoff>(header_offset + beyond * sizeof(sample_t)));
+        file.write(reinterpret_cast<const char*>(&beyond_value), sizeof(sample_t));
+        file.seekp(static_cast<streamoff>(header_offset + last * sizeof(sample_t)));
+        file.write(reinterpret_cast<const char*>(&last_value), sizeof(sample_t));
+        CHECK(static_cast<bool>(file));
+    }
+
+    const ENVIHeader header(samples, lines, 1, header_offset, Float32, BSQ, LittleEndian);
+    ENVIFileReader reader(header);
+
+    if (sizeof(size_t) < 8)
+    {
+        bool rejected = false;
+        try { reader.map(path); }
+        catch (const runtime_error&) { rejected = true; }
+        CHECK(rejected);
+    }
+    else
+    {
+        const image_t image = reader.map(path);
+        const ImageView view = image->view();
+        CHECK(image->mapped());
+        CHECK(view.sample(0, 0) == valueAt(0, 0, 0));
+        CHECK(view.sample(beyond_sample, beyond_line) == valueAt(beyond_sample, beyond_line, 0));
+        CHECK(view.sample(samples - 1, lines - 1) == valueAt(samples - 1, lines - 1, 0));
+        CHECK(view.line(lines - 1) - view.line(0) == static_cast<ptrdiff_t>((lines - 1) * samples));
+        CHECK(view.view(samples - 10, lines - 1, 10, 1).sample(9, 0) == valueAt(samples - 1, lines - 1, 0));
+    }
+
+    remove(path.c_str());
+}
+
+/// <summary>
+/// Images whose number of values doesn't fit into the address space are rejected instead of being allocated too small
+/// </summary>
+static void testOversizedImages()
+{
+    if (sizeof(size_t) >= 8) return;
+
+    bool rejected = false;
+    try { Image image(70000, 70000, 1); }
+    catch (const runtime_error&) { rejected = true; }
+    CHECK(rejected);
+}
+
+/// <summary>
+/// Runs the tests for image dimensions above 65535 and buffers above 4 GiB.
+/// </summary>
+/// <param name="argc">The argument count.</param>
+/// <param name="argv">The arguments; The first one is the directory for temporary files (the current directory by default).</param>
+/// <returns>0 if all checks passed.</returns>
+int main(int argc, char* argv[])
+{
+    const string directory = (argc > 1) ? argv[1] : ".";
+
+    try
+    {
+        testWideImages();
+        testTallImages();
+        testOversizedImages();
+        testMappedImageAbove4GiB(directory);
+    }
+    catch (const exception& e)
+    {
+        ++failures;
+        cerr << "FAILED: " << e.what() << endl;
+    }
+
+    cout << (failures == 0 ? "All checks passed." : "Some checks failed.") << endl;
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -11,6 +11,9 @@
 #include <opencv/highgui.h>
 
 #include "FloatImage.h"
+#include "ImageWriter.h"
+#include "RawFrameLoader.h"
+#include "SimdReduction.h"
 #include "Application.h"
 
 using namespace std;
@@ -55,7 +58,7 @@ OpenCvWindow& Application::createWindow(const string& name)
 /// </summary>
 /// <param name="filepath">The filepath.</param>
 /// <returns>image_t.</returns>
-image_t Application::loadRawU8(const std::string filepath, const samples_t samples, const lines_t lines)
+u8image_t Application::loadRawU8(const std::string filepath, const samples_t samples, const lines_t lines)
 {
     // open the input file
     ifstream inputFile;
@@ -63,7 +66,7 @@ image_t Application::loadRawU8(const std::string filepath, const samples_t sampl
     if (!inputFile.is_open()) throw runtime_error("Could not open input file");
 
     // load the image data
-    auto image = FloatImage::createFromU8Raw(inputFile, samples, lines);
+    auto image = U8Image::createFromU8Raw(inputFile, samples, lines);
 
     // close the input file
     inputFile.close();
@@ -71,42 +74,102 @@ image_t Application::loadRawU8(const std::string filepath, const samples_t sampl
     return std::move(image);
 }
 
+/// <summary>
+/// Finds the smallest and the largest value within the upper left part of an image, and where each of them occurs first.
+/// The lines are reduced in parallel with the vector kernel selected for this processor.
+/// </summary>
+/// <param name="image">The image.</param>
+/// <param name="samples">The number of samples per line to search.</param>
+/// <param name="lines">The number of lines to search.</param>
+/// <param name="min">The smallest value.</param>
+/// <param name="min_x">The x coordinate of the smallest value.</param>
+/// <param name="min_y">The y coordinate of the smallest value.</param>
+/// <param name="max">The largest value.</param>
+/// <param name="max_x">The x coordinate of the largest value.</param>
+/// <param name="max_y">The y coordinate of the largest value.</param>
+static void findExtremes(const FloatImage& image, const samples_t& samples, const lines_t& lines, out sample_t& min, out samples_t& min_x, out lines_t& min_y, out sample_t& max, out samples_t& max_x, out lines_t& max_y)
+{
+    // OpenMP needs signed integral type
+    typedef int_fast64_t omp_linecount_t;
+    omp_linecount_t omp_lines = lines;
+
+    // array for intermediate results of each line
+    unique_ptr<sample_t[]> line_min(new sample_t[lines]);
+    unique_ptr<sample_t[]> line_max(new sample_t[lines]);
+
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
+    {
+        reduceMinMax(image.line(y).get_samples(), static_cast<size_t>(samples), line_min[y], line_max[y]);
+    }
+
+    // the first line holding the extreme values, in raster order
+    min = FLT_MAX;
+    max = -FLT_MAX;
+    min_y = 0;
+    max_y = 0;
+    for (lines_t y = 0; y < lines; ++y)
+    {
+        if (line_min[y] < min)
+        {
+            min = line_min[y];
+            min_y = y;
+        }
+        if (line_max[y] > max)
+        {
+            max = line_max[y];
+            max_y = y;
+        }
+    }
+
+    // and the first sample within these lines
+    min_x = 0;
+    max_x = 0;
+    if (lines == 0 || samples == 0) return;
+
+    const sample_t* min_line = image.line(min_y).get_samples();
+    const sample_t* max_line = image.line(max_y).get_samples();
+    min_x = static_cast<samples_t>(find(min_line, min_line + samples, min) - min_line);
+    max_x = static_cast<samples_t>(find(max_line, max_line + samples, max) - max_line);
+}
+
 /// <summary>
 /// Correlates the specified raw image with the mask
 /// </summary>
-/// <param name="raw">The raw image.</param>
+/// <param name="raw">The raw image or image region.</param>
 /// <param name="mask">The mask.</param>
 /// <param name="candidate_x">The candidate x coordinate.</param>
 /// <param name="candidate_y">The candidate y coordinate.</param>
 /// <param name="min_coeff">The minimum correlation coefficient.</param>
 /// <param name="max_coeff">The minimum correlation coefficient.</param>
 /// <returns>image displaying the correlation coefficients.</returns>
-image_t Application::correlate(const image_t& raw, const image_t& mask, samples_t& candidate_x, lines_t& candidate_y, sample_t& min_coeff, sample_t& max_coeff)
+template <typename T>
+image_t Application::correlate(const ImageView<T>& raw, const ImageView<T>& mask, samples_t& candidate_x, lines_t& candidate_y, sample_t& min_coeff, sample_t& max_coeff)
 {
     // image to hold the coefficients
-    image_t coeffs(new FloatImage(raw->samples, raw->lines, 1, true));
+    image_t coeffs(new FloatImage(raw.samples, raw.lines, 1, true));
 
-    const samples_t raw_samples     = raw->samples;
-    const lines_t raw_lines         = raw->lines;
-    const samples_t mask_samples    = mask->samples;
-    const lines_t mask_lines        = mask->lines;
+    const samples_t raw_samples     = raw.samples;
+    const lines_t raw_lines         = raw.lines;
+    const samples_t mask_samples    = mask.samples;
+    const lines_t mask_lines        = mask.lines;
 
     // get mask mean value
     const sample_t invMaskCount = 1.0F / (static_cast<sample_t>(mask_lines * mask_samples));
     sample_t mask_mean = 0.0F;
     for (lines_t my = 0; my < mask_lines; ++my) // loop all lines in mask-space
     {
-        line_t &mask_line = raw->line(my);
+        const ImageLine<T> mask_line = raw.line(my);
         for (samples_t mx = 0; mx < mask_samples; ++mx) // loop all samples in mask-space
         {
-            sample_t &mask_sample = mask_line->sample(mx);
+            const sample_t mask_sample = static_cast<sample_t>(mask_line.sample(mx));
             mask_mean += mask_sample;
         }
     }
     mask_mean *= invMaskCount;
 
     // OpenMP needs signed integral type
-    typedef int_fast32_t omp_linecount_t;
+    typedef int_fast64_t omp_linecount_t;
     omp_linecount_t omp_lines = raw_lines;
 
     // iterate over all pixels
@@ -116,7 +179,7 @@ image_t Application::correlate(const image_t& raw, const image_t& mask, samples_
     #pragma omp parallel for
     for (omp_linecount_t y = 0; y < bottommost_exclusive; ++y)
     {
-        line_t &coeffs_line = coeffs->line(y);
+        const line_t coeffs_line = coeffs->line(y);
 
         for (samples_t x = 0; x < rightmost_exclusive; ++x)
         {
@@ -125,11 +188,11 @@ image_t Application::correlate(const image_t& raw, const image_t& mask, samples_
             sample_t raw_mean = 0.0F;
             for (lines_t my = 0; my < mask_lines; ++my) // loop all lines in mask-space
             {
-                const line_t &raw_line = raw->line(y+my);
+                const ImageLine<T> raw_line = raw.line(y+my);
 
                 for (samples_t mx = 0; mx < mask_samples; ++mx) // loop all samples in mask-space
                 {
-                    const sample_t &raw_sample = raw_line->sample(x+mx);
+                    const sample_t raw_sample = static_cast<sample_t>(raw_line.sample(x+mx));
                     raw_mean += raw_sample;
                 }
             }
@@ -141,13 +204,13 @@ image_t Application::correlate(const image_t& raw, const image_t& mask, samples_
             sample_t block_mask_variance = 0.0F;
             for (lines_t my = 0; my < mask_lines; ++my) // loop all lines in mask-space
             {
-                const line_t &raw_line = raw->line(y+my);
-                const line_t &mask_line = mask->line(my);
+                const ImageLine<T> raw_line = raw.line(y+my);
+                const ImageLine<T> mask_line = mask.line(my);
 
                 for (samples_t mx = 0; mx < mask_samples; ++mx) // loop all samples in mask-space
                 {
-                    const sample_t &raw_sample = raw_line->sample(x+mx);
-                    const sample_t &mask_sample = mask_line->sample(mx);
+                    const sample_t raw_sample = static_cast<sample_t>(raw_line.sample(x+mx));
+                    const sample_t mask_sample = static_cast<sample_t>(mask_line.sample(mx));
                     
                     // calculate the errors
                     const sample_t raw_error = (raw_sample - raw_mean);
@@ -173,38 +236,17 @@ image_t Application::correlate(const image_t& raw, const image_t& mask, samples_
             const sample_t corr_coeff = block_cross_variance / sigma_raw_mask;
 
             // remember coefficients for later display
-            coeffs_line->sample(x) = corr_coeff;
+            coeffs_line.sample(x) = corr_coeff;
         }
     }
     
-    // find minimum and maximum coefficients
-    min_coeff = FLT_MAX;
-    max_coeff = FLT_MIN;
-    candidate_x = 0;
-    candidate_y = 0;
-    for (omp_linecount_t y = 0; y < bottommost_exclusive; ++y)
-    {
-        line_t &coeffs_line = coeffs->line(y);
+    // find minimum and maximum coefficients; The best match has the largest coefficient
+    samples_t min_x;
+    lines_t min_y;
+    findExtremes(*coeffs, max<samples_t>(rightmost_exclusive, 0), static_cast<lines_t>(max<omp_linecount_t>(bottommost_exclusive, 0)), min_coeff, min_x, min_y, max_coeff, candidate_x, candidate_y);
 
-        for (samples_t x = 0; x < rightmost_exclusive; ++x)
-        {
-            sample_t &sample = coeffs_line->sample(x);
-            if (sample < min_coeff)
-            {
-                min_coeff = sample;
-            }
-            if (sample > max_coeff)
-            {
-                max_coeff = sample;
-
-                candidate_x = x;
-                candidate_y = y;
-
-                // THEORY: filtering out values that are the local maximum within the neighbourhood of the mask's size yields all candidates
-                // THEORY: applying median segmentation of the grey levels of all candidates yields strong candidates
-            }
-        }
-    }
+    // THEORY: filtering out values that are the local maximum within the neighbourhood of the mask's size yields all candidates
+    // THEORY: applying median segmentation of the grey levels of all candidates yields strong candidates
 
     return coeffs;
 }
@@ -212,25 +254,26 @@ image_t Application::correlate(const image_t& raw, const image_t& mask, samples_
 /// <summary>
 /// Calculates the absolute differences between the image and the mask
 /// </summary>
-/// <param name="raw">The raw image.</param>
+/// <param name="raw">The raw image or image region.</param>
 /// <param name="mask">The mask.</param>
 /// <param name="candidate_x">The candidate x coordinate.</param>
 /// <param name="candidate_y">The candidate y coordinate.</param>
 /// <param name="min_diff">The minimum difference.</param>
 /// <param name="max_diff">The minimum difference.</param>
 /// <returns>image displaying the differences.</returns>
-image_t Application::difference(const image_t& raw, const image_t& mask, out samples_t& candidate_x, out lines_t& candidate_y, out sample_t& min_diff, out sample_t& max_diff)
+template <typename T>
+image_t Application::difference(const ImageView<T>& raw, const ImageView<T>& mask, out samples_t& candidate_x, out lines_t& candidate_y, out sample_t& min_diff, out sample_t& max_diff)
 {
     // image to hold the coefficients
-    image_t diffs(new FloatImage(raw->samples, raw->lines, 1, true));
+    image_t diffs(new FloatImage(raw.samples, raw.lines, 1, true));
 
-    const samples_t raw_samples     = raw->samples;
-    const lines_t raw_lines         = raw->lines;
-    const samples_t mask_samples    = mask->samples;
-    const lines_t mask_lines        = mask->lines;
+    const samples_t raw_samples     = raw.samples;
+    const lines_t raw_lines         = raw.lines;
+    const samples_t mask_samples    = mask.samples;
+    const lines_t mask_lines        = mask.lines;
 
     // OpenMP needs signed integral type
-    typedef int_fast32_t omp_linecount_t;
+    typedef int_fast64_t omp_linecount_t;
     omp_linecount_t omp_lines = raw_lines;
 
     // iterate over all pixels
@@ -240,59 +283,39 @@ image_t Application::difference(const image_t& raw, const image_t& mask, out sam
     #pragma omp parallel for
     for (omp_linecount_t y = 0; y < bottommost_exclusive; ++y)
     {
-        line_t &diffs_line = diffs->line(y);
+        const line_t diffs_line = diffs->line(y);
 
         for (samples_t x = 0; x < rightmost_exclusive; ++x)
         {
             // correlate the pixels in mask-space (in the area overlayed by the mask)
-            sample_t block_difference = 0.0F;
+            // integer samples are summed up natively and only normalized once per block
+            typename SampleTraits<T>::accumulator_t block_difference = 0;
             for (lines_t my = 0; my < mask_lines; ++my) // loop all lines in mask-space
             {
-                const line_t &raw_line = raw->line(y+my);
-                const line_t &mask_line = mask->line(my);
+                const ImageLine<T> raw_line = raw.line(y+my);
+                const ImageLine<T> mask_line = mask.line(my);
 
                 for (samples_t mx = 0; mx < mask_samples; ++mx) // loop all samples in mask-space
                 {
-                    const sample_t &raw_sample = raw_line->sample(x+mx);
-                    const sample_t &mask_sample = mask_line->sample(mx);
+                    const T &raw_sample = raw_line.sample(x+mx);
+                    const T &mask_sample = mask_line.sample(mx);
                     
-                    block_difference += abs(raw_sample - mask_sample);
+                    block_difference += (raw_sample > mask_sample) ? (raw_sample - mask_sample) : (mask_sample - raw_sample);
                 }
             }
 
             // remember coefficients for later display
-            diffs_line->sample(x) = block_difference;
+            diffs_line.sample(x) = static_cast<sample_t>(block_difference) * SampleTraits<T>::scale();
         }
     }
 
-    // find minimum and maximum coefficients
-    min_diff = FLT_MAX;
-    max_diff = FLT_MIN;
-    candidate_x = 0;
-    candidate_y = 0;
-    for (omp_linecount_t y = 0; y < bottommost_exclusive; ++y)
-    {
-        line_t &coeffs_line = diffs->line(y);
+    // find minimum and maximum differences; The best match has the smallest difference
+    samples_t max_x;
+    lines_t max_y;
+    findExtremes(*diffs, max<samples_t>(rightmost_exclusive, 0), static_cast<lines_t>(max<omp_linecount_t>(bottommost_exclusive, 0)), min_diff, candidate_x, candidate_y, max_diff, max_x, max_y);
 
-        for (samples_t x = 0; x < rightmost_exclusive; ++x)
-        {
-            sample_t &sample = coeffs_line->sample(x);
-            if (sample < min_diff)
-            {
-                min_diff = sample;
-
-                candidate_x = x;
-                candidate_y = y;
-
-                // THEORY: filtering out values that are the local maximum within the neighbourhood of the mask's size yields all candidates
-                // THEORY: applying median segmentation of the grey levels of all candidates yields strong candidates
-            }
-            if (sample > max_diff)
-            {
-                max_diff = sample;
-            }
-        }
-    }
+    // THEORY: filtering out values that are the local maximum within the neighbourhood of the mask's size yields all candidates
+    // THEORY: applying median segmentation of the grey levels of all candidates yields strong candidates
 
     return diffs;
 }
@@ -310,7 +333,7 @@ void Application::markCandidateInOpenCvBGR(IplImagePtr& image, const samples_t&
     assert(pixel_offset >= 0 && pixel_offset <= 2);
 
     // draw horizontal line
-    uint_fast32_t start_sample = candidate_x * 3;
+    const samples_t start_sample = candidate_x * 3;
     for (samples_t x=start_sample; x <start_sample + samples*3; x+=3)
     {
         char* top_line = &image->imageData[candidate_y * image->widthStep];
@@ -324,7 +347,7 @@ void Application::markCandidateInOpenCvBGR(IplImagePtr& image, const samples_t&
     }
 
     // draw vertical line
-    uint_fast32_t start_line = candidate_y*image->widthStep;
+    const lines_t start_line = candidate_y*image->widthStep;
     for (lines_t y=start_line; y <start_line + lines*image->widthStep; y+=image->widthStep)
     {
         char& pixel_left = image->imageData[y+ start_sample + pixel_offset];
@@ -344,20 +367,14 @@ void Application::run()
     const samples_t     raw_samples = 512;
     const lines_t       raw_lines = 512;
     
-    vector<string> raw_image_paths;
-    raw_image_paths.push_back("./images/bild0.raw");
-    raw_image_paths.push_back("./images/bild1.raw");
-    raw_image_paths.push_back("./images/bild2.raw");
-    raw_image_paths.push_back("./images/bild3.raw");
-    raw_image_paths.push_back("./images/bild4.raw");
-    raw_image_paths.push_back("./images/bild5.raw");
-    raw_image_paths.push_back("./images/bild6.raw");
-
-    vector<image_t> raw_images;
-    for (string path : raw_image_paths)
+    // all frames are loaded in parallel
+    vector<double> raw_milliseconds;
+    const vector<string> raw_image_paths = sequencePaths("./images/bild", ".raw", 0, 7);
+    vector<u8image_t> raw_images = loadRawSequence<uint8_t>(raw_image_paths, raw_samples, raw_lines, out raw_milliseconds);
+
+    for (size_t i = 0; i < raw_image_paths.size(); ++i)
     {
-        auto image = loadRawU8(path, raw_samples, raw_lines);
-        raw_images.push_back(std::move(image));
+        cout << "Loaded " << raw_image_paths[i] << " in " << raw_milliseconds[i] << " ms" << endl;
     }
     
     // === load the mask data ===
@@ -368,14 +385,14 @@ void Application::run()
 
     // === select a raw image ===
     
-    image_t& raw = raw_images[2];
+    u8image_t& raw = raw_images[2];
 
     // === correlate ===
     cout << "Calculating correlation coefficients ... ";
 
     sample_t min_coeff = FLT_MAX, max_coeff = FLT_MIN;
     samples_t corr_max_match_x = 0;
-    samples_t corr_max_match_y = 0;
+    lines_t corr_max_match_y = 0;
     auto corr_coeffs = correlate(raw, mask, corr_max_match_x, corr_max_match_y, min_coeff, max_coeff);
     cout << "done." << endl;
 
@@ -387,6 +404,8 @@ void Application::run()
     auto corr_coeff_cv = corr_coeffs->toOpenCv(0.0F, max_coeff); // ignoring all negative correlation coefficients
     corr_coeffs_window.showImage(corr_coeff_cv);
     cvSaveImage("./mas03_corr_coeffs.jpg", corr_coeff_cv.get());
+    writeENVI(corr_coeffs->view(), "./mas03_corr_coeffs");
+    writePFM(corr_coeffs->view(), "./mas03_corr_coeffs.pfm");
 
     // === build difference ===
 
@@ -394,7 +413,7 @@ void Application::run()
     
     min_coeff = FLT_MAX; max_coeff = FLT_MIN;
     samples_t diff_max_match_x = 0;
-    samples_t diff_max_match_y = 0;
+    lines_t diff_max_match_y = 0;
     auto diff_coeffs = difference(raw, mask, diff_max_match_x, diff_max_match_y, min_coeff, max_coeff);
     cout << "done." << endl;
 
@@ -406,6 +425,8 @@ void Application::run()
     auto diff_coeff_cv = diff_coeffs->toOpenCv(0.0F, max_coeff); // ignoring all negative correlation coefficients
     diff_coeffs_window.showImage(diff_coeff_cv);
     cvSaveImage("./mas03_diff_coeffs.jpg", diff_coeff_cv.get());
+    writeENVI(diff_coeffs->view(), "./mas03_diff_coeffs");
+    writePFM(diff_coeffs->view(), "./mas03_diff_coeffs.pfm");
 
     // === display raw picture ===
 
@@ -426,7 +447,7 @@ void Application::run()
     bool break_loop = false;
 
     while (!break_loop)
-    for (image_t& image : raw_images)
+    for (u8image_t& image : raw_images)
     {
         auto openCvImage = image->toOpenCv(); // todo prepare the OpenCV images
         window.showImage(openCvImage);
@@ -65,21 +65,21 @@ private:
     OpenCvWindow& createWindow(const std::string& name);
 
     /// <summary>
-    /// Loads a raw 8-bit unsigned single-channel image
+    /// Loads a raw 8-bit unsigned single-channel image; The samples are kept as 8-bit values
     /// </summary>
     /// <param name="filepath">The filepath.</param>
     /// <returns>image_t.</returns>
-    inline static image_t loadRawU8(const char* filepath, const samples_t samples, const lines_t lines) throw(std::runtime_error)
+    inline static u8image_t loadRawU8(const char* filepath, const samples_t samples, const lines_t lines) throw(std::runtime_error)
     {
         return loadRawU8(std::string(filepath), samples, lines);
     }
 
     /// <summary>
-    /// Loads a raw 8-bit unsigned single-channel image
+    /// Loads a raw 8-bit unsigned single-channel image; The samples are kept as 8-bit values
     /// </summary>
     /// <param name="filepath">The filepath.</param>
     /// <returns>image_t.</returns>
-    static image_t loadRawU8(const std::string filepath, const samples_t samples, const lines_t lines) throw(std::runtime_error);
+    static u8image_t loadRawU8(const std::string filepath, const samples_t samples, const lines_t lines) throw(std::runtime_error);
 
     /// <summary>
     /// Correlates the specified raw image with the mask
@@ -91,7 +91,24 @@ private:
     /// <param name="min_coeff">The minimum correlation coefficient.</param>
     /// <param name="max_coeff">The minimum correlation coefficient.</param>
     /// <returns>image displaying the correlation coefficients.</returns>
-    static image_t correlate(const image_t& raw, const image_t& mask, out samples_t& candidate_x, out lines_t& candidate_y, out sample_t& min_coeff, out sample_t& max_coeff);
+    template <typename T>
+    static inline image_t correlate(const std::unique_ptr<Image<T>>& raw, const std::unique_ptr<Image<T>>& mask, out samples_t& candidate_x, out lines_t& candidate_y, out sample_t& min_coeff, out sample_t& max_coeff)
+    {
+        return correlate(raw->view(), mask->view(), candidate_x, candidate_y, min_coeff, max_coeff);
+    }
+
+    /// <summary>
+    /// Correlates the specified raw image with the mask
+    /// </summary>
+    /// <param name="raw">The raw image or image region.</param>
+    /// <param name="mask">The mask.</param>
+    /// <param name="candidate_x">The candidate x coordinate.</param>
+    /// <param name="candidate_y">The candidate y coordinate.</param>
+    /// <param name="min_coeff">The minimum correlation coefficient.</param>
+    /// <param name="max_coeff">The minimum correlation coefficient.</param>
+    /// <returns>image displaying the correlation coefficients.</returns>
+    template <typename T>
+    static image_t correlate(const ImageView<T>& raw, const ImageView<T>& mask, out samples_t& candidate_x, out lines_t& candidate_y, out sample_t& min_coeff, out sample_t& max_coeff);
 
     /// <summary>
     /// Calculates the absolute differences between the image and the mask
@@ -103,7 +120,24 @@ private:
     /// <param name="min_diff">The minimum difference.</param>
     /// <param name="max_diff">The minimum difference.</param>
     /// <returns>image displaying the differences.</returns>
-    static image_t difference(const image_t& raw, const image_t& mask, out samples_t& candidate_x, out lines_t& candidate_y, out sample_t& min_diff, out sample_t& max_diff);
+    template <typename T>
+    static inline image_t difference(const std::unique_ptr<Image<T>>& raw, const std::unique_ptr<Image<T>>& mask, out samples_t& candidate_x, out lines_t& candidate_y, out sample_t& min_diff, out sample_t& max_diff)
+    {
+        return difference(raw->view(), mask->view(), candidate_x, candidate_y, min_diff, max_diff);
+    }
+
+    /// <summary>
+    /// Calculates the absolute differences between the image and the mask
+    /// </summary>
+    /// <param name="raw">The raw image or image region.</param>
+    /// <param name="mask">The mask.</param>
+    /// <param name="candidate_x">The candidate x coordinate.</param>
+    /// <param name="candidate_y">The candidate y coordinate.</param>
+    /// <param name="min_diff">The minimum difference.</param>
+    /// <param name="max_diff">The minimum difference.</param>
+    /// <returns>image displaying the differences.</returns>
+    template <typename T>
+    static image_t difference(const ImageView<T>& raw, const ImageView<T>& mask, out samples_t& candidate_x, out lines_t& candidate_y, out sample_t& min_diff, out sample_t& max_diff);
 
     /// <summary>
     /// Marks the candidate in an OpenCV BGR image.
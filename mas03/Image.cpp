@@ -0,0 +1,145 @@
+#include <cstring>
+
+#include "Image.h"
+
+using namespace std;
+
+/// <summary>
+/// Builds the lookup table mapping 8-bit samples to display values
+/// </summary>
+/// <param name="min">The sample value mapped to black.</param>
+/// <param name="max">The sample value mapped to white.</param>
+/// <param name="table">The table to fill.</param>
+static void buildU8DisplayTable(const uint8_t& min, const uint8_t& max, char (&table)[256])
+{
+    const float lerp_scaling = 255.0F / static_cast<float>(max - min);
+    for (uint_fast16_t value = 0; value < 256; ++value)
+    {
+        const float sample = (static_cast<float>(value) - static_cast<float>(min)) * lerp_scaling;
+        table[value] = static_cast<char>(static_cast<uint8_t>(std::min(std::max(sample, 0.0F), 255.0F)));
+    }
+}
+
+/// <summary>
+/// Converts the region to OpenCV (8-bit path, no float conversion)
+/// </summary>
+/// <param name="min">The sample value mapped to black.</param>
+/// <param name="max">The sample value mapped to white.</param>
+/// <returns>The converted image</returns>
+template <>
+IplImagePtr ImageView<uint8_t>::toOpenCv(const uint8_t& min, const uint8_t& max) const
+{
+    assert(bands >= 1 && bands <= 4);
+    assert(min < max);
+
+    IplImagePtr displayImage(cvCreateImage(cvSize(static_cast<int>(samples), static_cast<int>(lines)), IPL_DEPTH_8U, bands));
+    samples_t step = displayImage->widthStep;
+    const samples_t values = samples * bands;
+
+    // full range: the samples already are display values
+    const bool identity = (min == 0 && max == 255);
+
+    char table[256];
+    buildU8DisplayTable(min, max, table);
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    #pragma omp parallel for
+    for(omp_linecount_t y=0; y<omp_lines; ++y)
+    {
+        const uint8_t* line = this->line(y).get_samples();
+        char* pixels = &displayImage->imageData[y*step];
+
+        if (identity)
+        {
+            memcpy(pixels, line, values);
+            continue;
+        }
+
+        for(samples_t x=0; x<values; ++x)
+        {
+            pixels[x] = table[line[x]];
+        }
+    }
+    return displayImage;
+}
+
+/// <summary>
+/// Converts the region to a three-channel OpenCV image (8-bit path, no float conversion)
+/// </summary>
+/// <param name="min">The sample value mapped to black.</param>
+/// <param name="max">The sample value mapped to white.</param>
+/// <returns>The converted image</returns>
+template <>
+IplImagePtr ImageView<uint8_t>::toOpenCvBGR(const uint8_t& min, const uint8_t& max) const
+{
+    // three bands already are BGR
+    if (bands == 3) return toOpenCv(min, max);
+
+    assert(bands == 1);
+    assert(min < max);
+
+    IplImagePtr displayImage(cvCreateImage(cvSize(static_cast<int>(samples), static_cast<int>(lines)), IPL_DEPTH_8U, 3));
+    samples_t step = displayImage->widthStep;
+
+    char table[256];
+    buildU8DisplayTable(min, max, table);
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    #pragma omp parallel for
+    for(omp_linecount_t y=0; y<omp_lines; ++y)
+    {
+        const uint8_t* line = this->line(y).get_samples();
+        char* pixels = &displayImage->imageData[y*step];
+
+        for(samples_t x=0; x<samples; ++x)
+        {
+            const char pixel = table[line[x]];
+            pixels[3*x + 0] = pixel;
+            pixels[3*x + 1] = pixel;
+            pixels[3*x + 2] = pixel;
+        }
+    }
+    return displayImage;
+}
+
+/// <summary>
+/// Converts the region to OpenCV (16-bit path, fixed point instead of float conversion)
+/// </summary>
+/// <param name="min">The sample value mapped to black.</param>
+/// <param name="max">The sample value mapped to white.</param>
+/// <returns>The converted image</returns>
+template <>
+IplImagePtr ImageView<uint16_t>::toOpenCv(const uint16_t& min, const uint16_t& max) const
+{
+    assert(bands >= 1 && bands <= 4);
+    assert(min < max);
+
+    IplImagePtr displayImage(cvCreateImage(cvSize(static_cast<int>(samples), static_cast<int>(lines)), IPL_DEPTH_8U, bands));
+    samples_t step = displayImage->widthStep;
+    const samples_t values = samples * bands;
+
+    // 32.32 fixed point scaling factor, rounded up so that truncation matches exact integer division
+    const uint_fast64_t range = max - min;
+    const uint_fast64_t lerp_scaling = ((static_cast<uint_fast64_t>(255) << 32) + range - 1) / range;
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    #pragma omp parallel for
+    for(omp_linecount_t y=0; y<omp_lines; ++y)
+    {
+        const uint16_t* line = this->line(y).get_samples();
+        char* pixels = &displayImage->imageData[y*step];
+
+        for(samples_t x=0; x<values; ++x)
+        {
+            const uint16_t value = std::min(std::max(line[x], min), max);
+            pixels[x] = static_cast<char>(((value - min) * lerp_scaling) >> 32);
+        }
+    }
+    return displayImage;
+}
\ No newline at end of file
@@ -0,0 +1,1457 @@
+#ifndef _IMAGE_H_
+#define _IMAGE_H_
+
+#pragma warning(disable: 4290)
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <emmintrin.h>
+
+#include "ImagePool.h"
+#include "OpenCvImage.h"
+
+typedef int_fast64_t samples_t;
+typedef uint_fast64_t lines_t;
+typedef int_fast64_t ssamples_t; // signed sample count - used for kernel offset
+typedef int_fast64_t slines_t; // signed line count - used for kernel offset
+typedef uint_fast8_t  bands_t;
+typedef uint_fast64_t imagesize_t;
+
+/// <summary>
+/// Describes the value range of a sample type.
+/// Floating point images are normalized to 0..1, integer images use their full range.
+/// </summary>
+template <typename T> struct SampleTraits;
+
+template <> struct SampleTraits<float>
+{
+    /// <summary>Type used to accumulate sums of samples</summary>
+    typedef float accumulator_t;
+
+    /// <summary>The value of a white sample.</summary>
+    static inline float white() { return 1.0F; }
+
+    /// <summary>Scaling factor from a sample to its normalized float value.</summary>
+    static inline float scale() { return 1.0F; }
+
+    /// <summary>Converts an unsigned 8-bit value (0..255) to a sample.</summary>
+    static inline float fromU8(const uint8_t value) { return static_cast<float>(value) * (1.0F / 255.0F); }
+
+    /// <summary>Converts a normalized float value to a sample.</summary>
+    static inline float fromFloat(const float value) { return value; }
+
+    /// <summary>Converts a value in the range of the sample type to a sample, rounding and saturating integer samples.</summary>
+    static inline float saturate(const float value) { return value; }
+};
+
+template <> struct SampleTraits<double>
+{
+    typedef double accumulator_t;
+    static inline double white() { return 1.0; }
+    static inline float scale() { return 1.0F; }
+    static inline double fromU8(const uint8_t value) { return static_cast<double>(value) * (1.0 / 255.0); }
+    static inline double fromFloat(const float value) { return value; }
+    static inline double saturate(const float value) { return value; }
+};
+
+template <> struct SampleTraits<uint8_t>
+{
+    typedef uint_fast32_t accumulator_t;
+    static inline uint8_t white() { return 255U; }
+    static inline float scale() { return 1.0F / 255.0F; }
+    static inline uint8_t fromU8(const uint8_t value) { return value; }
+    static inline uint8_t fromFloat(const float value) { return static_cast<uint8_t>(std::min(std::max(value * 255.0F + 0.5F, 0.0F), 255.0F)); }
+    static inline uint8_t saturate(const float value) { return static_cast<uint8_t>(std::min(std::max(0.0F, value + 0.5F), 255.0F)); }
+};
+
+template <> struct SampleTraits<uint16_t>
+{
+    typedef uint_fast32_t accumulator_t;
+    static inline uint16_t white() { return 65535U; }
+    static inline float scale() { return 1.0F / 65535.0F; }
+    static inline uint16_t fromU8(const uint8_t value) { return static_cast<uint16_t>(value * 257U); }
+    static inline uint16_t fromFloat(const float value) { return static_cast<uint16_t>(std::min(std::max(value * 65535.0F + 0.5F, 0.0F), 65535.0F)); }
+    static inline uint16_t saturate(const float value) { return static_cast<uint16_t>(std::min(std::max(0.0F, value + 0.5F), 65535.0F)); }
+};
+
+/// <summary>
+/// Conversion of unsigned 8-bit values (0..255) to samples: a lookup table of all 256 results and,
+/// for vectorized conversion to floating point, the equivalent linear mapping value * scale + offset.
+/// </summary>
+template <typename T>
+struct U8Conversion
+{
+    /// <summary>The sample of each 8-bit value.</summary>
+    T table[256];
+
+    /// <summary>The factor of the linear mapping.</summary>
+    float scale;
+
+    /// <summary>The offset of the linear mapping.</summary>
+    float offset;
+
+    /// <summary>
+    /// Initializes the default conversion of the sample type, see <see cref="SampleTraits::fromU8"/>.
+    /// </summary>
+    U8Conversion()
+        : scale(static_cast<float>(SampleTraits<T>::white()) * (1.0F / 255.0F)), offset(0.0F)
+    {
+        for (uint_fast16_t value = 0; value < 256; ++value)
+        {
+            table[value] = SampleTraits<T>::fromU8(static_cast<uint8_t>(value));
+        }
+    }
+
+    /// <summary>
+    /// Initializes a conversion that maps 0 to <paramref name="to_min"/> and 255 to <paramref name="to_max"/>.
+    /// </summary>
+    /// <param name="to_min">The target range's minimum value.</param>
+    /// <param name="to_max">The target range's maximum value.</param>
+    U8Conversion(const T& to_min, const T& to_max)
+        : scale((static_cast<float>(to_max) - static_cast<float>(to_min)) * (1.0F / 255.0F)), offset(static_cast<float>(to_min))
+    {
+        // integer samples are rounded to the nearest value
+        const float rounding = std::numeric_limits<T>::is_integer ? 0.5F : 0.0F;
+        for (uint_fast16_t value = 0; value < 256; ++value)
+        {
+            table[value] = static_cast<T>(static_cast<float>(value) * scale + offset + rounding);
+        }
+    }
+};
+
+/// <summary>
+/// Converts a line of unsigned 8-bit values to samples using the lookup table
+/// </summary>
+/// <param name="source">The 8-bit values.</param>
+/// <param name="target">The samples.</param>
+/// <param name="count">The number of values.</param>
+/// <param name="conversion">The conversion.</param>
+template <typename T>
+inline void convertU8Line(const uint8_t* source, T* target, const samples_t& count, const U8Conversion<T>& conversion)
+{
+    for (samples_t x = 0; x < count; ++x)
+    {
+        target[x] = conversion.table[source[x]];
+    }
+}
+
+/// <summary>
+/// Converts a line of unsigned 8-bit values to float samples, sixteen values at a time (SSE2)
+/// </summary>
+/// <param name="source">The 8-bit values.</param>
+/// <param name="target">The samples.</param>
+/// <param name="count">The number of values.</param>
+/// <param name="conversion">The conversion.</param>
+inline void convertU8Line(const uint8_t* source, float* target, const samples_t& count, const U8Conversion<float>& conversion)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(conversion.scale);
+    const __m128 offset = _mm_set1_ps(conversion.offset);
+
+    const samples_t blocks = count / 16;
+    for (samples_t block = 0; block < blocks; ++block)
+    {
+        // widen the bytes to 16 and then to 32 bit integers
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16 * block));
+        const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+
+        __m128i values[4];
+        values[0] = _mm_unpacklo_epi16(low, zero);
+        values[1] = _mm_unpackhi_epi16(low, zero);
+        values[2] = _mm_unpacklo_epi16(high, zero);
+        values[3] = _mm_unpackhi_epi16(high, zero);
+
+        float* block_target = target + 16 * block;
+        for (uint_fast8_t i = 0; i < 4; ++i)
+        {
+            _mm_storeu_ps(block_target + 4 * i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(values[i]), scale), offset));
+        }
+    }
+
+    // the remaining values are taken from the table
+    for (samples_t x = 16 * blocks; x < count; ++x)
+    {
+        target[x] = conversion.table[source[x]];
+    }
+}
+
+/// <summary>
+/// Describes how the halo around an image is filled from the image itself
+/// </summary>
+enum BorderPolicy
+{
+    /// <summary>Every halo sample has the same, given value</summary>
+    BorderConstant,
+
+    /// <summary>Repeats the outermost sample: aaa|abcd|ddd</summary>
+    BorderReplicate,
+
+    /// <summary>Mirrors the image at the outermost sample, without repeating it: dcb|abcd|cba</summary>
+    BorderMirror,
+
+    /// <summary>Continues with the opposite side of the image: bcd|abcd|abc</summary>
+    BorderWrap
+};
+
+/// <summary>
+/// Maps a sample or line index outside of the image to the index it is taken from according to the border policy
+/// </summary>
+/// <param name="index">The index; may be negative or exceed the image.</param>
+/// <param name="count">The number of samples or lines of the image.</param>
+/// <param name="policy">The border policy; Must not be <see cref="BorderConstant"/>.</param>
+/// <returns>The index within the image.</returns>
+inline samples_t borderIndex(samples_t index, const samples_t& count, const BorderPolicy& policy)
+{
+    assert(count > 0);
+    switch (policy)
+    {
+        case BorderReplicate:
+            return std::min<samples_t>(std::max<samples_t>(index, 0), count - 1);
+
+        case BorderMirror:
+        {
+            if (count == 1) return 0;
+            const samples_t period = 2 * (count - 1);
+            index %= period;
+            if (index < 0) index += period;
+            return (index < count) ? index : period - index;
+        }
+
+        case BorderWrap:
+            index %= count;
+            return (index < 0) ? index + count : index;
+
+        default:
+            assert(false);
+            return index;
+    }
+}
+
+/// <summary>
+/// Base of all lazily evaluated, pointwise image expressions (see ImageExpression.h).
+/// Expressions are evaluated per value (sample and band) in single precision.
+/// </summary>
+template <typename E>
+struct ImageExpression
+{
+    /// <summary>
+    /// Gets the actual expression
+    /// </summary>
+    /// <returns>The expression.</returns>
+    inline const E& self() const
+    {
+        return static_cast<const E&>(*this);
+    }
+};
+
+/// <summary>
+/// Lightweight, non-owning view of a single image line
+/// </summary>
+template <typename T>
+class ImageLine
+{
+private:
+    T* _line;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ImageLine"/> class.
+    /// </summary>
+    /// <param name="line">Pointer to the first sample of the line.</param>
+    explicit ImageLine(T* line)
+        : _line(line)
+    {}
+
+    /// <summary>
+    /// Gets a pointer to the samples.
+    /// </summary>
+    /// <returns>T *.</returns>
+    inline T* get_samples() const
+    {
+        return _line;
+    }
+
+    /// <summary>
+    /// Gets the sample at the given position
+    /// </summary>
+    /// <param name="sample">The sample.</param>
+    /// <returns>T &.</returns>
+    inline T& sample(const samples_t& sample) const
+    {
+        return _line[sample];
+    }
+
+    /// <summary>
+    /// Gets the sample at the given position
+    /// </summary>
+    /// <param name="sample">The sample.</param>
+    /// <returns>T &.</returns>
+    inline T& operator[](const samples_t& sample) const
+    {
+        return _line[sample];
+    }
+
+    /// <summary>
+    /// Sets a sample while lerp'ing it to the range of the sample type
+    /// </summary>
+    /// <param name="sample">The sample.</param>
+    /// <param name="value">The value.</param>
+    inline void lerpSet(const samples_t& sample, const uint8_t value) const
+    {
+        _line[sample] = SampleTraits<T>::fromU8(value);
+    }
+
+    /// <summary>
+    /// Sets a sample while lerp'ing it to the given range
+    /// </summary>
+    /// <param name="sample">The sample.</param>
+    /// <param name="value">The value.</param>
+    /// <param name="to_min">The target range's minimum value.</param>
+    /// <param name="to_max">The target range's maximum value.</param>
+    inline void lerpSet(const samples_t& sample, const uint8_t value, const T& to_min, const T& to_max) const
+    {
+        _line[sample] = static_cast<T>(static_cast<float>(value) * (1.0F / 255.0F) * (to_max - to_min) + to_min);
+    }
+};
+
+template <typename T> class Image;
+
+/// <summary>
+/// Non-owning view of a rectangular region of an <see cref="Image"/>.
+/// The view does not extend the lifetime of its parent image; It must not outlive it.
+/// </summary>
+template <typename T>
+class ImageView : public ImageExpression<ImageView<T>>
+{
+private:
+    /// <summary>
+    /// The first sample of the region
+    /// </summary>
+    T* _origin;
+
+    /// <summary>
+    /// The image the region belongs to
+    /// </summary>
+    const Image<T>* _parent;
+
+public:
+    /// <summary>
+    /// The number of samples (width)
+    /// </summary>
+    const samples_t samples;
+
+    /// <summary>
+    /// The number of lines (height)
+    /// </summary>
+    const lines_t lines;
+
+    /// <summary>
+    /// The number of color bands
+    /// </summary>
+    const bands_t bands;
+
+    /// <summary>
+    /// The distance between two consecutive lines in values (samples times bands, plus padding)
+    /// </summary>
+    const samples_t stride;
+
+    /// <summary>
+    /// The number of samples and lines around the region on every side that may be read, either because they
+    /// belong to the parent image or to its halo
+    /// </summary>
+    const samples_t halo;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ImageView"/> class.
+    /// </summary>
+    /// <param name="parent">The image the region belongs to.</param>
+    /// <param name="origin">The first sample of the region.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="bands">The number of bands.</param>
+    /// <param name="stride">The line stride in values.</param>
+    /// <param name="halo">The number of readable samples and lines around the region.</param>
+    ImageView(const Image<T>* parent, T* origin, const samples_t& samples, const lines_t& lines, const bands_t& bands, const samples_t& stride, const samples_t& halo = 0)
+        : _origin(origin), _parent(parent), samples(samples), lines(lines), bands(bands), stride(stride), halo(halo)
+    {}
+
+    /// <summary>
+    /// Gets the image the region belongs to
+    /// </summary>
+    /// <returns>The parent image.</returns>
+    inline const Image<T>& parent() const
+    {
+        return *_parent;
+    }
+
+    /// <summary>
+    /// Gets a pointer to the first sample of the region
+    /// </summary>
+    /// <returns>T *.</returns>
+    inline T* data() const
+    {
+        return _origin;
+    }
+
+    /// <summary>
+    /// Gets the given line
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>View of the line.</returns>
+    inline ImageLine<T> line(const lines_t& line) const
+    {
+        return ImageLine<T>(_origin + line * stride);
+    }
+
+    /// <summary>
+    /// Gets the given line, which may be one of the <see cref="halo"/> lines above or below the region
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>View of the line; Samples left and right of the region may be read as well.</returns>
+    inline ImageLine<T> haloLine(const slines_t& line) const
+    {
+        assert(line >= -halo && line < static_cast<slines_t>(lines) + halo);
+        return ImageLine<T>(_origin + line * stride);
+    }
+
+    /// <summary>
+    /// Gets the sample at the given position
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <param name="sample">The sample.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>Reference to the sample.</returns>
+    inline T& sample(const lines_t& line, const samples_t& sample, const bands_t& band = 0) const
+    {
+        return _origin[line * stride + sample * bands + band];
+    }
+
+    /// <summary>
+    /// Gets the given line
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>View of the line.</returns>
+    inline ImageLine<T> operator[](const lines_t& line) const
+    {
+        return this->line(line);
+    }
+
+    /// <summary>
+    /// Sets the specified sample to the given value.
+    /// </summary>
+    /// <param name="sample">The sample.</param>
+    /// <param name="line">The line.</param>
+    /// <param name="value">The value.</param>
+    inline void set(const samples_t& sample, const lines_t& line, const T& value) const
+    {
+        _origin[line * stride + sample * bands] = value;
+    }
+
+    /// <summary>
+    /// Evaluates the region as part of an <see cref="ImageExpression"/>
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <param name="value">The value within the line (sample times bands plus band).</param>
+    /// <returns>The value.</returns>
+    inline float evaluate(const lines_t& line, const samples_t& value) const
+    {
+        return static_cast<float>(_origin[line * stride + value]);
+    }
+
+    /// <summary>
+    /// Determines whether the region has the given size, as part of an <see cref="ImageExpression"/>
+    /// </summary>
+    /// <param name="values">The number of values per line.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>true if the size matches.</returns>
+    inline bool matches(const samples_t& values, const lines_t& lines) const
+    {
+        return values == samples * bands && lines == this->lines;
+    }
+
+    /// <summary>
+    /// Evaluates the expression and stores the result in the region, in a single pass
+    /// </summary>
+    /// <param name="expression">The expression.</param>
+    template <typename E>
+    void assign(const ImageExpression<E>& expression) const;
+
+    /// <summary>
+    /// Gets a view of a region within this region
+    /// </summary>
+    /// <param name="sample_first">The first sample, relative to this region.</param>
+    /// <param name="line_first">The first line, relative to this region.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>The view.</returns>
+    inline ImageView view(const samples_t& sample_first, const lines_t& line_first, const samples_t& samples, const lines_t& lines) const
+    {
+        assert(sample_first >= 0 && sample_first + samples <= this->samples);
+        assert(line_first + lines <= this->lines);
+
+        // the sub-region can read the rest of this region as well as this region's halo
+        const samples_t halo = this->halo + std::min(
+            std::min<samples_t>(sample_first, this->samples - sample_first - samples),
+            std::min<samples_t>(line_first, this->lines - line_first - lines));
+
+        return ImageView(_parent, _origin + line_first * stride + sample_first * bands, samples, lines, bands, stride, halo);
+    }
+
+    /// <summary>
+    /// Copies the region into a new image
+    /// </summary>
+    /// <returns>The image</returns>
+    std::unique_ptr<Image<T>> clone() const;
+
+    /// <summary>
+    /// Copies the region into a new image with a halo, filled according to the given border policy.
+    /// Neighborhood operators on the new image can read up to <paramref name="halo"/> samples beyond it without bounds checks.
+    /// </summary>
+    /// <param name="halo">The number of samples and lines around the image.</param>
+    /// <param name="policy">The border policy.</param>
+    /// <param name="value">The value of the halo for <see cref="BorderConstant"/>.</param>
+    /// <returns>The image</returns>
+    std::unique_ptr<Image<T>> pad(const samples_t& halo, const BorderPolicy& policy, const T& value = 0) const;
+
+    /// <summary>
+    /// Copies the region into a new image of another sample type, mapping between the value ranges of both types
+    /// </summary>
+    /// <returns>The image</returns>
+    template <typename U>
+    std::unique_ptr<Image<U>> convert() const;
+
+    /// <summary>
+    /// Converts the region to OpenCV; The bands are passed through as channels (i.e. three bands are expected in BGR order).
+    /// </summary>
+    /// <param name="min">The sample value mapped to black.</param>
+    /// <param name="max">The sample value mapped to white.</param>
+    /// <returns>The converted image</returns>
+    IplImagePtr toOpenCv(const T& min = 0, const T& max = SampleTraits<T>::white()) const;
+
+    /// <summary>
+    /// Converts the region to a three-channel OpenCV image; Single-band regions are converted to gray.
+    /// </summary>
+    /// <param name="min">The sample value mapped to black.</param>
+    /// <param name="max">The sample value mapped to white.</param>
+    /// <returns>The converted image</returns>
+    IplImagePtr toOpenCvBGR(const T& min = 0, const T& max = SampleTraits<T>::white()) const;
+
+    /// <summary>
+    /// Convolves the region with the given kernel; Samples outside of the region are read from the <see cref="halo"/>
+    /// if it covers the kernel, and treated as missing otherwise. The result is a normalized float image.
+    /// </summary>
+    /// <param name="kernel">The kernel.</param>
+    /// <returns>The convolved image.</returns>
+    std::unique_ptr<Image<float>> convolve(const ImageView<float>& kernel) const;
+
+private:
+    /// <summary>
+    /// Convolves all bands of the region with the given kernel into the target region.
+    /// If <typeparamref name="PADDED"/> is set, the halo covers the kernel and no bounds are checked.
+    /// </summary>
+    /// <param name="kernel">The kernel.</param>
+    /// <param name="target">The target region of the same size.</param>
+    template <bands_t BANDS, bool PADDED>
+    void convolveBands(const ImageView<float>& kernel, const ImageView<float>& target) const;
+};
+
+/// <summary>
+/// Image of samples of type <typeparamref name="T"/>.
+/// Bands are stored band-interleaved-by-pixel (BIP), i.e. all bands of a sample are adjacent, just like OpenCV stores its channels.
+/// </summary>
+template <typename T>
+class Image : public ImageExpression<Image<T>>
+{
+public:
+    /// <summary>
+    /// The alignment of the sample buffer and of each line in bytes (one cache line)
+    /// </summary>
+    static const size_t alignment = ImagePool::alignment;
+
+private:
+    /// <summary>
+    /// The image data; all lines (including the halo) in a single allocation, <see cref="stride"/> samples apart.
+    /// The buffer is drawn from and handed back to the <see cref="ImagePool"/>.
+    /// </summary>
+    std::unique_ptr<T[], PooledDeleter> _image;
+
+    /// <summary>
+    /// The first sample of the image within the buffer, i.e. behind the halo
+    /// </summary>
+    T* _origin;
+
+public:
+    /// <summary>
+    /// The number of samples (width)
+    /// </summary>
+    const samples_t samples;
+
+    /// <summary>
+    /// The number of lines (height)
+    /// </summary>
+    const lines_t lines;
+
+    /// <summary>
+    /// The number of color bands
+    /// </summary>
+    const bands_t bands;
+
+    /// <summary>
+    /// The image size
+    /// </summary>
+    const imagesize_t size;
+
+    /// <summary>
+    /// The number of samples and lines allocated around the image on every side (see <see cref="fillBorder"/>)
+    /// </summary>
+    const samples_t halo;
+
+    /// <summary>
+    /// The distance between two consecutive lines in values (samples times bands plus halo, padded to the alignment)
+    /// </summary>
+    const samples_t stride;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="Image"/> class.
+    /// </summary>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <param name="bands">The number of bands.</param>
+    /// <param name="zero">If true the pixels (and the halo) will be initialized to zero.</param>
+    /// <param name="halo">The number of samples and lines to allocate around the image.</param>
+    Image(const samples_t& samples, const lines_t& lines, const bands_t& bands, bool zero = true, const samples_t& halo = 0) throw(std::runtime_error)
+        : samples(samples), lines(lines), bands(bands), size(samples * lines), halo(halo),
+          stride(alignedStride(alignedStride(halo * bands) + (samples + halo) * bands))
+    {
+        assert(halo >= 0);
+
+        // a single (recycled) buffer for all lines instead of one allocation per line; a 32-bit process cannot address 4 GiB and more
+        const uint64_t total_bytes = static_cast<uint64_t>(stride) * (lines + 2 * halo) * sizeof(T);
+        if (total_bytes > std::numeric_limits<size_t>::max()) throw std::runtime_error("Image is too large for the address space");
+
+        const size_t bytes = static_cast<size_t>(total_bytes);
+        _image = std::unique_ptr<T[], PooledDeleter>(static_cast<T*>(ImagePool::instance().acquire(bytes)), PooledDeleter(bytes));
+
+        // the left halo is padded to the alignment as well, so that the lines of the image itself stay aligned
+        _origin = _image.get() + halo * stride + alignedStride(halo * bands);
+
+        // initialize to zero if requested
+        if (zero)
+        {
+            memset(_image.get(), 0, bytes);
+        }
+    }
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="Image"/> class.
+    /// </summary>
+    virtual ~Image()
+    {
+        _image.reset();
+    }
+
+    /// <summary>
+    /// Gets a pointer to the first sample of the image
+    /// </summary>
+    /// <returns>T *.</returns>
+    inline T* data() const
+    {
+        return _origin;
+    }
+
+    /// <summary>
+    /// Gets the given line
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>View of the line.</returns>
+    inline ImageLine<T> line(const lines_t& line) const
+    {
+        return ImageLine<T>(_origin + line * stride);
+    }
+
+    /// <summary>
+    /// Gets the sample at the given position
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <param name="sample">The sample.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>Reference to the sample.</returns>
+    inline T& sample(const lines_t& line, const samples_t& sample, const bands_t& band = 0) const
+    {
+        return _origin[line * stride + sample * bands + band];
+    }
+
+    /// <summary>
+    /// Gets the given line
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>View of the line.</returns>
+    inline ImageLine<T> operator[](const lines_t& line) const
+    {
+        return this->line(line);
+    }
+
+    /// <summary>
+    /// Sets the specified sample to the given value.
+    /// </summary>
+    /// <param name="sample">The sample.</param>
+    /// <param name="line">The line.</param>
+    /// <param name="value">The value.</param>
+    inline void set(const samples_t& sample, const lines_t& line, const T& value)
+    {
+        _origin[line * stride + sample * bands] = value;
+    }
+
+    /// <summary>
+    /// Evaluates the image as part of an <see cref="ImageExpression"/>
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <param name="value">The value within the line (sample times bands plus band).</param>
+    /// <returns>The value.</returns>
+    inline float evaluate(const lines_t& line, const samples_t& value) const
+    {
+        return static_cast<float>(_origin[line * stride + value]);
+    }
+
+    /// <summary>
+    /// Determines whether the image has the given size, as part of an <see cref="ImageExpression"/>
+    /// </summary>
+    /// <param name="values">The number of values per line.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>true if the size matches.</returns>
+    inline bool matches(const samples_t& values, const lines_t& lines) const
+    {
+        return values == samples * bands && lines == this->lines;
+    }
+
+    /// <summary>
+    /// Evaluates the expression and stores the result in the image, in a single pass
+    /// </summary>
+    /// <param name="expression">The expression.</param>
+    /// <returns>The image.</returns>
+    template <typename E>
+    inline Image& operator=(const ImageExpression<E>& expression)
+    {
+        view().assign(expression);
+        return *this;
+    }
+
+    /// <summary>
+    /// Gets a view of the whole image
+    /// </summary>
+    /// <returns>The view.</returns>
+    inline ImageView<T> view() const
+    {
+        return ImageView<T>(this, _origin, samples, lines, bands, stride, halo);
+    }
+
+    /// <summary>
+    /// Gets a view of a region of the image
+    /// </summary>
+    /// <param name="sample_first">The first sample.</param>
+    /// <param name="line_first">The first line.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>The view.</returns>
+    inline ImageView<T> view(const samples_t& sample_first, const lines_t& line_first, const samples_t& samples, const lines_t& lines) const
+    {
+        return view().view(sample_first, line_first, samples, lines);
+    }
+
+    /// <summary>
+    /// Converts the image to OpenCV
+    /// </summary>
+    /// <param name="min">The sample value mapped to black.</param>
+    /// <param name="max">The sample value mapped to white.</param>
+    /// <returns>The converted image</returns>
+    inline IplImagePtr toOpenCv(const T& min = 0, const T& max = SampleTraits<T>::white()) const
+    {
+        return view().toOpenCv(min, max);
+    }
+
+    /// <summary>
+    /// Converts the image to a three-channel OpenCV image
+    /// </summary>
+    /// <param name="min">The sample value mapped to black.</param>
+    /// <param name="max">The sample value mapped to white.</param>
+    /// <returns>The converted image</returns>
+    inline IplImagePtr toOpenCvBGR(const T& min = 0, const T& max = SampleTraits<T>::white()) const
+    {
+        return view().toOpenCvBGR(min, max);
+    }
+
+    /// <summary>
+    /// Reads the image from a single-band unsigned 8-bit raw file; Reading and converting overlap.
+    /// </summary>
+    /// <param name="stream">The input stream.</param>
+    /// <returns>The image</returns>
+    static inline std::unique_ptr<Image> createFromU8Raw(std::istream& stream, const samples_t& samples, const lines_t& lines) throw(std::runtime_error)
+    {
+        return createFromU8Raw(stream, samples, lines, U8Conversion<T>());
+    }
+
+    /// <summary>
+    /// Reads the image from a single-band unsigned 8-bit raw file, mapping 0..255 to the given range
+    /// </summary>
+    /// <param name="stream">The input stream.</param>
+    /// <param name="to_min">The sample value of 0.</param>
+    /// <param name="to_max">The sample value of 255.</param>
+    /// <returns>The image</returns>
+    static inline std::unique_ptr<Image> createFromU8Raw(std::istream& stream, const samples_t& samples, const lines_t& lines, const T& to_min, const T& to_max) throw(std::runtime_error)
+    {
+        return createFromU8Raw(stream, samples, lines, U8Conversion<T>(to_min, to_max));
+    }
+
+    /// <summary>
+    /// Reads the image from a single-band unsigned 8-bit raw file using the given conversion
+    /// </summary>
+    /// <param name="stream">The input stream.</param>
+    /// <param name="conversion">The conversion of the 8-bit values to samples.</param>
+    /// <returns>The image</returns>
+    static inline std::unique_ptr<Image> createFromU8Raw(std::istream& stream, const samples_t& samples, const lines_t& lines, const U8Conversion<T>& conversion) throw(std::runtime_error)
+    {
+        std::unique_ptr<Image> image(new Image(samples, lines, 1, false));
+        image->readU8Raw(stream, conversion);
+        return image;
+    }
+
+    /// <summary>
+    /// Reads the samples of this single-band image from an unsigned 8-bit raw file of the same size; Reading and converting overlap.
+    /// </summary>
+    /// <param name="stream">The input stream.</param>
+    /// <param name="conversion">The conversion of the 8-bit values to samples.</param>
+    void readU8Raw(std::istream& stream, const U8Conversion<T>& conversion = U8Conversion<T>()) throw(std::runtime_error);
+
+    /// <summary>
+    /// Creates an image
+    /// </summary>
+    /// <returns>The image</returns>
+    static inline std::unique_ptr<Image> create(const samples_t& samples, const lines_t& lines, const bands_t& bands = 1, const bool zero = true, const samples_t& halo = 0)
+    {
+        return std::unique_ptr<Image>(new Image(samples, lines, bands, zero, halo));
+    }
+
+    /// <summary>
+    /// Fills the halo around the image from the image according to the given border policy
+    /// </summary>
+    /// <param name="policy">The border policy.</param>
+    /// <param name="value">The value of the halo for <see cref="BorderConstant"/>.</param>
+    void fillBorder(const BorderPolicy& policy, const T& value = 0);
+
+    /// <summary>
+    /// Flips the image vertically (in-place)
+    /// </summary>
+    void flipVertical();
+
+    /// <summary>
+    /// Convolves the image with the given kernel.
+    /// </summary>
+    /// <param name="kernel">The kernel.</param>
+    /// <returns>The convolved image.</returns>
+    inline std::unique_ptr<Image<float>> convolve(const std::unique_ptr<Image<float>>& kernel) const
+    {
+        return view().convolve(kernel->view());
+    }
+
+    /// <summary>
+    /// Calculates the line stride for the given number of values, such that every line starts at an aligned address.
+    /// </summary>
+    /// <param name="values">The number of values per line (samples times bands).</param>
+    /// <returns>The stride in values.</returns>
+    static inline samples_t alignedStride(const samples_t& values)
+    {
+        const samples_t values_per_alignment = alignment / sizeof(T);
+        return (values + values_per_alignment - 1) / values_per_alignment * values_per_alignment;
+    }
+
+private:
+    Image(const Image&);
+    Image& operator=(const Image&);
+};
+
+/// <summary>
+/// Copies the region into a new image
+/// </summary>
+/// <returns>The image</returns>
+template <typename T>
+std::unique_ptr<Image<T>> ImageView<T>::clone() const
+{
+    std::unique_ptr<Image<T>> target(new Image<T>(samples, lines, bands, false));
+    const samples_t values = samples * bands;
+
+    for (lines_t y = 0; y < lines; ++y)
+    {
+        const T* source = line(y).get_samples();
+        std::copy(source, source + values, target->line(y).get_samples());
+    }
+
+    return target;
+}
+
+/// <summary>
+/// Copies the region into a new image with a halo, filled according to the given border policy.
+/// </summary>
+/// <param name="halo">The number of samples and lines around the image.</param>
+/// <param name="policy">The border policy.</param>
+/// <param name="value">The value of the halo for <see cref="BorderConstant"/>.</param>
+/// <returns>The image</returns>
+template <typename T>
+std::unique_ptr<Image<T>> ImageView<T>::pad(const samples_t& halo, const BorderPolicy& policy, const T& value) const
+{
+    std::unique_ptr<Image<T>> target(new Image<T>(samples, lines, bands, false, halo));
+    const samples_t values = samples * bands;
+
+    for (lines_t y = 0; y < lines; ++y)
+    {
+        const T* source = line(y).get_samples();
+        std::copy(source, source + values, target->line(y).get_samples());
+    }
+
+    target->fillBorder(policy, value);
+    return target;
+}
+
+/// <summary>
+/// Copies the region into a new image of another sample type, mapping between the value ranges of both types
+/// </summary>
+/// <returns>The image</returns>
+template <typename T>
+template <typename U>
+std::unique_ptr<Image<U>> ImageView<T>::convert() const
+{
+    std::unique_ptr<Image<U>> target(new Image<U>(samples, lines, bands, false));
+    const float scale = SampleTraits<T>::scale();
+    const samples_t values = samples * bands;
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
+    {
+        const T* source = line(y).get_samples();
+        U* target_line = target->line(y).get_samples();
+
+        for (samples_t x = 0; x < values; ++x)
+        {
+            target_line[x] = SampleTraits<U>::fromFloat(static_cast<float>(source[x]) * scale);
+        }
+    }
+
+    return target;
+}
+
+/// <summary>
+/// Converts the region to OpenCV
+/// </summary>
+/// <param name="min">The sample value mapped to black.</param>
+/// <param name="max">The sample value mapped to white.</param>
+/// <returns>The converted image</returns>
+template <typename T>
+IplImagePtr ImageView<T>::toOpenCv(const T& min, const T& max) const
+{
+    assert(bands >= 1 && bands <= 4);
+    assert(min < max);
+
+    IplImagePtr displayImage(cvCreateImage(cvSize(static_cast<int>(samples), static_cast<int>(lines)), IPL_DEPTH_8U, bands));
+    samples_t step = displayImage->widthStep;
+
+    // bands are interleaved just like OpenCV's channels, so all values of a line are converted alike
+    const samples_t values = samples * bands;
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    const float lerp_scaling = 255.0F / static_cast<float>(max - min);
+
+    #pragma omp parallel for
+    for(omp_linecount_t y=0; y<omp_lines; ++y)
+    {
+        const ImageLine<T> line = this->line(y);
+        size_t lineOffset = y*(step);
+
+        for(samples_t x=0; x<values; ++x)
+        {
+            char& pixel = displayImage->imageData[lineOffset+x];
+
+            // pick the sample and convert it to 8-bit unsigned
+            const float input_sample = static_cast<float>(line.sample(x));
+
+            // lerp the value
+            float sample = (input_sample - static_cast<float>(min)) * lerp_scaling;
+
+            // assign sample (prediction friendly)
+            pixel = static_cast<uint_fast8_t>(sample);
+
+            // correct in case of problems
+            if (sample < 0.0F) {
+                pixel = 0;
+            }
+            if (sample > 255.0F) {
+                pixel = (char)255;
+            }
+        }
+    }
+    return displayImage;
+}
+
+/// <summary>
+/// Converts the region to a three-channel OpenCV image
+/// </summary>
+/// <param name="min">The sample value mapped to black.</param>
+/// <param name="max">The sample value mapped to white.</param>
+/// <returns>The converted image</returns>
+template <typename T>
+IplImagePtr ImageView<T>::toOpenCvBGR(const T& min, const T& max) const
+{
+    // three bands already are BGR
+    if (bands == 3) return toOpenCv(min, max);
+
+    assert(bands == 1);
+    assert(min < max);
+
+    IplImagePtr displayImage(cvCreateImage(cvSize(static_cast<int>(samples), static_cast<int>(lines)), IPL_DEPTH_8U, 3));
+    samples_t step = displayImage->widthStep;
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    const float lerp_scaling = 255.0F / static_cast<float>(max - min);
+
+    #pragma omp parallel for
+    for(omp_linecount_t y=0; y<omp_lines; ++y)
+    {
+        const ImageLine<T> line = this->line(y);
+        size_t lineOffset = y*(step);
+        size_t target_x = 0;
+
+        for(samples_t x=0; x<samples; ++x)
+        {
+            char& pixel_b = displayImage->imageData[lineOffset + target_x++];
+            char& pixel_g = displayImage->imageData[lineOffset + target_x++];
+            char& pixel_r = displayImage->imageData[lineOffset + target_x++];
+
+            // pick the sample and convert it to 8-bit unsigned
+            const float input_sample = static_cast<float>(line.sample(x));
+
+            // lerp the value
+            float sample = (input_sample - static_cast<float>(min)) * lerp_scaling;
+
+            // assign sample (prediction friendly)
+            pixel_r = static_cast<uint_fast8_t>(sample);
+            pixel_b = pixel_r;
+            pixel_g = pixel_r;
+
+            // correct in case of problems
+            if (sample < 0.0F) {
+                pixel_r = 0;
+            }
+            if (sample > 255.0F) {
+                pixel_r = (char)255;
+            }
+        }
+    }
+    return displayImage;
+}
+
+// integer paths: lookup tables instead of per-sample float math
+template <> IplImagePtr ImageView<uint8_t>::toOpenCv(const uint8_t& min, const uint8_t& max) const;
+template <> IplImagePtr ImageView<uint8_t>::toOpenCvBGR(const uint8_t& min, const uint8_t& max) const;
+template <> IplImagePtr ImageView<uint16_t>::toOpenCv(const uint16_t& min, const uint16_t& max) const;
+
+/// <summary>
+/// Convolves the region with the given kernel; Samples outside of the region are treated as missing.
+/// The result is a normalized float image.
+/// </summary>
+/// <param name="kernel">The kernel.</param>
+/// <returns>The convolved image.</returns>
+template <typename T>
+std::unique_ptr<Image<float>> ImageView<T>::convolve(const ImageView<float>& kernel) const
+{
+    assert ((kernel.samples & 0x1) == 0x1); // kernel width must be odd
+    assert ((kernel.lines & 0x1) == 0x1);   // kernel height must be odd
+    assert (kernel.bands == 1);
+
+    // image to hold the convolved image
+#if _DEBUG
+    const bool initialize = true;
+#else
+    const bool initialize = false;
+#endif
+    std::unique_ptr<Image<float>> target(new Image<float>(samples, lines, bands, initialize));
+
+    // the bounds checks can be dropped if every kernel tap lies within the region or its halo
+    const bool padded = (halo >= static_cast<samples_t>(kernel.samples / 2)) && (halo >= static_cast<samples_t>(kernel.lines / 2));
+
+    // all bands are convolved in the same pass; common band counts get a fixed-size band loop
+    switch (bands)
+    {
+        case 1:  padded ? convolveBands<1, true>(kernel, target->view()) : convolveBands<1, false>(kernel, target->view()); break;
+        case 3:  padded ? convolveBands<3, true>(kernel, target->view()) : convolveBands<3, false>(kernel, target->view()); break;
+        case 4:  padded ? convolveBands<4, true>(kernel, target->view()) : convolveBands<4, false>(kernel, target->view()); break;
+        default: padded ? convolveBands<0, true>(kernel, target->view()) : convolveBands<0, false>(kernel, target->view()); break;
+    }
+
+    return target;
+}
+
+/// <summary>
+/// Convolves all bands of the region with the given kernel into the target region.
+/// </summary>
+/// <param name="kernel">The kernel.</param>
+/// <param name="target">The target region of the same size.</param>
+template <typename T>
+template <bands_t BANDS, bool PADDED>
+void ImageView<T>::convolveBands(const ImageView<float>& kernel, const ImageView<float>& target) const
+{
+    // compile-time band count allows the compiler to unroll and vectorize the band loops
+    const bands_t band_count = (BANDS > 0) ? BANDS : bands;
+    assert (band_count == bands);
+
+    const samples_t raw_samples     = samples;
+    const lines_t raw_lines         = lines;
+    const samples_t kernel_samples  = kernel.samples;
+    const lines_t kernel_lines      = kernel.lines;
+
+    const ssamples_t kernel_halfsamples = static_cast<slines_t>(kernel_samples) / 2;
+    const slines_t kernel_halflines = static_cast<slines_t>(kernel_lines) / 2;
+
+    // integer samples are normalized once per output sample
+    const float scale = SampleTraits<T>::scale();
+
+    // OpenMP needs signed integral type
+    typedef int_fast64_t omp_linecount_t;
+    omp_linecount_t omp_lines = raw_lines;
+
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
+    {
+        float* target_line = target.line(y).get_samples();
+
+        // loop over all samples
+        for (samples_t x = 0; x < raw_samples; ++x)
+        {
+            // correlate the pixels in mask-space (in the area overlayed by the mask)
+            float sample_values[BANDS > 0 ? BANDS : 256];
+            float kernel_sum = 0.0F;
+
+            for (bands_t b = 0; b < band_count; ++b)
+            {
+                sample_values[b] = 0.0F;
+            }
+
+            for (lines_t my = 0; my < kernel_lines; ++my) // loop all lines in kernel-space
+            {
+                // calculate the image line
+                slines_t raw_y = y + my - kernel_halflines;
+
+                // without a halo, lines outside of the region are missing
+                if (!PADDED)
+                {
+                    if (raw_y < 0) continue;
+                    if (static_cast<lines_t>(raw_y) >= lines) continue;
+                }
+
+                // grab the kernel and image lines
+                const float* kernel_line = kernel.line(my).get_samples();
+                const T* raw_line = haloLine(raw_y).get_samples();
+
+                // loop over pixels (in kernel-space)
+                for (samples_t mx = 0; mx < kernel_samples; ++mx)
+                {
+                    // calculate the image line
+                    slines_t raw_x = x + mx - kernel_halfsamples;
+
+                    // same as above
+                    if (!PADDED)
+                    {
+                        if (raw_x < 0) continue;
+                        if (static_cast<samples_t>(raw_x) >= samples) continue;
+                    }
+
+                    // convolve all bands of the sample
+                    const float kernel_sample = kernel_line[mx];
+                    const T* raw_pixel = raw_line + raw_x * band_count;
+                    for (bands_t b = 0; b < band_count; ++b)
+                    {
+                        sample_values[b] += kernel_sample * static_cast<float>(raw_pixel[b]);
+                    }
+                    kernel_sum += kernel_sample;
+                }
+            }
+
+            // set value (adjust to effective summed kernel values)
+            float* target_pixel = target_line + x * band_count;
+            for (bands_t b = 0; b < band_count; ++b)
+            {
+                target_pixel[b] = sample_values[b] * scale / kernel_sum;
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Reads consecutive blocks of bytes from a stream on a single background thread, one block ahead of the caller;
+/// Two buffers are filled and handed out in turn. Used by <see cref="Image::readU8Raw"/>.
+/// </summary>
+class RawBlockReader
+{
+private:
+    /// <summary>The input stream; Only touched by the background thread</summary>
+    std::istream& _stream;
+
+    /// <summary>The number of bytes per block</summary>
+    const std::streamsize _block_size;
+
+    /// <summary>The number of bytes of all blocks</summary>
+    const std::streamsize _total_size;
+
+    /// <summary>The number of blocks</summary>
+    const size_t _blocks;
+
+    /// <summary>The buffers of the even and the odd blocks</summary>
+    std::vector<char> _buffers[2];
+
+    /// <summary>The number of bytes actually read into each buffer</summary>
+    std::streamsize _sizes[2];
+
+    /// <summary>The number of blocks read so far</summary>
+    size_t _filled;
+
+    /// <summary>The number of blocks the caller is done with</summary>
+    size_t _released;
+
+    /// <summary>Set when the reader is destroyed before all blocks were read</summary>
+    bool _cancelled;
+
+    std::mutex _mutex;
+    std::condition_variable _changed;
+
+    /// <summary>The background thread; Started last, once all other members are set up</summary>
+    std::thread _thread;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="RawBlockReader"/> class and starts reading the first block.
+    /// </summary>
+    /// <param name="stream">The input stream; Must not be used by the caller until the reader is destroyed.</param>
+    /// <param name="block_size">The number of bytes per block; Must be positive.</param>
+    /// <param name="total_size">The number of bytes to read; The last block may be shorter.</param>
+    RawBlockReader(std::istream& stream, const std::streamsize block_size, const std::streamsize total_size)
+        : _stream(stream), _block_size(block_size), _total_size(total_size), _blocks(static_cast<size_t>((total_size + block_size - 1) / block_size)),
+          _filled(0), _released(0), _cancelled(false)
+    {
+        assert(block_size > 0);
+        _buffers[0].resize(static_cast<size_t>(std::min(block_size, total_size)));
+        _buffers[1].resize(_buffers[0].size());
+        _sizes[0] = _sizes[1] = 0;
+        _thread = std::thread(&RawBlockReader::run, this);
+    }
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="RawBlockReader"/> class; Stops reading and waits for the background thread.
+    /// </summary>
+    ~RawBlockReader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _cancelled = true;
+        }
+        _changed.notify_all();
+        _thread.join();
+    }
+
+    /// <summary>
+    /// Waits until a block is read; Blocks must be acquired in order and released before the one after the next is acquired.
+    /// </summary>
+    /// <param name="block">The index of the block.</param>
+    /// <param name="size">The number of bytes read into the block; Less than requested at the end of the stream.</param>
+    /// <returns>The bytes of the block.</returns>
+    const char* acquire(const size_t block, std::streamsize& size)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_filled <= block) _changed.wait(lock);
+
+        size = _sizes[block % 2];
+        return _buffers[block % 2].data();
+    }
+
+    /// <summary>
+    /// Hands the oldest acquired block back, so its buffer can take the block after the next one
+    /// </summary>
+    void release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_released;
+        }
+        _changed.notify_all();
+    }
+
+private:
+    /// <summary>
+    /// Reads all blocks, one block ahead of the caller; Stops after a short block.
+    /// </summary>
+    void run()
+    {
+        for (size_t block = 0; block < _blocks; ++block)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                while (!_cancelled && block >= _released + 2) _changed.wait(lock);
+                if (_cancelled) return;
+            }
+
+            const std::streamsize offset = static_cast<std::streamsize>(block) * _block_size;
+            const std::streamsize size = std::min(_block_size, _total_size - offset);
+            _stream.read(_buffers[block % 2].data(), size);
+            const std::streamsize read = _stream.gcount();
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _sizes[block % 2] = read;
+                ++_filled;
+            }
+            _changed.notify_all();
+
+            if (read != size) return;
+        }
+    }
+
+    RawBlockReader(const RawBlockReader&);
+    RawBlockReader& operator=(const RawBlockReader&);
+};
+
+/// <summary>
+/// Reads the samples of this single-band image from an unsigned 8-bit raw file of the same size.
+/// The file is read in blocks of lines; While one block is converted, the next one is read by a single background thread.
+/// </summary>
+/// <param name="stream">The input stream.</param>
+/// <param name="conversion">The conversion of the 8-bit values to samples.</param>
+template <typename T>
+void Image<T>::readU8Raw(std::istream& stream, const U8Conversion<T>& conversion)
+{
+    assert(bands == 1);
+    if (samples == 0 || lines == 0) return;
+
+    // two buffers of 64 lines (at most 256 KiB) each: one being filled, one being converted; Even small frames span several blocks
+    const lines_t block_lines = std::max<lines_t>(1, std::min<lines_t>(64, (256U << 10) / samples));
+    RawBlockReader reader(stream, static_cast<std::streamsize>(block_lines * samples), static_cast<std::streamsize>(lines * samples));
+
+    size_t block = 0;
+    for (lines_t first = 0; first < lines; first += block_lines, ++block)
+    {
+        const lines_t block_count = std::min(block_lines, lines - first);
+
+        // wait for the current block; the next one is already being read
+        std::streamsize size = 0;
+        const uint8_t* source = reinterpret_cast<const uint8_t*>(reader.acquire(block, size));
+        if (size != static_cast<std::streamsize>(block_count * samples)) throw std::runtime_error("Raw file is shorter than the image");
+
+        // convert the current block; there is only a single band
+        typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+        const omp_linecount_t omp_lines = static_cast<omp_linecount_t>(block_count);
+
+        #pragma omp parallel for
+        for (omp_linecount_t y = 0; y < omp_lines; ++y)
+        {
+            convertU8Line(source + y * samples, line(first + y).get_samples(), samples, conversion);
+        }
+
+        // its buffer can now take the block after the next
+        reader.release();
+    }
+}
+
+/// <summary>
+/// Fills the halo around the image from the image according to the given border policy
+/// </summary>
+/// <param name="policy">The border policy.</param>
+/// <param name="value">The value of the halo for <see cref="BorderConstant"/>.</param>
+template <typename T>
+void Image<T>::fillBorder(const BorderPolicy& policy, const T& value)
+{
+    if (halo == 0) return;
+
+    const samples_t halo_values = halo * bands;
+    const samples_t values = samples * bands;
+
+    // left and right of every line of the image
+    for (lines_t y = 0; y < lines; ++y)
+    {
+        T* line = _origin + y * stride;
+        for (samples_t x = -halo; x < 0; ++x)
+        {
+            const samples_t left = x;
+            const samples_t right = samples - 1 - x;
+            for (bands_t b = 0; b < bands; ++b)
+            {
+                line[left * bands + b]  = (policy == BorderConstant) ? value : line[borderIndex(left, samples, policy) * bands + b];
+                line[right * bands + b] = (policy == BorderConstant) ? value : line[borderIndex(right, samples, policy) * bands + b];
+            }
+        }
+    }
+
+    // whole lines (including their left and right halo) above and below the image
+    for (slines_t y = -halo; y < 0; ++y)
+    {
+        const slines_t above = y;
+        const slines_t below = static_cast<slines_t>(lines) - 1 - y;
+
+        T* target_above = _origin + above * stride - halo_values;
+        T* target_below = _origin + below * stride - halo_values;
+
+        if (policy == BorderConstant)
+        {
+            std::fill(target_above, target_above + values + 2 * halo_values, value);
+            std::fill(target_below, target_below + values + 2 * halo_values, value);
+        }
+        else
+        {
+            const T* source_above = _origin + borderIndex(above, lines, policy) * stride - halo_values;
+            const T* source_below = _origin + borderIndex(below, lines, policy) * stride - halo_values;
+            std::copy(source_above, source_above + values + 2 * halo_values, target_above);
+            std::copy(source_below, source_below + values + 2 * halo_values, target_below);
+        }
+    }
+}
+
+/// <summary>
+/// Flips the image vertically (in-place)
+/// </summary>
+template <typename T>
+void Image<T>::flipVertical()
+{
+    const lines_t halfLines = lines/2; // TODO: should work for odd line numbers, but better test that
+    const samples_t values = samples * bands;
+    for (lines_t lineIndex = 0; lineIndex < halfLines; ++lineIndex)
+    {
+        T* top = line(lineIndex).get_samples();
+        T* bottom = line(lines - lineIndex - 1).get_samples();
+
+        // swap the line contents
+        std::swap_ranges(top, top + values, bottom);
+    }
+}
+
+typedef Image<uint8_t>                  U8Image;
+typedef Image<uint16_t>                 U16Image;
+typedef std::unique_ptr<U8Image>        u8image_t;
+typedef std::unique_ptr<U16Image>       u16image_t;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+#include "ImagePool.h"
+
+using namespace std;
+
+const size_t ImagePool::alignment;
+const size_t ImagePool::default_capacity;
+
+/// <summary>
+/// Allocates a buffer aligned to <see cref="ImagePool::alignment"/> bytes.
+/// </summary>
+/// <param name="bytes">The size of the buffer in bytes.</param>
+/// <returns>The buffer; Must be released through <see cref="AlignedDeleter"/>.</returns>
+void* alignedAllocate(const size_t& bytes)
+{
+    const size_t alignment = ImagePool::alignment;
+#ifdef _MSC_VER
+    void* buffer = _aligned_malloc(bytes, alignment);
+#else
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, alignment, bytes) != 0) buffer = nullptr;
+#endif
+    if (!buffer) throw runtime_error("not enough memory to create image (sample array)");
+    return buffer;
+}
+
+/// <summary>
+/// Releases a buffer obtained from <see cref="alignedAllocate"/>
+/// </summary>
+/// <param name="buffer">The buffer.</param>
+void AlignedDeleter::operator()(void* buffer) const
+{
+    if (!buffer) return;
+#ifdef _MSC_VER
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="ImagePool"/> class.
+/// </summary>
+/// <param name="capacity">The maximum number of bytes kept in the pool.</param>
+ImagePool::ImagePool(const size_t& capacity)
+    : _pooled(0), _capacity(capacity)
+{
+}
+
+/// <summary>
+/// Finalizes an instance of the <see cref="ImagePool"/> class, freeing all pooled buffers.
+/// </summary>
+ImagePool::~ImagePool()
+{
+    trim();
+}
+
+/// <summary>
+/// Gets the process-wide pool used by <see cref="Image"/>; The pool is never destroyed, so images
+/// owned by other static objects can still hand their buffers back at exit.
+/// </summary>
+/// <returns>The pool.</returns>
+ImagePool& ImagePool::instance()
+{
+    static ImagePool* pool = new ImagePool;
+    return *pool;
+}
+
+/// <summary>
+/// Takes a buffer of the given size from the pool or allocates a new one.
+/// The content of the buffer is undefined.
+/// </summary>
+/// <param name="bytes">The size of the buffer in bytes.</param>
+/// <returns>The buffer; Must be handed back through <see cref="release"/>.</returns>
+void* ImagePool::acquire(const size_t& bytes)
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        auto bucket = _buckets.find(bytes);
+        if (bucket != _buckets.end() && !bucket->second.empty())
+        {
+            void* buffer = bucket->second.back();
+            bucket->second.pop_back();
+            _pooled -= bytes;
+            return buffer;
+        }
+    }
+
+    // nothing to recycle; allocate outside of the lock
+    return alignedAllocate(bytes);
+}
+
+/// <summary>
+/// Hands a buffer back to the pool; The buffer is freed if the pool is full.
+/// </summary>
+/// <param name="buffer">The buffer.</param>
+/// <param name="bytes">The size of the buffer in bytes, as passed to <see cref="acquire"/>.</param>
+void ImagePool::release(void* buffer, const size_t& bytes)
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+
+        if (_pooled + bytes <= _capacity)
+        {
+            _buckets[bytes].push_back(buffer);
+            _pooled += bytes;
+            return;
+        }
+    }
+
+    AlignedDeleter()(buffer);
+}
+
+/// <summary>
+/// Frees all pooled buffers
+/// </summary>
+void ImagePool::trim()
+{
+    lock_guard<mutex> lock(_mutex);
+
+    for (auto& bucket : _buckets)
+    {
+        for (void* buffer : bucket.second)
+        {
+            AlignedDeleter()(buffer);
+        }
+    }
+
+    _buckets.clear();
+    _pooled = 0;
+}
+
+/// <summary>
+/// Sets the maximum number of bytes kept in the pool; Zero disables pooling.
+/// </summary>
+/// <param name="capacity">The capacity in bytes.</param>
+void ImagePool::setCapacity(const size_t& capacity)
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+        _capacity = capacity;
+        if (_pooled <= _capacity) return;
+    }
+
+    // simply drop everything when shrinking below the pooled size
+    trim();
+}
+
+/// <summary>
+/// Gets the number of bytes currently kept in the pool
+/// </summary>
+/// <returns>The number of bytes.</returns>
+size_t ImagePool::pooled()
+{
+    lock_guard<mutex> lock(_mutex);
+    return _pooled;
+}
\ No newline at end of file
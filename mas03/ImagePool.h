@@ -0,0 +1,142 @@
+#ifndef _IMAGEPOOL_H_
+#define _IMAGEPOOL_H_
+
+#pragma warning(disable: 4290)
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+/// <summary>
+/// Allocates a buffer aligned to <see cref="ImagePool::alignment"/> bytes.
+/// </summary>
+/// <param name="bytes">The size of the buffer in bytes.</param>
+/// <returns>The buffer; Must be released through <see cref="AlignedDeleter"/>.</returns>
+void* alignedAllocate(const size_t& bytes) throw(std::runtime_error);
+
+/// <summary>
+/// Deleter for buffers obtained from <see cref="alignedAllocate"/>
+/// </summary>
+struct AlignedDeleter
+{
+    void operator()(void* buffer) const;
+};
+
+/// <summary>
+/// Size-bucketed pool of aligned sample buffers.
+/// Buffers of released images are kept and handed out again to the next image of the same size,
+/// which avoids allocator and page-fault costs for same-sized intermediate images.
+/// </summary>
+class ImagePool
+{
+public:
+    /// <summary>
+    /// The alignment of all buffers in bytes (one cache line)
+    /// </summary>
+    static const size_t alignment = 64;
+
+    /// <summary>
+    /// The default upper limit of bytes kept in the pool
+    /// </summary>
+    static const size_t default_capacity = 256 * 1024 * 1024;
+
+private:
+    /// <summary>
+    /// Unused buffers, bucketed by their size in bytes
+    /// </summary>
+    std::map<size_t, std::vector<void*>> _buckets;
+
+    /// <summary>
+    /// The number of bytes currently held in the buckets
+    /// </summary>
+    size_t _pooled;
+
+    /// <summary>
+    /// The maximum number of bytes held in the buckets
+    /// </summary>
+    size_t _capacity;
+
+    /// <summary>
+    /// Guards the buckets; Images may be created and released from within parallel regions
+    /// </summary>
+    std::mutex _mutex;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ImagePool"/> class.
+    /// </summary>
+    /// <param name="capacity">The maximum number of bytes kept in the pool.</param>
+    explicit ImagePool(const size_t& capacity = default_capacity);
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="ImagePool"/> class, freeing all pooled buffers.
+    /// </summary>
+    ~ImagePool();
+
+    /// <summary>
+    /// Gets the process-wide pool used by <see cref="Image"/>; The pool is never destroyed, so images
+    /// owned by other static objects can still hand their buffers back at exit.
+    /// </summary>
+    /// <returns>The pool.</returns>
+    static ImagePool& instance();
+
+    /// <summary>
+    /// Takes a buffer of the given size from the pool or allocates a new one.
+    /// The content of the buffer is undefined.
+    /// </summary>
+    /// <param name="bytes">The size of the buffer in bytes.</param>
+    /// <returns>The buffer; Must be handed back through <see cref="release"/>.</returns>
+    void* acquire(const size_t& bytes) throw(std::runtime_error);
+
+    /// <summary>
+    /// Hands a buffer back to the pool; The buffer is freed if the pool is full.
+    /// </summary>
+    /// <param name="buffer">The buffer.</param>
+    /// <param name="bytes">The size of the buffer in bytes, as passed to <see cref="acquire"/>.</param>
+    void release(void* buffer, const size_t& bytes);
+
+    /// <summary>
+    /// Frees all pooled buffers
+    /// </summary>
+    void trim();
+
+    /// <summary>
+    /// Sets the maximum number of bytes kept in the pool; Zero disables pooling.
+    /// </summary>
+    /// <param name="capacity">The capacity in bytes.</param>
+    void setCapacity(const size_t& capacity);
+
+    /// <summary>
+    /// Gets the number of bytes currently kept in the pool
+    /// </summary>
+    /// <returns>The number of bytes.</returns>
+    size_t pooled();
+
+private:
+    ImagePool(const ImagePool&);
+    ImagePool& operator=(const ImagePool&);
+};
+
+/// <summary>
+/// Deleter handing buffers obtained from <see cref="ImagePool::acquire"/> back to the pool
+/// </summary>
+struct PooledDeleter
+{
+    /// <summary>
+    /// The size of the buffer in bytes
+    /// </summary>
+    size_t bytes;
+
+    PooledDeleter() : bytes(0) {}
+    explicit PooledDeleter(const size_t& bytes) : bytes(bytes) {}
+
+    inline void operator()(void* buffer) const
+    {
+        if (!buffer) return;
+        ImagePool::instance().release(buffer, bytes);
+    }
+};
+
+#endif
\ No newline at end of file
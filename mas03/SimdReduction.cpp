@@ -0,0 +1,478 @@
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#include <cfloat>
+#include <cstdint>
+
+#include <immintrin.h>
+
+#include "SimdReduction.h"
+
+// GCC and Clang only emit wider instructions in functions marked for them; Visual C++ emits any intrinsic
+#if defined(__GNUC__)
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+// AVX2 intrinsics are available from Visual C++ 2012 on, AVX-512 intrinsics from Visual C++ 2017 on
+#if defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1700)
+#define SIMD_HAVE_AVX2
+#endif
+#if defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1910)
+#define SIMD_HAVE_AVX512
+#endif
+
+/// <summary>
+/// Queries the processor
+/// </summary>
+/// <param name="leaf">The leaf.</param>
+/// <param name="subleaf">The subleaf.</param>
+/// <param name="registers">EAX, EBX, ECX and EDX.</param>
+static inline void cpuid(const unsigned int leaf, const unsigned int subleaf, unsigned int (&registers)[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) registers[i] = static_cast<unsigned int>(info[i]);
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+/// <summary>
+/// Reads the register states the operating system saves on context switches (XCR0)
+/// </summary>
+/// <returns>The enabled state components.</returns>
+static inline uint64_t enabledRegisterStates()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+/// <summary>
+/// Determines the widest instruction set extension supported by both the processor and the operating system
+/// </summary>
+/// <returns>The level.</returns>
+SimdLevel detectSimdLevel()
+{
+    unsigned int registers[4];
+    cpuid(0, 0, registers);
+    const unsigned int max_leaf = registers[0];
+
+    cpuid(1, 0, registers);
+    const bool sse2    = (registers[3] & (1U << 26)) != 0;
+    const bool fma     = (registers[2] & (1U << 12)) != 0;
+    const bool osxsave = (registers[2] & (1U << 27)) != 0;
+    const bool avx     = (registers[2] & (1U << 28)) != 0;
+
+    if (!sse2) return SimdScalar;
+    if (!osxsave || !avx || max_leaf < 7) return SimdSSE2;
+
+    // the wide registers are only usable if the operating system saves them
+    const uint64_t states = enabledRegisterStates();
+    const bool ymm_enabled = (states & 0x06) == 0x06;
+    const bool zmm_enabled = (states & 0xE6) == 0xE6;
+    if (!ymm_enabled) return SimdSSE2;
+
+    cpuid(7, 0, registers);
+    const bool avx2    = (registers[1] & (1U << 5)) != 0;
+    const bool avx512f = (registers[1] & (1U << 16)) != 0;
+
+#ifdef SIMD_HAVE_AVX512
+    if (avx512f && avx2 && fma && zmm_enabled) return SimdAVX512;
+#endif
+#ifdef SIMD_HAVE_AVX2
+    if (avx2 && fma) return SimdAVX2;
+#endif
+    return SimdSSE2;
+}
+
+/// <summary>
+/// Gets the name of an instruction set level
+/// </summary>
+/// <param name="level">The level.</param>
+/// <returns>The name.</returns>
+const char* simdLevelName(const SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdSSE2:   return "SSE2";
+        case SimdAVX2:   return "AVX2";
+        case SimdAVX512: return "AVX-512";
+        default:         return "scalar";
+    }
+}
+
+/// <summary>
+/// Continues a reduction with scalar code, e.g. for the values left over by a vector kernel
+/// </summary>
+static inline void accumulateScalar(const float* values, const size_t count, const float shift, Reduction& reduction)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float value = values[i];
+        if (value < reduction.min) reduction.min = value;
+        if (value > reduction.max) reduction.max = value;
+
+        const double difference = static_cast<double>(value) - shift;
+        reduction.sum += difference;
+        reduction.sum_sq += difference * difference;
+    }
+}
+
+/// <summary>
+/// Continues a range with scalar code, e.g. for the values left over by a vector kernel
+/// </summary>
+static inline void rangeScalar(const float* values, const size_t count, float& min, float& max)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float value = values[i];
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+}
+
+/// <summary>
+/// Folds the lanes of a range
+/// </summary>
+static inline void foldRange(const float* lows, const float* highs, const size_t lanes, float& min, float& max)
+{
+    for (size_t l = 0; l < lanes; ++l)
+    {
+        if (lows[l] < min) min = lows[l];
+        if (highs[l] > max) max = highs[l];
+    }
+}
+
+/// <summary>
+/// Range, scalar
+/// </summary>
+static void minMaxScalar(const float* values, const size_t count, float& min, float& max)
+{
+    min = FLT_MAX;
+    max = -FLT_MAX;
+    rangeScalar(values, count, min, max);
+}
+
+/// <summary>
+/// Range and sums, scalar
+/// </summary>
+static void minMaxSumsScalar(const float* values, const size_t count, const float shift, Reduction& reduction)
+{
+    reduction.min = FLT_MAX;
+    reduction.max = -FLT_MAX;
+    reduction.sum = 0;
+    reduction.sum_sq = 0;
+    accumulateScalar(values, count, shift, reduction);
+}
+
+// Within the vector kernels the new values are always the first operand of min and max:
+// If either operand is NaN the second one is returned, so NaN values never enter the running range.
+
+/// <summary>
+/// Range, SSE2; Two accumulators of four lanes each hide the latency of min and max.
+/// </summary>
+static void minMaxSSE2(const float* values, const size_t count, float& min, float& max)
+{
+    __m128 low0 = _mm_set1_ps(FLT_MAX), low1 = low0;
+    __m128 high0 = _mm_set1_ps(-FLT_MAX), high1 = high0;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128 a = _mm_loadu_ps(values + i);
+        const __m128 b = _mm_loadu_ps(values + i + 4);
+        low0 = _mm_min_ps(a, low0);
+        low1 = _mm_min_ps(b, low1);
+        high0 = _mm_max_ps(a, high0);
+        high1 = _mm_max_ps(b, high1);
+    }
+
+    float lows[4], highs[4];
+    _mm_storeu_ps(lows, _mm_min_ps(low0, low1));
+    _mm_storeu_ps(highs, _mm_max_ps(high0, high1));
+
+    min = FLT_MAX;
+    max = -FLT_MAX;
+    foldRange(lows, highs, 4, min, max);
+    rangeScalar(values + i, count - i, min, max);
+}
+
+/// <summary>
+/// Range and sums, SSE2; The values are widened to double precision before the shift is subtracted, two lanes per register.
+/// </summary>
+static void minMaxSumsSSE2(const float* values, const size_t count, const float shift, Reduction& reduction)
+{
+    const __m128d shifts = _mm_set1_pd(shift);
+    __m128 low = _mm_set1_ps(FLT_MAX);
+    __m128 high = _mm_set1_ps(-FLT_MAX);
+    __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+    __m128d sum_sq0 = _mm_setzero_pd(), sum_sq1 = _mm_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 v = _mm_loadu_ps(values + i);
+        low = _mm_min_ps(v, low);
+        high = _mm_max_ps(v, high);
+
+        const __m128d d0 = _mm_sub_pd(_mm_cvtps_pd(v), shifts);
+        const __m128d d1 = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), shifts);
+        sum0 = _mm_add_pd(sum0, d0);
+        sum1 = _mm_add_pd(sum1, d1);
+        sum_sq0 = _mm_add_pd(sum_sq0, _mm_mul_pd(d0, d0));
+        sum_sq1 = _mm_add_pd(sum_sq1, _mm_mul_pd(d1, d1));
+    }
+
+    float lows[4], highs[4];
+    double sums[2], sums_sq[2];
+    _mm_storeu_ps(lows, low);
+    _mm_storeu_ps(highs, high);
+    _mm_storeu_pd(sums, _mm_add_pd(sum0, sum1));
+    _mm_storeu_pd(sums_sq, _mm_add_pd(sum_sq0, sum_sq1));
+
+    reduction.min = FLT_MAX;
+    reduction.max = -FLT_MAX;
+    foldRange(lows, highs, 4, reduction.min, reduction.max);
+    reduction.sum = sums[0] + sums[1];
+    reduction.sum_sq = sums_sq[0] + sums_sq[1];
+    accumulateScalar(values + i, count - i, shift, reduction);
+}
+
+#ifdef SIMD_HAVE_AVX2
+
+/// <summary>
+/// Range, AVX2
+/// </summary>
+SIMD_TARGET("avx2,fma")
+static void minMaxAVX2(const float* values, const size_t count, float& min, float& max)
+{
+    __m256 low0 = _mm256_set1_ps(FLT_MAX), low1 = low0;
+    __m256 high0 = _mm256_set1_ps(-FLT_MAX), high1 = high0;
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m256 a = _mm256_loadu_ps(values + i);
+        const __m256 b = _mm256_loadu_ps(values + i + 8);
+        low0 = _mm256_min_ps(a, low0);
+        low1 = _mm256_min_ps(b, low1);
+        high0 = _mm256_max_ps(a, high0);
+        high1 = _mm256_max_ps(b, high1);
+    }
+
+    float lows[8], highs[8];
+    _mm256_storeu_ps(lows, _mm256_min_ps(low0, low1));
+    _mm256_storeu_ps(highs, _mm256_max_ps(high0, high1));
+
+    min = FLT_MAX;
+    max = -FLT_MAX;
+    foldRange(lows, highs, 8, min, max);
+    rangeScalar(values + i, count - i, min, max);
+}
+
+/// <summary>
+/// Range and sums, AVX2; The squares are accumulated with fused multiply-add.
+/// </summary>
+SIMD_TARGET("avx2,fma")
+static void minMaxSumsAVX2(const float* values, const size_t count, const float shift, Reduction& reduction)
+{
+    const __m256d shifts = _mm256_set1_pd(shift);
+    __m256 low = _mm256_set1_ps(FLT_MAX);
+    __m256 high = _mm256_set1_ps(-FLT_MAX);
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    __m256d sum_sq0 = _mm256_setzero_pd(), sum_sq1 = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 v = _mm256_loadu_ps(values + i);
+        low = _mm256_min_ps(v, low);
+        high = _mm256_max_ps(v, high);
+
+        const __m256d d0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), shifts);
+        const __m256d d1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), shifts);
+        sum0 = _mm256_add_pd(sum0, d0);
+        sum1 = _mm256_add_pd(sum1, d1);
+        sum_sq0 = _mm256_fmadd_pd(d0, d0, sum_sq0);
+        sum_sq1 = _mm256_fmadd_pd(d1, d1, sum_sq1);
+    }
+
+    float lows[8], highs[8];
+    double sums[4], sums_sq[4];
+    _mm256_storeu_ps(lows, low);
+    _mm256_storeu_ps(highs, high);
+    _mm256_storeu_pd(sums, _mm256_add_pd(sum0, sum1));
+    _mm256_storeu_pd(sums_sq, _mm256_add_pd(sum_sq0, sum_sq1));
+
+    reduction.min = FLT_MAX;
+    reduction.max = -FLT_MAX;
+    foldRange(lows, highs, 8, reduction.min, reduction.max);
+    reduction.sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    reduction.sum_sq = (sums_sq[0] + sums_sq[1]) + (sums_sq[2] + sums_sq[3]);
+    accumulateScalar(values + i, count - i, shift, reduction);
+}
+
+#endif
+
+#ifdef SIMD_HAVE_AVX512
+
+// GCC 12 reports the placeholder operands of its own AVX-512 intrinsics (_mm256_undefined_pd and the like) as uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+/// <summary>
+/// Range, AVX-512
+/// </summary>
+SIMD_TARGET("avx512f")
+static void minMaxAVX512(const float* values, const size_t count, float& min, float& max)
+{
+    __m512 low0 = _mm512_set1_ps(FLT_MAX), low1 = low0;
+    __m512 high0 = _mm512_set1_ps(-FLT_MAX), high1 = high0;
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const __m512 a = _mm512_loadu_ps(values + i);
+        const __m512 b = _mm512_loadu_ps(values + i + 16);
+        low0 = _mm512_min_ps(a, low0);
+        low1 = _mm512_min_ps(b, low1);
+        high0 = _mm512_max_ps(a, high0);
+        high1 = _mm512_max_ps(b, high1);
+    }
+
+    min = _mm512_reduce_min_ps(_mm512_min_ps(low0, low1));
+    max = _mm512_reduce_max_ps(_mm512_max_ps(high0, high1));
+    rangeScalar(values + i, count - i, min, max);
+}
+
+/// <summary>
+/// Range and sums, AVX-512
+/// </summary>
+SIMD_TARGET("avx512f")
+static void minMaxSumsAVX512(const float* values, const size_t count, const float shift, Reduction& reduction)
+{
+    const __m512d shifts = _mm512_set1_pd(shift);
+    __m512 low = _mm512_set1_ps(FLT_MAX);
+    __m512 high = _mm512_set1_ps(-FLT_MAX);
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    __m512d sum_sq0 = _mm512_setzero_pd(), sum_sq1 = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512 v = _mm512_loadu_ps(values + i);
+        low = _mm512_min_ps(v, low);
+        high = _mm512_max_ps(v, high);
+
+        const __m512d d0 = _mm512_sub_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(v)), shifts);
+        const __m512d d1 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))), shifts);
+        sum0 = _mm512_add_pd(sum0, d0);
+        sum1 = _mm512_add_pd(sum1, d1);
+        sum_sq0 = _mm512_fmadd_pd(d0, d0, sum_sq0);
+        sum_sq1 = _mm512_fmadd_pd(d1, d1, sum_sq1);
+    }
+
+    reduction.min = _mm512_reduce_min_ps(low);
+    reduction.max = _mm512_reduce_max_ps(high);
+    reduction.sum = _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+    reduction.sum_sq = _mm512_reduce_add_pd(_mm512_add_pd(sum_sq0, sum_sq1));
+    accumulateScalar(values + i, count - i, shift, reduction);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+typedef void (*minmax_kernel_t)(const float*, const size_t, float&, float&);
+typedef void (*minmaxsums_kernel_t)(const float*, const size_t, const float, Reduction&);
+
+/// <summary>
+/// Selects the range kernel for an instruction set level
+/// </summary>
+static minmax_kernel_t selectMinMaxKernel(const SimdLevel level)
+{
+    switch (level)
+    {
+#ifdef SIMD_HAVE_AVX512
+        case SimdAVX512: return &minMaxAVX512;
+#endif
+#ifdef SIMD_HAVE_AVX2
+        case SimdAVX2:   return &minMaxAVX2;
+#endif
+        case SimdSSE2:   return &minMaxSSE2;
+        default:         return &minMaxScalar;
+    }
+}
+
+/// <summary>
+/// Selects the range and sums kernel for an instruction set level
+/// </summary>
+static minmaxsums_kernel_t selectMinMaxSumsKernel(const SimdLevel level)
+{
+    switch (level)
+    {
+#ifdef SIMD_HAVE_AVX512
+        case SimdAVX512: return &minMaxSumsAVX512;
+#endif
+#ifdef SIMD_HAVE_AVX2
+        case SimdAVX2:   return &minMaxSumsAVX2;
+#endif
+        case SimdSSE2:   return &minMaxSumsSSE2;
+        default:         return &minMaxSumsScalar;
+    }
+}
+
+/// <summary>The kernels are selected once, at startup</summary>
+static const SimdLevel simd_level = detectSimdLevel();
+static const minmax_kernel_t minmax_kernel = selectMinMaxKernel(simd_level);
+static const minmaxsums_kernel_t minmaxsums_kernel = selectMinMaxSumsKernel(simd_level);
+
+/// <summary>
+/// Gets the instruction set extension the kernels were selected for at startup
+/// </summary>
+/// <returns>The level.</returns>
+SimdLevel simdLevel()
+{
+    return simd_level;
+}
+
+/// <summary>
+/// Determines the range of contiguous values; NaN values are skipped.
+/// An empty run yields FLT_MAX as minimum and -FLT_MAX as maximum.
+/// </summary>
+/// <param name="values">The values.</param>
+/// <param name="count">The number of values.</param>
+/// <param name="min">The minimum value.</param>
+/// <param name="max">The maximum value.</param>
+void reduceMinMax(const float* values, const size_t count, float& min, float& max)
+{
+    minmax_kernel(values, count, min, max);
+}
+
+/// <summary>
+/// Determines the range of contiguous values, and the sum and sum of squares of their differences to a shift value, in a single pass
+/// </summary>
+/// <param name="values">The values.</param>
+/// <param name="count">The number of values.</param>
+/// <param name="shift">The shift; Ideally close to the mean, e.g. the first value.</param>
+/// <param name="reduction">The reduction.</param>
+void reduceMinMaxSums(const float* values, const size_t count, const float shift, Reduction& reduction)
+{
+    minmaxsums_kernel(values, count, shift, reduction);
+}
\ No newline at end of file
@@ -7,13 +7,14 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
-#include <random>
 
 #include <opencv/cv.h>
 #include <opencv/cxcore.h>
 #include <opencv/highgui.h>
 
 #include "FloatImage.h"
+#include "ImageExpression.h"
+#include "ImageWriter.h"
 #include "Application.h"
 
 using namespace std;
@@ -79,9 +80,9 @@ image_t Application::loadRawU8(const std::string filepath, const samples_t sampl
 /// <summary>
 /// Convolves the image with a dirac (unit) kernel
 /// </summary>
-/// <param name="raw">The raw image.</param>
+/// <param name="raw">The raw image; The halo must cover the kernel.</param>
 /// <returns>The convolved image in OpenCV format.</returns>
-IplImagePtr Application::convolveDirac(const image_t& raw)
+IplImagePtr Application::convolveDirac(const tiledimage_t& raw)
 {
     // === create a 3x3 unit kernel ===
     
@@ -90,7 +91,7 @@ IplImagePtr Application::convolveDirac(const image_t& raw)
 
     // === convolve with the kernel ===
     
-    auto convolved = raw->convolve(kernel);
+    auto convolved = raw->convolve(kernel->view());
 
     // === convert to OpenCV ===
     
@@ -100,9 +101,9 @@ IplImagePtr Application::convolveDirac(const image_t& raw)
 /// <summary>
 /// Convolves the image with a box blur kernel
 /// </summary>
-/// <param name="raw">The raw image.</param>
+/// <param name="raw">The raw image; The halo must cover the kernel.</param>
 /// <returns>The convolved image in OpenCV format.</returns>
-IplImagePtr Application::convolveBox(const image_t& raw)
+IplImagePtr Application::convolveBox(const tiledimage_t& raw)
 {
     // === create a 9x9 box blur kernel ===
     
@@ -117,7 +118,7 @@ IplImagePtr Application::convolveBox(const image_t& raw)
 
     // === convolve with the kernel ===
     
-    auto convolved = raw->convolve(kernel);
+    auto convolved = raw->convolve(kernel->view());
 
     // === convert to OpenCV ===
     
@@ -127,9 +128,9 @@ IplImagePtr Application::convolveBox(const image_t& raw)
 /// <summary>
 /// Convolves the image with a laplacian (high-pass) kernel
 /// </summary>
-/// <param name="raw">The raw image.</param>
+/// <param name="raw">The raw image; The halo must cover the kernel.</param>
 /// <returns>The convolved image in OpenCV format.</returns>
-IplImagePtr Application::convolveLaplacian(const image_t& raw)
+IplImagePtr Application::convolveLaplacian(const tiledimage_t& raw)
 {
     // === create a 3x3 laplacian kernel ===
     
@@ -140,7 +141,7 @@ IplImagePtr Application::convolveLaplacian(const image_t& raw)
 
     // === convolve with the kernel ===
     
-    auto convolved = raw->convolve(kernel);
+    auto convolved = raw->convolve(kernel->view());
 
     // === convert to OpenCV ===
     
@@ -150,9 +151,9 @@ IplImagePtr Application::convolveLaplacian(const image_t& raw)
 /// <summary>
 /// Convolves the image with a gaussian (low-pass) kernel
 /// </summary>
-/// <param name="raw">The raw image.</param>
+/// <param name="raw">The raw image; The halo must cover the kernel.</param>
 /// <returns>The convolved image in OpenCV format.</returns>
-IplImagePtr Application::convolveGaussian(const image_t& raw)
+IplImagePtr Application::convolveGaussian(const tiledimage_t& raw)
 {
     // === create a 3x3 laplacian kernel ===
     
@@ -167,7 +168,7 @@ IplImagePtr Application::convolveGaussian(const image_t& raw)
 
     // === convolve with the kernel ===
     
-    auto convolved = raw->convolve(kernel);
+    auto convolved = raw->convolve(kernel->view());
 
     // === convert to OpenCV ===
     
@@ -177,9 +178,9 @@ IplImagePtr Application::convolveGaussian(const image_t& raw)
 /// <summary>
 /// Convolves the image with a laplacian-of-gaussian (high-pass) kernel
 /// </summary>
-/// <param name="raw">The raw image.</param>
+/// <param name="raw">The raw image; The halo must cover the kernel.</param>
 /// <returns>The convolved image in OpenCV format.</returns>
-IplImagePtr Application::convolveLoG(const image_t& raw)
+IplImagePtr Application::convolveLoG(const tiledimage_t& raw)
 {
     // === create a 3x3 laplacian kernel ===
     
@@ -196,7 +197,7 @@ IplImagePtr Application::convolveLoG(const image_t& raw)
 
     // === convolve with the kernel ===
     
-    auto convolved = raw->convolve(kernel);
+    auto convolved = raw->convolve(kernel->view());
 
     // === convert to OpenCV ===
     
@@ -210,31 +211,14 @@ IplImagePtr Application::convolveLoG(const image_t& raw)
 /// <param name="image">The image.</param>
 /// <param name="gain">The noise gain (implicit signal to noise ratio).</param>
 /// <param name="standard_deviation">The noise standard deviation.</param>
-void Application::applyAWGN(image_t& image, const float gain, const float standard_deviation)
+/// <param name="seed">The noise seed.</param>
+void Application::applyAWGN(image_t& image, const float gain, const float standard_deviation, const uint64_t seed)
 {
-    // create the noise distribution
     const float mean = 0.0F;
-    normal_distribution<float> distribution(mean, standard_deviation);
+    FloatImage& target = *image;
 
-    // the generator used
-    default_random_engine generator;
-
-    // apply the noise
-    const samples_t samples = image->samples;
-    const lines_t lines = image->lines;
-    for (lines_t lineIndex = 0; lineIndex < lines; ++lineIndex)
-    {
-        line_t& line = image->line(lineIndex);
-
-        // THEORY: Band agnostic, since samples should contain all bands
-        for(samples_t x=0; x<samples; ++x)
-        {
-            sample_t& sample = line->sample(x);
-            
-            const sample_t noise = static_cast<sample_t>(gain * distribution(generator));
-            sample += noise;
-        }
-    }
+    // band agnostic, since the expression is evaluated for every value
+    target = target + gain * gaussianNoise(mean, standard_deviation, seed);
 }
 
 /// <summary>
@@ -245,51 +229,100 @@ void Application::applyAWGN(image_t& image, const float gain, const float standa
 /// <param name="salt_probability">The probability of salt values (0..1)</param>
 /// <param name="pepper_value">The pepper value (low value).</param>
 /// <param name="salt_value">The salt value (high value).</param>
-void Application::applySnP(image_t& image, const float pepper_probability, const float salt_probability, const sample_t& pepper_value, const sample_t& salt_value)
+/// <param name="seed">The noise seed.</param>
+void Application::applySnP(image_t& image, const float pepper_probability, const float salt_probability, const sample_t& pepper_value, const sample_t& salt_value, const uint64_t seed)
 {
     assert (salt_probability + pepper_probability <= 1.0F);
 
-    // create the noise distribution
-    uniform_real_distribution<float> distribution(0.0F, 1.0F);
+    // define the thresholds
+    const float pepper_threshold = 0.0F + pepper_probability;
+    const float salt_threshold   = 1.0F - salt_probability;
 
-    // the generator used
-    default_random_engine generator;
+    const UniformNoiseExpression noise = uniformNoise(seed);
+    FloatImage& target = *image;
 
-    // define the thresholds
+    target = where(noise <= pepper_threshold, pepper_value,
+             where(noise >= salt_threshold,   salt_value,
+                   target));
+}
+
+/// <summary>
+/// Applies additive white gaussian noise, followed by salt-and-pepper noise, in a single pass over the image.
+/// Gives the same result as <see cref="applyAWGN"/> followed by <see cref="applySnP"/> with the same seed.
+/// </summary>
+/// <param name="image">The image or image region; The noise is applied in place.</param>
+/// <param name="gain">The gaussian noise gain (implicit signal to noise ratio).</param>
+/// <param name="standard_deviation">The gaussian noise standard deviation.</param>
+/// <param name="pepper_probability">The probability of pepper values (0..1).</param>
+/// <param name="salt_probability">The probability of salt values (0..1)</param>
+/// <param name="pepper_value">The pepper value (low value).</param>
+/// <param name="salt_value">The salt value (high value).</param>
+/// <param name="seed">The noise seed.</param>
+void Application::applyNoise(const FloatImageView& image, const float gain, const float standard_deviation, const float pepper_probability, const float salt_probability, const sample_t& pepper_value, const sample_t& salt_value, const uint64_t seed)
+{
+    assert (salt_probability + pepper_probability <= 1.0F);
+
+    const float mean = 0.0F;
     const float pepper_threshold = 0.0F + pepper_probability;
     const float salt_threshold   = 1.0F - salt_probability;
 
-    // apply the noise
-    const samples_t samples = image->samples;
-    const lines_t lines = image->lines;
-    for (lines_t lineIndex = 0; lineIndex < lines; ++lineIndex)
+    const UniformNoiseExpression noise = uniformNoise(seed);
+    const FloatImageView& target = image;
+
+    target.assign(where(noise <= pepper_threshold, pepper_value,
+                  where(noise >= salt_threshold,   salt_value,
+                        target + gain * gaussianNoise(mean, standard_deviation, seed))));
+}
+
+/// <summary>
+/// Calculates the peak signal-to-noise ratio of an image with respect to a reference image; Lines are compared in parallel.
+/// </summary>
+/// <param name="reference">The reference image.</param>
+/// <param name="image">The image; Must have the size of the reference image.</param>
+/// <returns>The ratio in dB, with white as the peak value.</returns>
+double Application::peakSignalToNoiseRatio(const FloatImageView& reference, const FloatImageView& image)
+{
+    assert(reference.samples == image.samples && reference.lines == image.lines && reference.bands == image.bands);
+
+    const samples_t values = image.samples * image.bands;
+    vector<double> line_errors(image.lines);
+
+    // OpenMP needs signed integral type
+    typedef int_fast64_t omp_linecount_t;
+    omp_linecount_t omp_lines = image.lines;
+
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
     {
-        line_t& line = image->line(lineIndex);
+        const sample_t* reference_line = reference.line(y).get_samples();
+        const sample_t* image_line = image.line(y).get_samples();
 
-        // THEORY: Band agnostic, since samples should contain all bands
-        for(samples_t x=0; x<samples; ++x)
+        double error = 0.0;
+        for (samples_t x = 0; x < values; ++x)
         {
-            sample_t& sample = line->sample(x);
-            
-            const float noise_percentage = distribution(generator);
-            if (noise_percentage <= pepper_threshold)
-            {
-                sample = pepper_value;
-            }
-            else if (noise_percentage >= salt_threshold)
-            {
-                sample = salt_value;
-            }
-            
+            const double difference = static_cast<double>(image_line[x]) - reference_line[x];
+            error += difference * difference;
         }
+        line_errors[y] = error;
+    }
+
+    double error = 0.0;
+    for (lines_t y = 0; y < image.lines; ++y)
+    {
+        error += line_errors[y];
     }
+
+    const double mean_squared_error = error / (static_cast<double>(values) * image.lines);
+    const double peak = SampleTraits<sample_t>::white();
+    return 10.0 * log10(peak * peak / mean_squared_error);
 }
 
 /// <summary>
 /// Implements a bubble sort algorithm
 /// </summary>
 /// <param name="samples">The samples to be sorted in place.</param>
-void bubbleSort(vector<sample_t>& samples)
+template <typename T>
+void bubbleSort(vector<T>& samples)
 {
     uint_fast16_t count = samples.size();
     assert (count > 0);
@@ -310,72 +343,77 @@ void bubbleSort(vector<sample_t>& samples)
 }
 
 /// <summary>
-/// Convolves the image with the given kernel.
+/// Applies a median filter of the given size to an image region.
 /// </summary>
-/// <param name="kernel">The kernel.</param>
-/// <returns>The convolved image.</returns>
-image_t Application::applyMedianFilter(const image_t& raw, const uint_fast8_t size)
+/// <param name="raw">The image region; Windows reaching beyond the region read the neighbouring samples of the image or, at the
+/// image borders, the halo filled according to its border policy (see <see cref="Image::fillBorder"/>). Samples are only
+/// treated as missing where the halo doesn't cover the kernel.</param>
+/// <param name="size">The kernel size, must be an odd number.</param>
+/// <returns>The filtered image.</returns>
+template <typename T>
+unique_ptr<Image<T>> Application::applyMedianFilter(const ImageView<T>& raw, const uint_fast8_t size)
 {
-    assert (raw->bands == 1);
+    assert (raw.bands == 1);
     assert ((size & 0x1) == 0x1); // size must be odd
 
     // image to hold the convolved image
-    image_t target(new FloatImage(raw->samples, raw->lines, raw->bands, false));
+    unique_ptr<Image<T>> target(new Image<T>(raw.samples, raw.lines, raw.bands, false));
 
-    const samples_t raw_samples     = raw->samples;
-    const lines_t raw_lines         = raw->lines;
+    const samples_t raw_samples     = raw.samples;
+    const lines_t raw_lines         = raw.lines;
     
     const ssamples_t kernel_halfsamples = static_cast<slines_t>(size) / 2;
     const slines_t kernel_halflines = static_cast<slines_t>(size) / 2;  
 
+    // the bounds checks can be dropped if the window always lies within the region or its halo
+    const bool padded = raw.halo >= kernel_halfsamples;
+
     // the samples within the kernel window
-    vector<sample_t> kernel_samples;
+    vector<T> kernel_samples;
 
     // OpenMP needs signed integral type
-    typedef int_fast32_t omp_linecount_t;
+    typedef int_fast64_t omp_linecount_t;
     omp_linecount_t omp_lines = raw_lines;
 
     #pragma omp parallel for private(kernel_samples)
     for (omp_linecount_t y = 0; y < omp_lines; ++y)
     {
-        line_t &target_line = target->line(y);
+        const ImageLine<T> target_line = target->line(y);
 
         // loop over all samples
         for (samples_t x = 0; x < raw_samples; ++x)
         {
             // correlate the pixels in mask-space (in the area overlayed by the mask)
-            sample_t sample_value = 0.0F;
-            sample_t kernel_sum = 0.0F;
-
             for (lines_t my = 0; my < size; ++my) // loop all lines in kernel-space
             {
                 // calculate the image line
                 slines_t raw_y = y + my - kernel_halflines;
 
-                // grab the kernel and image lines assuming they're valid
-                const line_t &raw_line = raw->line(raw_y);
-                
-                // branch prediction will (have to) save us.
-                // THEORY: Operation might be faster if we handle special cases for the edges and corners (i.e. image boundary overlaps)
-                if (raw_y < 0) continue;
-                if (static_cast<lines_t>(raw_y) >= raw->lines) continue;
-                
+                // without a halo, lines outside of the region are missing
+                if (!padded)
+                {
+                    if (raw_y < 0) continue;
+                    if (static_cast<lines_t>(raw_y) >= raw.lines) continue;
+                }
+
+                // grab the image line
+                const ImageLine<T> raw_line = raw.haloLine(raw_y);
+
                 // loop over pixels (in kernel-space)
                 for (samples_t mx = 0; mx < size; ++mx)
                 {
                     // calculate the image line
                     slines_t raw_x = x + mx - kernel_halfsamples;
 
-                    // grab the kernel and image lines assuming they're valid
-                    const sample_t &raw_sample = raw_line->sample(raw_x);
-
-                    // branch prediction to the rescue
-                    // THEORY: same as above
-                    if (raw_x < 0) continue;
-                    if (static_cast<samples_t>(raw_x) >= raw->samples) continue;
+                    // same as above
+                    if (!padded)
+                    {
+                        if (raw_x < 0) continue;
+                        if (static_cast<samples_t>(raw_x) >= raw.samples) continue;
+                    }
 
                     // take sample
-                    kernel_samples.push_back(raw_sample);
+                    kernel_samples.push_back(raw_line.sample(raw_x));
                 }
             }
 
@@ -385,10 +423,10 @@ image_t Application::applyMedianFilter(const image_t& raw, const uint_fast8_t si
             bubbleSort(kernel_samples);
 
             // pick median value
-            sample_t median = kernel_samples[sample_count/2];
+            T median = kernel_samples[sample_count/2];
 
             // set value (adjust to effective summed kernel values)
-            target_line->sample(x) = median;
+            target_line.sample(x) = median;
 
             // discard samples
             kernel_samples.clear();
@@ -398,6 +436,101 @@ image_t Application::applyMedianFilter(const image_t& raw, const uint_fast8_t si
     return target;
 }
 
+/// <summary>
+/// Adds or removes one column of the median window to or from the window histogram
+/// </summary>
+/// <param name="raw">The image region.</param>
+/// <param name="x">The column.</param>
+/// <param name="line_first">The first line of the window.</param>
+/// <param name="line_last">The last line of the window.</param>
+/// <param name="histogram">The window histogram.</param>
+/// <param name="count">The number of samples in the window.</param>
+/// <param name="add">If true the column is added, otherwise removed.</param>
+static inline void updateMedianHistogram(const ImageView<uint8_t>& raw, const samples_t& x, const slines_t& line_first, const slines_t& line_last, uint_fast16_t (&histogram)[256], uint_fast16_t& count, const bool add)
+{
+    for (slines_t y = line_first; y <= line_last; ++y)
+    {
+        const uint8_t value = raw.haloLine(y).sample(x);
+        if (add) { ++histogram[value]; ++count; }
+        else     { --histogram[value]; --count; }
+    }
+}
+
+/// <summary>
+/// Applies a median filter of the given size to an 8-bit image region.
+/// Instead of sorting every window, a 256-bin histogram is slid along each line and only
+/// the entering and leaving columns are updated (Huang et al.).
+/// </summary>
+/// <param name="raw">The image region; Windows reaching beyond the region read the neighbouring samples of the image or, at the
+/// image borders, the halo filled according to its border policy (see <see cref="Image::fillBorder"/>). Samples are only
+/// treated as missing where the halo doesn't cover the kernel.</param>
+/// <param name="size">The kernel size, must be an odd number.</param>
+/// <returns>The filtered image.</returns>
+template <>
+u8image_t Application::applyMedianFilter<uint8_t>(const ImageView<uint8_t>& raw, const uint_fast8_t size)
+{
+    assert (raw.bands == 1);
+    assert ((size & 0x1) == 0x1); // size must be odd
+
+    u8image_t target(new U8Image(raw.samples, raw.lines, raw.bands, false));
+
+    const samples_t raw_samples     = raw.samples;
+    const lines_t raw_lines         = raw.lines;
+    const slines_t kernel_half      = static_cast<slines_t>(size) / 2;
+
+    // with a halo covering the window, the window is never clipped
+    const bool padded = raw.halo >= kernel_half;
+
+    // OpenMP needs signed integral type
+    typedef int_fast64_t omp_linecount_t;
+    omp_linecount_t omp_lines = raw_lines;
+
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
+    {
+        const ImageLine<uint8_t> target_line = target->line(y);
+
+        // the lines covered by the window, clipped to the region unless it has a halo
+        const slines_t line_first = padded ? static_cast<slines_t>(y) - kernel_half : max<slines_t>(static_cast<slines_t>(y) - kernel_half, 0);
+        const slines_t line_last  = padded ? static_cast<slines_t>(y) + kernel_half : min<slines_t>(static_cast<slines_t>(y) + kernel_half, static_cast<slines_t>(raw_lines) - 1);
+
+        // prime the histogram with the first window (its right half, unless there is a halo)
+        uint_fast16_t histogram[256] = { 0 };
+        uint_fast16_t count = 0;
+        for (samples_t x = padded ? -kernel_half : 0; x <= kernel_half && (padded || x < raw_samples); ++x)
+        {
+            updateMedianHistogram(raw, x, line_first, line_last, histogram, count, true);
+        }
+
+        for (samples_t x = 0; x < raw_samples; ++x)
+        {
+            // slide the window: add the entering column, remove the leaving one
+            if (x > 0)
+            {
+                const samples_t entering = x + kernel_half;
+                const samples_t leaving = x - kernel_half - 1;
+                if (padded || entering < raw_samples) updateMedianHistogram(raw, entering, line_first, line_last, histogram, count, true);
+                if (padded || leaving >= 0)           updateMedianHistogram(raw, leaving, line_first, line_last, histogram, count, false);
+            }
+
+            // pick median value: the first value whose cumulative count exceeds half the window
+            assert(count > 0);
+            const uint_fast16_t rank = count / 2;
+            uint_fast16_t cumulative = 0;
+            uint_fast16_t value = 0;
+            for (; value < 255; ++value)
+            {
+                cumulative += histogram[value];
+                if (cumulative > rank) break;
+            }
+
+            target_line.sample(x) = static_cast<uint8_t>(value);
+        }
+    }
+
+    return target;
+}
+
 /// <summary>
 /// Runs this instance.
 /// </summary>
@@ -409,16 +542,21 @@ void Application::run()
     const lines_t       raw_lines = 512;
 
 #if USE_REAL_LENA
-    auto raw = loadRawU8("./images/lena.raw", raw_samples, raw_lines);
-    raw->flipVertical();
+    auto loaded = loadRawU8("./images/lena.raw", raw_samples, raw_lines);
+    loaded->flipVertical();
 #else
-    auto raw = loadRawU8("./images/lenaml.raw", raw_samples, raw_lines);
+    auto loaded = loadRawU8("./images/lenaml.raw", raw_samples, raw_lines);
 #endif
+
+    // the clean frame is shared with the noise stage, which gets its own copy on write; the clean frame stays
+    // available as the reference for the filtered images
+    SharedFloatImage clean(std::move(loaded));
+    SharedFloatImage noisy(clean);
     
     // === display raw picture ===
 
     OpenCvWindow& window_raw = createWindow("raw picture");
-    auto raw_cv = raw->toOpenCv();
+    auto raw_cv = clean.view().toOpenCv();
     window_raw.showImage(raw_cv);
     cvWaitKey(1);
 
@@ -427,51 +565,56 @@ void Application::run()
     const float awgn_gain = 0.5F; // encodes the signal-to-noise ratio
     const float awgn_standard_deviation = 0.125F;
 
-    cout << "Applying additive white gaussian noise ... ";
-    applyAWGN(raw, awgn_gain, awgn_standard_deviation);
-    cout << "done." << endl;
-
     const float snp_salt = 1.0F;
     const float snp_pepper = 0.0F;
     const float snp_salt_probability = 0.01F;
     const float snp_pepper_probability = 0.01F;
 
-    cout << "Applying salt-and-pepper noise ... ";
-    applySnP(raw, snp_pepper_probability, snp_salt_probability, snp_salt, snp_pepper);
+    cout << "Applying additive white gaussian and salt-and-pepper noise ... ";
+    applyNoise(noisy.writableView(), awgn_gain, awgn_standard_deviation, snp_pepper_probability, snp_salt_probability, snp_salt, snp_pepper);
     cout << "done." << endl;
 
-    auto noise_cv = raw->toOpenCv();
+    const FloatImageView raw = noisy.view();
+    auto noise_cv = raw.toOpenCv();
+
+    // === tile the image ===
+
+    // every neighborhood operator below works tile by tile; the halo covers the largest (9x9 box) kernel
+    // and is filled by replicating the image border, so no operator needs to check bounds
+    const samples_t tile_halo = 4;
+    auto tiled = FloatTiledImage::fromImage(raw, tile_halo);
 
     // === convolve images ===
 
     cout << "Convolving with Dirac ... ";
-    auto dirac_cv = convolveDirac(raw);
+    auto dirac_cv = convolveDirac(tiled);
     cout << "done." << endl;
 
     cout << "Convolving with Box ... ";
-    auto box_cv = convolveBox(raw);
+    auto box_cv = convolveBox(tiled);
     cout << "done." << endl;
 
     cout << "Convolving with Gaussian ... ";
-    auto gaussian_cv = convolveGaussian(raw);
+    auto gaussian_cv = convolveGaussian(tiled);
     cout << "done." << endl;
 
     cout << "Convolving with Laplacian ... ";
-    auto laplacian_cv = convolveLaplacian(raw);
+    auto laplacian_cv = convolveLaplacian(tiled);
     cout << "done." << endl;
 
     cout << "Convolving with Laplacian-of-Gaussian ... ";
-    auto log_cv = convolveLoG(raw);
+    auto log_cv = convolveLoG(tiled);
     cout << "done." << endl;
 
     cout << "Applying median filter ... ";
     const uint_fast8_t median_filter_size = 5;
-    auto median = applyMedianFilter(raw, median_filter_size);
+    auto median = applyMedianFilter(tiled, median_filter_size);
     auto median_cv = median->toOpenCv();
     cout << "done." << endl;
+    cout << "PSNR of the noisy image: " << peakSignalToNoiseRatio(clean.view(), raw) << " dB, of the median filtered image: " << peakSignalToNoiseRatio(clean.view(), median->view()) << " dB" << endl;
     
     cout << "Convolving median filtered image with Laplacian filter ... ";
-    auto median_laplacian_cv = convolveLaplacian(median);
+    auto median_laplacian_cv = convolveLaplacian(FloatTiledImage::fromImage(median->view(), tile_halo));
     cout << "done." << endl;
 
     // === display noisy picture ===
@@ -479,6 +622,7 @@ void Application::run()
     OpenCvWindow& window_noise = createWindow("noisy picture");
     window_noise.showImage(noise_cv);
     cvSaveImage("./mas04_noise.jpg", noise_cv.get());
+    writeENVI(raw, "./mas04_noise");
     cvWaitKey(1);
 
     // === display dirac convolved picture ===
@@ -521,6 +665,7 @@ void Application::run()
     OpenCvWindow& window_median = createWindow("3x3 median filtered");
     window_median.showImage(median_cv);
     cvSaveImage("./mas04_median_3x3.jpg", median_cv.get());
+    writePFM(median->view(), "./mas04_median_3x3.pfm");
     cvWaitKey(1);
 
     // === display laplacian filtered median filtered picture ===
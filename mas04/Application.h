@@ -11,6 +11,8 @@
 #include "FloatImage.h"
 #include "OpenCvImage.h"
 #include "OpenCvWindow.h"
+#include "SharedImage.h"
+#include "TiledImage.h"
 
 /// <summary>Marks a variable as output</summary>
 #define out
@@ -84,37 +86,37 @@ private:
     /// <summary>
     /// Convolves the image with a dirac (unit) kernel
     /// </summary>
-    /// <param name="raw">The raw image.</param>
+    /// <param name="raw">The raw image; The halo must cover the kernel.</param>
     /// <returns>The convolved image in OpenCV format.</returns>
-    static IplImagePtr convolveDirac(const image_t& raw);
+    static IplImagePtr convolveDirac(const tiledimage_t& raw);
 
     /// <summary>
     /// Convolves the image with a box blur kernel
     /// </summary>
-    /// <param name="raw">The raw image.</param>
+    /// <param name="raw">The raw image; The halo must cover the kernel.</param>
     /// <returns>The convolved image in OpenCV format.</returns>
-    static IplImagePtr convolveBox(const image_t& raw);
+    static IplImagePtr convolveBox(const tiledimage_t& raw);
     
     /// <summary>
     /// Convolves the image with a gaussian (low-pass) kernel
     /// </summary>
-    /// <param name="raw">The raw image.</param>
+    /// <param name="raw">The raw image; The halo must cover the kernel.</param>
     /// <returns>The convolved image in OpenCV format.</returns>
-    IplImagePtr convolveGaussian(const image_t& raw);
+    IplImagePtr convolveGaussian(const tiledimage_t& raw);
 
     /// <summary>
     /// Convolves the image with a laplacian (high-pass) kernel
     /// </summary>
-    /// <param name="raw">The raw image.</param>
+    /// <param name="raw">The raw image; The halo must cover the kernel.</param>
     /// <returns>The convolved image in OpenCV format.</returns>
-    static IplImagePtr convolveLaplacian(const image_t& raw);
+    static IplImagePtr convolveLaplacian(const tiledimage_t& raw);
 
     /// <summary>
     /// Convolves the image with a laplacian-of-gaussian (high-pass) kernel
     /// </summary>
-    /// <param name="raw">The raw image.</param>
+    /// <param name="raw">The raw image; The halo must cover the kernel.</param>
     /// <returns>The convolved image in OpenCV format.</returns>
-    static IplImagePtr convolveLoG(const image_t& raw);
+    static IplImagePtr convolveLoG(const tiledimage_t& raw);
 
     /// <summary>
     /// Applies an additive white gaussian noise.
@@ -122,7 +124,8 @@ private:
     /// <param name="image">The image.</param>
     /// <param name="gain">The noise gain (implicit signal to noise ratio).</param>
     /// <param name="standard_deviation">The noise standard deviation.</param>
-    static void applyAWGN(image_t& image, const float gain = 1.0F, const float standard_deviation = 1.0F);
+    /// <param name="seed">The noise seed.</param>
+    static void applyAWGN(image_t& image, const float gain = 1.0F, const float standard_deviation = 1.0F, const uint64_t seed = 0);
 
     /// <summary>
     /// Applies salt-and-pepper noise
@@ -132,7 +135,29 @@ private:
     /// <param name="salt_probability">The probability of salt values (0..1)</param>
     /// <param name="pepper_value">The pepper value (low value).</param>
     /// <param name="salt_value">The salt value (high value).</param>
-    static void applySnP(image_t& image, const float pepper_probability = 0.01F, const float salt_probability = 0.01F, const sample_t& pepper_value = 0.0F, const sample_t& salt_value = 1.0F);
+    /// <param name="seed">The noise seed.</param>
+    static void applySnP(image_t& image, const float pepper_probability = 0.01F, const float salt_probability = 0.01F, const sample_t& pepper_value = 0.0F, const sample_t& salt_value = 1.0F, const uint64_t seed = 0);
+
+    /// <summary>
+    /// Applies additive white gaussian noise, followed by salt-and-pepper noise, in a single pass over the image.
+    /// </summary>
+    /// <param name="image">The image or image region; The noise is applied in place.</param>
+    /// <param name="gain">The gaussian noise gain (implicit signal to noise ratio).</param>
+    /// <param name="standard_deviation">The gaussian noise standard deviation.</param>
+    /// <param name="pepper_probability">The probability of pepper values (0..1).</param>
+    /// <param name="salt_probability">The probability of salt values (0..1)</param>
+    /// <param name="pepper_value">The pepper value (low value).</param>
+    /// <param name="salt_value">The salt value (high value).</param>
+    /// <param name="seed">The noise seed.</param>
+    static void applyNoise(const FloatImageView& image, const float gain, const float standard_deviation, const float pepper_probability, const float salt_probability, const sample_t& pepper_value, const sample_t& salt_value, const uint64_t seed = 0);
+
+    /// <summary>
+    /// Calculates the peak signal-to-noise ratio of an image with respect to a reference image; Lines are compared in parallel.
+    /// </summary>
+    /// <param name="reference">The reference image.</param>
+    /// <param name="image">The image; Must have the size of the reference image.</param>
+    /// <returns>The ratio in dB, with white as the peak value.</returns>
+    static double peakSignalToNoiseRatio(const FloatImageView& reference, const FloatImageView& image);
 
     /// <summary>
     /// Applies a median filter of the given size.
@@ -140,7 +165,55 @@ private:
     /// <param name="raw">The image.</param>
     /// <param name="size">The kernel size, must be an odd number.</param>
     /// <returns>The filtered image.</returns>
-    static image_t applyMedianFilter(const image_t& raw, const uint_fast8_t size = 3);
+    template <typename T>
+    static inline std::unique_ptr<Image<T>> applyMedianFilter(const std::unique_ptr<Image<T>>& raw, const uint_fast8_t size = 3)
+    {
+        return applyMedianFilter(raw->view(), size);
+    }
+
+    /// <summary>
+    /// Applies a median filter of the given size to an image region.
+    /// </summary>
+    /// <param name="raw">The image region; Windows reaching beyond the region read the neighbouring samples of the image or, at the
+    /// image borders, the halo filled according to its border policy (see <see cref="Image::fillBorder"/>). Samples are only
+    /// treated as missing where the halo doesn't cover the kernel.</param>
+    /// <param name="size">The kernel size, must be an odd number.</param>
+    /// <returns>The filtered image.</returns>
+    template <typename T>
+    static std::unique_ptr<Image<T>> applyMedianFilter(const ImageView<T>& raw, const uint_fast8_t size = 3);
+
+    /// <summary>
+    /// Applies a median filter of the given size tile by tile.
+    /// </summary>
+    /// <param name="raw">The tiled image; The halo must cover half the kernel size.</param>
+    /// <param name="size">The kernel size, must be an odd number.</param>
+    /// <returns>The filtered image.</returns>
+    template <typename T>
+    static inline std::unique_ptr<Image<T>> applyMedianFilter(const std::unique_ptr<TiledImage<T>>& raw, const uint_fast8_t size = 3)
+    {
+        assert(size / 2 <= raw->halo);
+        return raw->template apply<T>(MedianOperator<T>(size));
+    }
+
+private:
+    /// <summary>
+    /// Median filter operator for <see cref="TiledImage::apply"/>
+    /// </summary>
+    template <typename T>
+    struct MedianOperator
+    {
+        const uint_fast8_t size;
+
+        explicit MedianOperator(const uint_fast8_t size) : size(size) {}
+
+        inline std::unique_ptr<Image<T>> operator()(const ImageView<T>& tile) const
+        {
+            return applyMedianFilter(tile, size);
+        }
+
+    private:
+        MedianOperator& operator=(const MedianOperator&);
+    };
 };
 
 #endif
\ No newline at end of file
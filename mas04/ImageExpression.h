@@ -0,0 +1,288 @@
+#ifndef _IMAGEEXPRESSION_H_
+#define _IMAGEEXPRESSION_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "Image.h"
+
+/// <summary>
+/// Describes how an expression is held by the expressions using it.
+/// Images are held by reference, everything else (views, scalars and intermediate nodes) by value,
+/// so that expressions may outlive the temporaries they were built from.
+/// </summary>
+template <typename E> struct ExpressionStorage              { typedef const E type; };
+template <typename T> struct ExpressionStorage<Image<T>>    { typedef const Image<T>& type; };
+
+/// <summary>
+/// A constant value
+/// </summary>
+struct ScalarExpression : public ImageExpression<ScalarExpression>
+{
+    const float value;
+
+    explicit ScalarExpression(const float value) : value(value) {}
+
+    inline float evaluate(const lines_t&, const samples_t&) const
+    {
+        return value;
+    }
+
+    inline bool matches(const samples_t&, const lines_t&) const
+    {
+        return true;
+    }
+};
+
+/// <summary>
+/// Combines two expressions value by value
+/// </summary>
+template <typename L, typename R, typename Operation>
+struct BinaryExpression : public ImageExpression<BinaryExpression<L, R, Operation>>
+{
+    typename ExpressionStorage<L>::type left;
+    typename ExpressionStorage<R>::type right;
+
+    BinaryExpression(const L& left, const R& right) : left(left), right(right) {}
+
+    inline float evaluate(const lines_t& line, const samples_t& value) const
+    {
+        return Operation::apply(left.evaluate(line, value), right.evaluate(line, value));
+    }
+
+    inline bool matches(const samples_t& values, const lines_t& lines) const
+    {
+        return left.matches(values, lines) && right.matches(values, lines);
+    }
+};
+
+/// <summary>
+/// Picks the value of one of two expressions, depending on a condition expression
+/// </summary>
+template <typename C, typename A, typename B>
+struct WhereExpression : public ImageExpression<WhereExpression<C, A, B>>
+{
+    typename ExpressionStorage<C>::type condition;
+    typename ExpressionStorage<A>::type if_true;
+    typename ExpressionStorage<B>::type if_false;
+
+    WhereExpression(const C& condition, const A& if_true, const B& if_false) : condition(condition), if_true(if_true), if_false(if_false) {}
+
+    inline float evaluate(const lines_t& line, const samples_t& value) const
+    {
+        return (condition.evaluate(line, value) != 0.0F) ? if_true.evaluate(line, value) : if_false.evaluate(line, value);
+    }
+
+    inline bool matches(const samples_t& values, const lines_t& lines) const
+    {
+        return condition.matches(values, lines) && if_true.matches(values, lines) && if_false.matches(values, lines);
+    }
+};
+
+/// <summary>
+/// Reproducible noise that does not depend on the order of evaluation.
+/// Every value is derived from a hash of the seed and its position, so lines can be evaluated in parallel.
+/// </summary>
+struct NoiseSource
+{
+    const uint64_t seed;
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="NoiseSource"/> struct.
+    /// Different streams give independent noise for the same seed.
+    /// </summary>
+    /// <param name="seed">The seed.</param>
+    /// <param name="stream">The stream.</param>
+    NoiseSource(const uint64_t seed, const uint64_t stream) : seed(seed ^ (stream * 0xD1B54A32D192ED03ULL)) {}
+
+    /// <summary>
+    /// Gets 64 random bits for the given position (SplitMix64 finalizer)
+    /// </summary>
+    inline uint64_t bits(const lines_t& line, const samples_t& value) const
+    {
+        uint64_t z = seed ^ ((static_cast<uint64_t>(line) << 32) | static_cast<uint32_t>(value));
+        z += 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+/// <summary>
+/// Uniformly distributed noise in 0..1
+/// </summary>
+struct UniformNoiseExpression : public ImageExpression<UniformNoiseExpression>
+{
+    const NoiseSource source;
+
+    explicit UniformNoiseExpression(const uint64_t seed) : source(seed, 1) {}
+
+    inline float evaluate(const lines_t& line, const samples_t& value) const
+    {
+        return static_cast<float>(source.bits(line, value) >> 40) * (1.0F / 16777216.0F);
+    }
+
+    inline bool matches(const samples_t&, const lines_t&) const
+    {
+        return true;
+    }
+};
+
+/// <summary>
+/// Normally distributed noise (Box-Muller transform)
+/// </summary>
+struct GaussianNoiseExpression : public ImageExpression<GaussianNoiseExpression>
+{
+    const NoiseSource source;
+    const float mean;
+    const float standard_deviation;
+
+    GaussianNoiseExpression(const uint64_t seed, const float mean, const float standard_deviation)
+        : source(seed, 2), mean(mean), standard_deviation(standard_deviation)
+    {}
+
+    inline float evaluate(const lines_t& line, const samples_t& value) const
+    {
+        const uint64_t bits = source.bits(line, value);
+        const float u1 = static_cast<float>((bits >> 40) + 1) * (1.0F / 16777216.0F); // 0 < u1 <= 1
+        const float u2 = static_cast<float>(bits & 0xFFFFFF) * (1.0F / 16777216.0F);
+        return mean + standard_deviation * std::sqrt(-2.0F * std::log(u1)) * std::cos(6.28318530718F * u2);
+    }
+
+    inline bool matches(const samples_t&, const lines_t&) const
+    {
+        return true;
+    }
+};
+
+// value-by-value operations
+struct AddOperation             { static inline float apply(const float a, const float b) { return a + b; } };
+struct SubtractOperation        { static inline float apply(const float a, const float b) { return a - b; } };
+struct MultiplyOperation        { static inline float apply(const float a, const float b) { return a * b; } };
+struct DivideOperation          { static inline float apply(const float a, const float b) { return a / b; } };
+struct MinOperation             { static inline float apply(const float a, const float b) { return (b < a) ? b : a; } };
+struct MaxOperation             { static inline float apply(const float a, const float b) { return (a < b) ? b : a; } };
+struct LessOperation            { static inline float apply(const float a, const float b) { return (a < b) ? 1.0F : 0.0F; } };
+struct LessEqualOperation       { static inline float apply(const float a, const float b) { return (a <= b) ? 1.0F : 0.0F; } };
+struct GreaterOperation         { static inline float apply(const float a, const float b) { return (a > b) ? 1.0F : 0.0F; } };
+struct GreaterEqualOperation    { static inline float apply(const float a, const float b) { return (a >= b) ? 1.0F : 0.0F; } };
+
+/// <summary>Defines a binary operator or function for all combinations of expressions and scalars</summary>
+#define IMAGE_EXPRESSION_BINARY(name, Operation) \
+    template <typename L, typename R> \
+    inline BinaryExpression<L, R, Operation> name(const ImageExpression<L>& left, const ImageExpression<R>& right) \
+    { return BinaryExpression<L, R, Operation>(left.self(), right.self()); } \
+    template <typename L> \
+    inline BinaryExpression<L, ScalarExpression, Operation> name(const ImageExpression<L>& left, const float right) \
+    { return BinaryExpression<L, ScalarExpression, Operation>(left.self(), ScalarExpression(right)); } \
+    template <typename R> \
+    inline BinaryExpression<ScalarExpression, R, Operation> name(const float left, const ImageExpression<R>& right) \
+    { return BinaryExpression<ScalarExpression, R, Operation>(ScalarExpression(left), right.self()); }
+
+IMAGE_EXPRESSION_BINARY(operator+,  AddOperation)
+IMAGE_EXPRESSION_BINARY(operator-,  SubtractOperation)
+IMAGE_EXPRESSION_BINARY(operator*,  MultiplyOperation)
+IMAGE_EXPRESSION_BINARY(operator/,  DivideOperation)
+IMAGE_EXPRESSION_BINARY(operator<,  LessOperation)
+IMAGE_EXPRESSION_BINARY(operator<=, LessEqualOperation)
+IMAGE_EXPRESSION_BINARY(operator>,  GreaterOperation)
+IMAGE_EXPRESSION_BINARY(operator>=, GreaterEqualOperation)
+IMAGE_EXPRESSION_BINARY(min,        MinOperation)
+IMAGE_EXPRESSION_BINARY(max,        MaxOperation)
+
+#undef IMAGE_EXPRESSION_BINARY
+
+/// <summary>
+/// Clamps the expression to the given range
+/// </summary>
+/// <param name="expression">The expression.</param>
+/// <param name="low">The lowest value.</param>
+/// <param name="high">The highest value.</param>
+/// <returns>The clamped expression.</returns>
+template <typename E>
+inline BinaryExpression<BinaryExpression<E, ScalarExpression, MaxOperation>, ScalarExpression, MinOperation> clamp(const ImageExpression<E>& expression, const float low, const float high)
+{
+    return min(max(expression, low), high);
+}
+
+/// <summary>
+/// Picks the value of <paramref name="if_true"/> wherever the condition is non-zero, the value of <paramref name="if_false"/> otherwise.
+/// </summary>
+template <typename C, typename A, typename B>
+inline WhereExpression<C, A, B> where(const ImageExpression<C>& condition, const ImageExpression<A>& if_true, const ImageExpression<B>& if_false)
+{
+    return WhereExpression<C, A, B>(condition.self(), if_true.self(), if_false.self());
+}
+
+template <typename C, typename B>
+inline WhereExpression<C, ScalarExpression, B> where(const ImageExpression<C>& condition, const float if_true, const ImageExpression<B>& if_false)
+{
+    return WhereExpression<C, ScalarExpression, B>(condition.self(), ScalarExpression(if_true), if_false.self());
+}
+
+template <typename C, typename A>
+inline WhereExpression<C, A, ScalarExpression> where(const ImageExpression<C>& condition, const ImageExpression<A>& if_true, const float if_false)
+{
+    return WhereExpression<C, A, ScalarExpression>(condition.self(), if_true.self(), ScalarExpression(if_false));
+}
+
+template <typename C>
+inline WhereExpression<C, ScalarExpression, ScalarExpression> where(const ImageExpression<C>& condition, const float if_true, const float if_false)
+{
+    return WhereExpression<C, ScalarExpression, ScalarExpression>(condition.self(), ScalarExpression(if_true), ScalarExpression(if_false));
+}
+
+/// <summary>
+/// Creates uniformly distributed noise in 0..1
+/// </summary>
+/// <param name="seed">The seed.</param>
+/// <returns>The noise expression.</returns>
+inline UniformNoiseExpression uniformNoise(const uint64_t seed = 0)
+{
+    return UniformNoiseExpression(seed);
+}
+
+/// <summary>
+/// Creates normally distributed noise
+/// </summary>
+/// <param name="mean">The mean.</param>
+/// <param name="standard_deviation">The standard deviation.</param>
+/// <param name="seed">The seed.</param>
+/// <returns>The noise expression.</returns>
+inline GaussianNoiseExpression gaussianNoise(const float mean, const float standard_deviation, const uint64_t seed = 0)
+{
+    return GaussianNoiseExpression(seed, mean, standard_deviation);
+}
+
+/// <summary>
+/// Evaluates the expression and stores the result in the region, in a single pass;
+/// Integer samples are rounded and saturated to their range.
+/// </summary>
+/// <param name="expression">The expression.</param>
+template <typename T>
+template <typename E>
+void ImageView<T>::assign(const ImageExpression<E>& expression) const
+{
+    const E& source = expression.self();
+    const samples_t values = samples * bands;
+    assert(source.matches(values, lines));
+
+    typedef int_fast64_t omp_linecount_t; // OpenMP needs signed integral type
+    omp_linecount_t omp_lines = lines;
+
+    #pragma omp parallel for
+    for (omp_linecount_t y = 0; y < omp_lines; ++y)
+    {
+        T* target = line(y).get_samples();
+
+        // the whole expression is evaluated for each value; no intermediate images
+        for (samples_t x = 0; x < values; ++x)
+        {
+            target[x] = SampleTraits<T>::saturate(source.evaluate(y, x));
+        }
+    }
+}
+
+#endif
\ No newline at end of file
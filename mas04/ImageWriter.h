@@ -0,0 +1,186 @@
+#ifndef _IMAGEWRITER_H_
+#define _IMAGEWRITER_H_
+
+#pragma warning(disable: 4290)
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Image.h"
+
+/// <summary>
+/// The ENVI "data type" code of a sample type
+/// </summary>
+template <typename T> struct ENVIDataType;
+template <> struct ENVIDataType<uint8_t>  { enum { value = 1 }; };
+template <> struct ENVIDataType<uint16_t> { enum { value = 12 }; };
+template <> struct ENVIDataType<float>    { enum { value = 4 }; };
+template <> struct ENVIDataType<double>   { enum { value = 5 }; };
+
+/// <summary>
+/// Determines whether this machine stores the least significant byte first
+/// </summary>
+/// <returns>true if little-endian.</returns>
+inline bool isLittleEndian()
+{
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+}
+
+/// <summary>
+/// Copies consecutive lines of a region into a contiguous buffer
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="first">The first line, counted in file order.</param>
+/// <param name="count">The number of lines.</param>
+/// <param name="bottom_up">If true, the file stores the last line first.</param>
+/// <param name="target">The buffer.</param>
+template <typename T>
+inline void gatherLines(const ImageView<T>& image, const lines_t& first, const lines_t& count, const bool bottom_up, char* target)
+{
+    const size_t line_size = static_cast<size_t>(image.samples) * image.bands * sizeof(T);
+    for (lines_t y = first; y < first + count; ++y)
+    {
+        const lines_t source = bottom_up ? image.lines - 1 - y : y;
+        memcpy(target + (y - first) * line_size, image.line(source).get_samples(), line_size);
+    }
+}
+
+/// <summary>
+/// Writes a header followed by the samples of a region, in native byte order, to a file.
+/// The lines are gathered into buffers of about 4 MiB, so the file is written in large sequential blocks;
+/// In parallel mode, these strips are gathered and written concurrently through separate streams.
+/// </summary>
+/// <param name="path">The path of the file.</param>
+/// <param name="header">The bytes preceding the samples.</param>
+/// <param name="image">The image or image region.</param>
+/// <param name="bottom_up">If true, the last line is written first.</param>
+/// <param name="parallel">If true, strips are written concurrently.</param>
+template <typename T>
+void writeSamples(const std::string& path, const std::string& header, const ImageView<T>& image, const bool bottom_up, const bool parallel) throw(std::runtime_error)
+{
+    const size_t line_size = static_cast<size_t>(image.samples) * image.bands * sizeof(T);
+    const lines_t strip_lines = std::max<lines_t>(1, (4U << 20) / std::max<size_t>(line_size, 1));
+    const lines_t strips = (image.lines + strip_lines - 1) / strip_lines;
+
+    std::ofstream file(path, std::ios_base::binary | std::ios_base::trunc);
+    if (!file.is_open()) throw std::runtime_error("Could not open output file");
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    if (!parallel)
+    {
+        std::vector<char> buffer(static_cast<size_t>(std::min(strip_lines, image.lines)) * line_size);
+        for (lines_t first = 0; first < image.lines; first += strip_lines)
+        {
+            const lines_t count = std::min(strip_lines, image.lines - first);
+            gatherLines(image, first, count, bottom_up, buffer.data());
+            file.write(buffer.data(), static_cast<std::streamsize>(count * line_size));
+        }
+
+        if (!file) throw std::runtime_error("Could not write output file");
+        return;
+    }
+
+    // fix the size of the file up front, so that every strip can be written at its own offset
+    const size_t data_size = static_cast<size_t>(image.lines) * line_size;
+    if (data_size > 0)
+    {
+        file.seekp(static_cast<std::streamoff>(header.size() + data_size - 1));
+        file.put('\0');
+    }
+    file.close();
+    if (!file) throw std::runtime_error("Could not write output file");
+
+    typedef int_fast64_t omp_stripcount_t; // OpenMP needs signed integral type
+    const omp_stripcount_t omp_strips = static_cast<omp_stripcount_t>(strips);
+
+    // exceptions must not leave the parallel region, so failures are collected per strip
+    std::vector<uint8_t> failed(static_cast<size_t>(strips), 0);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_stripcount_t s = 0; s < omp_strips; ++s)
+    {
+        const lines_t first = static_cast<lines_t>(s) * strip_lines;
+        const lines_t count = std::min(strip_lines, image.lines - first);
+
+        std::vector<char> buffer(static_cast<size_t>(count) * line_size);
+        gatherLines(image, first, count, bottom_up, buffer.data());
+
+        // opening for input as well keeps the existing contents
+        std::ofstream part(path, std::ios_base::in | std::ios_base::binary);
+        part.seekp(static_cast<std::streamoff>(header.size() + first * line_size));
+        part.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (!part) failed[s] = 1;
+    }
+
+    if (std::find(failed.begin(), failed.end(), 1) != failed.end()) throw std::runtime_error("Could not write output file");
+}
+
+/// <summary>
+/// Writes the samples of a region to a raw file without any header, line by line in native byte order
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="path">The path of the file.</param>
+/// <param name="parallel">If true, strips of lines are written concurrently.</param>
+template <typename T>
+inline void writeRaw(const ImageView<T>& image, const std::string& path, const bool parallel = false) throw(std::runtime_error)
+{
+    writeSamples(path, std::string(), image, false, parallel);
+}
+
+/// <summary>
+/// Writes a region as an ENVI file: the samples go to <paramref name="base_path"/>.img (band interleaved by pixel),
+/// the header describing them to <paramref name="base_path"/>.hdr.
+/// </summary>
+/// <param name="image">The image or image region.</param>
+/// <param name="base_path">The path of both files without extension.</param>
+/// <param name="parallel">If true, strips of lines are written concurrently.</param>
+template <typename T>
+void writeENVI(const ImageView<T>& image, const std::string& base_path, const bool parallel = false) throw(std::runtime_error)
+{
+    std::ostringstream header;
+    header << "ENVI" << std::endl
+           << "samples = " << image.samples << std::endl
+           << "lines = " << image.lines << std::endl
+           << "bands = " << static_cast<int>(image.bands) << std::endl
+           << "header offset = 0" << std::endl
+           << "file type = ENVI Standard" << std::endl
+           << "data type = " << static_cast<int>(ENVIDataType<T>::value) << std::endl
+           << "interleave = bip" << std::endl
+           << "byte order = " << (isLittleEndian() ? 0 : 1) << std::endl;
+
+    std::ofstream header_file(base_path + ".hdr");
+    if (!header_file.is_open()) throw std::runtime_error("Could not open output file");
+    header_file << header.str();
+    header_file.close();
+    if (!header_file) throw std::runtime_error("Could not write output file");
+
+    writeSamples(base_path + ".img", std::string(), image, false, parallel);
+}
+
+/// <summary>
+/// Writes a single- or three-band float region as a portable float map (PFM).
+/// PFM stores the last line first; The sign of the scale gives the byte order.
+/// </summary>
+/// <param name="image">The image or image region; Must have one or three bands.</param>
+/// <param name="path">The path of the file.</param>
+/// <param name="parallel">If true, strips of lines are written concurrently.</param>
+inline void writePFM(const ImageView<float>& image, const std::string& path, const bool parallel = false) throw(std::runtime_error)
+{
+    if (image.bands != 1 && image.bands != 3) throw std::runtime_error("PFM files need one or three bands");
+
+    std::ostringstream header;
+    header << (image.bands == 3 ? "PF" : "Pf") << "\n"
+           << image.samples << " " << image.lines << "\n"
+           << (isLittleEndian() ? "-1.0" : "1.0") << "\n";
+
+    writeSamples(path, header.str(), image, true, parallel);
+}
+
+#endif
\ No newline at end of file
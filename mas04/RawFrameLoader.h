@@ -0,0 +1,206 @@
+#ifndef _RAWFRAMELOADER_H_
+#define _RAWFRAMELOADER_H_
+
+#pragma warning(disable: 4290)
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Image.h"
+
+/// <summary>
+/// Loads a sequence of single-band unsigned 8-bit raw frames of equal size, one frame ahead:
+/// While the caller processes frame N, frame N+1 is read and converted in the background.
+/// </summary>
+template <typename T>
+class RawFrameLoader
+{
+private:
+    /// <summary>
+    /// The paths of all frames
+    /// </summary>
+    const std::vector<std::string> _paths;
+
+    /// <summary>
+    /// The index of the next frame to be returned
+    /// </summary>
+    size_t _next;
+
+    /// <summary>
+    /// The frame being loaded in the background
+    /// </summary>
+    std::future<std::unique_ptr<Image<T>>> _pending;
+
+public:
+    /// <summary>
+    /// The number of samples per frame
+    /// </summary>
+    const samples_t samples;
+
+    /// <summary>
+    /// The number of lines per frame
+    /// </summary>
+    const lines_t lines;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="RawFrameLoader"/> class and starts loading the first frame.
+    /// </summary>
+    /// <param name="paths">The paths of all frames.</param>
+    /// <param name="samples">The number of samples per frame.</param>
+    /// <param name="lines">The number of lines per frame.</param>
+    RawFrameLoader(const std::vector<std::string>& paths, const samples_t& samples, const lines_t& lines)
+        : _paths(paths), _next(0), samples(samples), lines(lines)
+    {
+        prefetch();
+    }
+
+    /// <summary>
+    /// Finalizes an instance of the <see cref="RawFrameLoader"/> class; Waits for a frame still being loaded.
+    /// </summary>
+    ~RawFrameLoader()
+    {
+        if (_pending.valid()) _pending.wait();
+    }
+
+    /// <summary>
+    /// Determines whether all frames have been returned
+    /// </summary>
+    /// <returns>true if there are no more frames.</returns>
+    inline bool done() const
+    {
+        return _next >= _paths.size();
+    }
+
+    /// <summary>
+    /// Gets the next frame and starts loading the one after it
+    /// </summary>
+    /// <returns>The frame, or an empty pointer if all frames have been returned.</returns>
+    std::unique_ptr<Image<T>> next() throw(std::runtime_error)
+    {
+        if (done()) return std::unique_ptr<Image<T>>();
+
+        std::unique_ptr<Image<T>> frame = _pending.get();
+        ++_next;
+
+        prefetch();
+        return frame;
+    }
+
+    /// <summary>
+    /// Loads a single frame
+    /// </summary>
+    /// <param name="path">The path of the frame.</param>
+    /// <param name="samples">The number of samples.</param>
+    /// <param name="lines">The number of lines.</param>
+    /// <returns>The frame.</returns>
+    static std::unique_ptr<Image<T>> load(const std::string& path, const samples_t& samples, const lines_t& lines) throw(std::runtime_error)
+    {
+        std::ifstream file;
+        file.open(path, std::ios_base::in | std::ios_base::binary);
+        if (!file.is_open()) throw std::runtime_error("Could not open input file");
+
+        return Image<T>::createFromU8Raw(file, samples, lines);
+    }
+
+private:
+    /// <summary>
+    /// Starts loading the next frame in the background, if there is one
+    /// </summary>
+    void prefetch()
+    {
+        if (done()) return;
+        _pending = std::async(std::launch::async, &RawFrameLoader::load, _paths[_next], samples, lines);
+    }
+
+private:
+    RawFrameLoader(const RawFrameLoader&);
+    RawFrameLoader& operator=(const RawFrameLoader&);
+};
+
+/// <summary>
+/// Builds the paths of a numbered sequence of files, e.g. ./images/bild0.raw to ./images/bild6.raw
+/// </summary>
+/// <param name="prefix">The part of the path before the number.</param>
+/// <param name="suffix">The part of the path after the number.</param>
+/// <param name="first">The first number.</param>
+/// <param name="count">The number of files.</param>
+/// <returns>The paths.</returns>
+inline std::vector<std::string> sequencePaths(const std::string& prefix, const std::string& suffix, const size_t& first, const size_t& count)
+{
+    std::vector<std::string> paths;
+    paths.reserve(count);
+    for (size_t i = first; i < first + count; ++i)
+    {
+        paths.push_back(prefix + std::to_string(static_cast<unsigned long long>(i)) + suffix);
+    }
+    return paths;
+}
+
+/// <summary>
+/// Loads a sequence of single-band unsigned 8-bit raw frames of equal size in parallel.
+/// All frames are allocated up front; Each file is then read and converted by one thread.
+/// </summary>
+/// <param name="paths">The paths of all frames.</param>
+/// <param name="samples">The number of samples per frame.</param>
+/// <param name="lines">The number of lines per frame.</param>
+/// <param name="milliseconds">The time taken to load each file.</param>
+/// <returns>The frames, in the order of the paths.</returns>
+template <typename T>
+std::vector<std::unique_ptr<Image<T>>> loadRawSequence(const std::vector<std::string>& paths, const samples_t& samples, const lines_t& lines, std::vector<double>& milliseconds) throw(std::runtime_error)
+{
+    // preallocate the frame stack
+    std::vector<std::unique_ptr<Image<T>>> frames(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        frames[i].reset(new Image<T>(samples, lines, 1, false));
+    }
+
+    milliseconds.assign(paths.size(), 0.0);
+    std::vector<std::string> errors(paths.size());
+
+    typedef int_fast64_t omp_filecount_t; // OpenMP needs signed integral type
+    const omp_filecount_t omp_files = static_cast<omp_filecount_t>(paths.size());
+
+    // exceptions must not leave the parallel region, so errors are collected per file
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_filecount_t i = 0; i < omp_files; ++i)
+    {
+        const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+        std::ifstream file;
+        file.open(paths[i], std::ios_base::in | std::ios_base::binary);
+        if (!file.is_open())
+        {
+            errors[i] = "Could not open input file " + paths[i];
+            continue;
+        }
+
+        try
+        {
+            frames[i]->readU8Raw(file);
+        }
+        catch (std::exception& e)
+        {
+            errors[i] = e.what();
+            continue;
+        }
+
+        milliseconds[i] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    for (size_t i = 0; i < errors.size(); ++i)
+    {
+        if (!errors[i].empty()) throw std::runtime_error(errors[i]);
+    }
+
+    return frames;
+}
+
+#endif
\ No newline at end of file
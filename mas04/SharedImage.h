@@ -0,0 +1,221 @@
+#ifndef _SHAREDIMAGE_H_
+#define _SHAREDIMAGE_H_
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#include "Image.h"
+
+/// <summary>
+/// Reference-counted, copy-on-write handle to an <see cref="Image"/>.
+/// Copies of a handle share the image; The first write through a handle copies only the strip of lines it touches,
+/// so stages of a fan-out pipeline can modify their input without duplicating whole images.
+/// A handle itself must not be copied and written to from different threads at the same time.
+/// </summary>
+template <typename T>
+class SharedImage
+{
+public:
+    /// <summary>
+    /// The default number of lines that are copied together on the first write
+    /// </summary>
+    static const lines_t default_strip_lines = 64;
+
+private:
+    /// <summary>
+    /// The image shared by all copies of the handle
+    /// </summary>
+    std::shared_ptr<Image<T>> _image;
+
+    /// <summary>
+    /// Strips of lines that were written to, one entry per strip; Empty entries are read from the shared image.
+    /// The strips themselves are shared by copies of the handle made after the write.
+    /// </summary>
+    std::vector<std::shared_ptr<Image<T>>> _strips;
+
+public:
+    /// <summary>
+    /// The number of samples (width)
+    /// </summary>
+    const samples_t samples;
+
+    /// <summary>
+    /// The number of lines (height)
+    /// </summary>
+    const lines_t lines;
+
+    /// <summary>
+    /// The number of color bands
+    /// </summary>
+    const bands_t bands;
+
+    /// <summary>
+    /// The number of lines that are copied together on the first write
+    /// </summary>
+    const lines_t strip_lines;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="SharedImage"/> class by taking ownership of the given image.
+    /// </summary>
+    /// <param name="image">The image.</param>
+    /// <param name="strip_lines">The number of lines that are copied together on the first write.</param>
+    explicit SharedImage(std::unique_ptr<Image<T>> image, const lines_t& strip_lines = default_strip_lines)
+        : _image(std::move(image)), samples(_image->samples), lines(_image->lines), bands(_image->bands), strip_lines(strip_lines)
+    {
+        assert(strip_lines > 0);
+        _strips.resize((lines + strip_lines - 1) / strip_lines);
+    }
+
+    /// <summary>
+    /// Gets the given line for reading
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>Pointer to the first sample of the line.</returns>
+    inline const T* line(const lines_t& line) const
+    {
+        const std::shared_ptr<Image<T>>& strip = _strips[line / strip_lines];
+        return strip ? strip->line(line % strip_lines).get_samples() : _image->line(line).get_samples();
+    }
+
+    /// <summary>
+    /// Gets the sample at the given position for reading
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <param name="sample">The sample.</param>
+    /// <param name="band">The band.</param>
+    /// <returns>The sample.</returns>
+    inline const T& sample(const lines_t& line, const samples_t& sample, const bands_t& band = 0) const
+    {
+        return this->line(line)[sample * bands + band];
+    }
+
+    /// <summary>
+    /// Gets the given line for writing; The line's strip is copied first if it is shared with another handle.
+    /// </summary>
+    /// <param name="line">The line.</param>
+    /// <returns>Pointer to the first sample of the line.</returns>
+    inline T* writableLine(const lines_t& line)
+    {
+        detach(line / strip_lines);
+
+        const std::shared_ptr<Image<T>>& strip = _strips[line / strip_lines];
+        return strip ? strip->line(line % strip_lines).get_samples() : _image->line(line).get_samples();
+    }
+
+    /// <summary>
+    /// Sets the specified sample to the given value; The line's strip is copied first if it is shared with another handle.
+    /// </summary>
+    /// <param name="sample">The sample.</param>
+    /// <param name="line">The line.</param>
+    /// <param name="value">The value.</param>
+    /// <param name="band">The band.</param>
+    inline void set(const samples_t& sample, const lines_t& line, const T& value, const bands_t& band = 0)
+    {
+        assert(band < bands);
+        writableLine(line)[sample * bands + band] = value;
+    }
+
+    /// <summary>
+    /// Gets a read-only view of the whole image; Strips that were written to are merged back into a single image first.
+    /// The image may be shared, so use <see cref="writableView"/> for writing.
+    /// </summary>
+    /// <returns>The view.</returns>
+    inline const ImageView<T> view()
+    {
+        merge();
+        return _image->view();
+    }
+
+    /// <summary>
+    /// Gets a view of the whole image for writing; The image is copied first if it is shared with another handle.
+    /// </summary>
+    /// <returns>The view.</returns>
+    inline ImageView<T> writableView()
+    {
+        merge();
+        if (_image.use_count() != 1) _image = std::shared_ptr<Image<T>>(_image->view().clone());
+        return _image->view();
+    }
+
+    /// <summary>
+    /// Determines whether any part of the image is shared with another handle
+    /// </summary>
+    /// <returns>true if shared.</returns>
+    bool shared() const
+    {
+        for (size_t s = 0; s < _strips.size(); ++s)
+        {
+            const bool strip_shared = _strips[s] ? _strips[s].use_count() != 1 : _image.use_count() != 1;
+            if (strip_shared) return true;
+        }
+        return false;
+    }
+
+private:
+    /// <summary>
+    /// Makes sure the given strip is not shared with another handle, copying it if necessary
+    /// </summary>
+    /// <param name="strip_index">The strip.</param>
+    void detach(const size_t& strip_index)
+    {
+        std::shared_ptr<Image<T>>& strip = _strips[strip_index];
+        if (strip)
+        {
+            if (strip.use_count() != 1) strip = std::shared_ptr<Image<T>>(strip->view().clone());
+            return;
+        }
+
+        // nobody else sees the shared image, so it can be written to in place
+        if (_image.use_count() == 1) return;
+
+        const lines_t line_first = static_cast<lines_t>(strip_index * strip_lines);
+        const lines_t line_count = std::min<lines_t>(strip_lines, lines - line_first);
+        strip = std::shared_ptr<Image<T>>(_image->view(0, line_first, samples, line_count).clone());
+    }
+
+    /// <summary>
+    /// Merges the strips that were written to back into a single image
+    /// </summary>
+    void merge()
+    {
+        bool any_strips = false;
+        for (size_t s = 0; s < _strips.size(); ++s)
+        {
+            any_strips |= static_cast<bool>(_strips[s]);
+        }
+        if (!any_strips) return;
+
+        // unless nobody else sees the shared image, the merged image is a new one assembled from both
+        const bool in_place = _image.use_count() == 1;
+        std::shared_ptr<Image<T>> target = in_place ? _image : std::shared_ptr<Image<T>>(new Image<T>(samples, lines, bands, false));
+
+        const samples_t values = samples * bands;
+        for (size_t s = 0; s < _strips.size(); ++s)
+        {
+            const lines_t line_first = static_cast<lines_t>(s * strip_lines);
+            const lines_t line_count = std::min<lines_t>(strip_lines, lines - line_first);
+
+            // lines that were never written to are already in place
+            if (!_strips[s] && in_place) continue;
+
+            for (lines_t y = 0; y < line_count; ++y)
+            {
+                const T* source = _strips[s] ? _strips[s]->line(y).get_samples() : _image->line(line_first + y).get_samples();
+                std::copy(source, source + values, target->line(line_first + y).get_samples());
+            }
+            _strips[s].reset();
+        }
+
+        _image = target;
+    }
+};
+
+template <typename T>
+const lines_t SharedImage<T>::default_strip_lines;
+
+typedef SharedImage<float>                  SharedFloatImage;
+
+#endif
\ No newline at end of file
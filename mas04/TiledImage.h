@@ -0,0 +1,384 @@
+#ifndef _TILEDIMAGE_H_
+#define _TILEDIMAGE_H_
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#include "Image.h"
+
+/// <summary>
+/// A single tile of a <see cref="TiledImage"/>.
+/// The tile's samples are stored contiguously together with a halo of neighboring samples around them;
+/// At the image borders the halo is filled according to the border policy of the tiled image, so neighborhood
+/// operators never need to check bounds.
+/// </summary>
+template <typename T>
+class ImageTile
+{
+private:
+    /// <summary>
+    /// The tile samples, allocated with the halo
+    /// </summary>
+    std::unique_ptr<Image<T>> _padded;
+
+public:
+    /// <summary>
+    /// The first sample of the tile in image coordinates
+    /// </summary>
+    const samples_t sample_first;
+
+    /// <summary>
+    /// The first line of the tile in image coordinates
+    /// </summary>
+    const lines_t line_first;
+
+    /// <summary>
+    /// The number of samples of the tile (without halo)
+    /// </summary>
+    const samples_t samples;
+
+    /// <summary>
+    /// The number of lines of the tile (without halo)
+    /// </summary>
+    const lines_t lines;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ImageTile"/> class by copying the tile and its halo from the given region.
+    /// </summary>
+    /// <param name="source">The region to copy from; Its own halo must cover the halo of the tile.</param>
+    /// <param name="sample_first">The first sample of the tile.</param>
+    /// <param name="line_first">The first line of the tile.</param>
+    /// <param name="samples">The number of samples of the tile.</param>
+    /// <param name="lines">The number of lines of the tile.</param>
+    /// <param name="halo">The size of the halo.</param>
+    ImageTile(const ImageView<T>& source, const samples_t& sample_first, const lines_t& line_first, const samples_t& samples, const lines_t& lines, const samples_t& halo)
+        : _padded(new Image<T>(samples, lines, source.bands, false, halo)), sample_first(sample_first), line_first(line_first), samples(samples), lines(lines)
+    {
+        const ImageView<T> region = source.view(sample_first, line_first, samples, lines);
+        const ImageView<T> target = _padded->view();
+        assert(region.halo >= halo);
+
+        // copy whole lines including the halo on either side
+        const samples_t halo_values = halo * source.bands;
+        const samples_t values = samples * source.bands + 2 * halo_values;
+        for (slines_t y = -halo; y < static_cast<slines_t>(lines) + halo; ++y)
+        {
+            const T* source_line = region.haloLine(y).get_samples() - halo_values;
+            std::copy(source_line, source_line + values, target.haloLine(y).get_samples() - halo_values);
+        }
+    }
+
+    /// <summary>
+    /// Gets the tile; Neighborhood operators may read its halo.
+    /// </summary>
+    /// <returns>The view.</returns>
+    inline ImageView<T> view() const
+    {
+        return _padded->view();
+    }
+
+private:
+    ImageTile(const ImageTile&);
+    ImageTile& operator=(const ImageTile&);
+};
+
+/// <summary>
+/// Image stored as square tiles with a halo, so that neighborhood operators only touch a small, contiguous
+/// block of memory per output sample. Conversion from and to the line layout of <see cref="Image"/> is explicit.
+/// </summary>
+template <typename T>
+class TiledImage
+{
+public:
+    /// <summary>
+    /// The default edge length of a tile in samples
+    /// </summary>
+    static const samples_t default_tile_size = 64;
+
+    typedef std::unique_ptr<ImageTile<T>>                       tile_t;
+    typedef typename std::vector<tile_t>::const_iterator        const_iterator;
+
+private:
+    /// <summary>
+    /// The tiles, line by line
+    /// </summary>
+    std::vector<tile_t> _tiles;
+
+public:
+    /// <summary>
+    /// The number of samples (width)
+    /// </summary>
+    const samples_t samples;
+
+    /// <summary>
+    /// The number of lines (height)
+    /// </summary>
+    const lines_t lines;
+
+    /// <summary>
+    /// The number of color bands
+    /// </summary>
+    const bands_t bands;
+
+    /// <summary>
+    /// The edge length of a tile in samples
+    /// </summary>
+    const samples_t tile_size;
+
+    /// <summary>
+    /// The number of neighboring samples kept around each tile
+    /// </summary>
+    const samples_t halo;
+
+    /// <summary>
+    /// The policy by which the halo is filled at the image borders
+    /// </summary>
+    const BorderPolicy border;
+
+    /// <summary>
+    /// The number of tiles per tile row
+    /// </summary>
+    const samples_t tiles_x;
+
+    /// <summary>
+    /// The number of tile rows
+    /// </summary>
+    const lines_t tiles_y;
+
+public:
+    /// <summary>
+    /// Initializes a new instance of the <see cref="TiledImage"/> class by copying the given region into tiles.
+    /// </summary>
+    /// <param name="source">The region.</param>
+    /// <param name="halo">The number of neighboring samples to keep around each tile.</param>
+    /// <param name="tile_size">The edge length of a tile in samples.</param>
+    /// <param name="border">The policy by which the halo is filled at the borders of the region.</param>
+    TiledImage(const ImageView<T>& source, const samples_t& halo, const samples_t& tile_size = default_tile_size, const BorderPolicy& border = BorderReplicate)
+        : samples(source.samples), lines(source.lines), bands(source.bands), tile_size(tile_size), halo(halo), border(border),
+          tiles_x((source.samples + tile_size - 1) / tile_size), tiles_y(static_cast<lines_t>((source.lines + tile_size - 1) / tile_size))
+    {
+        assert(tile_size > 0);
+        assert(halo >= 0);
+
+        _tiles.resize(static_cast<size_t>(tiles_x) * tiles_y);
+
+        // unless the region already has enough neighbors, the tiles at its borders take their halo from a padded copy
+        std::unique_ptr<Image<T>> padded;
+        if (source.halo < halo) padded = source.pad(halo, border);
+        const ImageView<T> padded_source = padded ? padded->view() : source;
+
+        // OpenMP needs signed integral type
+        typedef int_fast64_t omp_tilecount_t;
+        const omp_tilecount_t omp_tiles = static_cast<omp_tilecount_t>(_tiles.size());
+
+        #pragma omp parallel for
+        for (omp_tilecount_t index = 0; index < omp_tiles; ++index)
+        {
+            const samples_t x = static_cast<samples_t>(index % tiles_x) * tile_size;
+            const lines_t y = static_cast<lines_t>(index / tiles_x) * tile_size;
+            const samples_t tile_samples = std::min<samples_t>(tile_size, samples - x);
+            const lines_t tile_lines = static_cast<lines_t>(std::min<samples_t>(tile_size, lines - y));
+
+            _tiles[index] = tile_t(new ImageTile<T>(padded_source, x, y, tile_samples, tile_lines, halo));
+        }
+    }
+
+    /// <summary>
+    /// Copies the given region into tiles
+    /// </summary>
+    /// <param name="source">The region.</param>
+    /// <param name="halo">The number of neighboring samples to keep around each tile.</param>
+    /// <param name="tile_size">The edge length of a tile in samples.</param>
+    /// <param name="border">The policy by which the halo is filled at the borders of the region.</param>
+    /// <returns>The tiled image.</returns>
+    static inline std::unique_ptr<TiledImage> fromImage(const ImageView<T>& source, const samples_t& halo, const samples_t& tile_size = default_tile_size, const BorderPolicy& border = BorderReplicate)
+    {
+        return std::unique_ptr<TiledImage>(new TiledImage(source, halo, tile_size, border));
+    }
+
+    /// <summary>
+    /// Gets the number of tiles
+    /// </summary>
+    /// <returns>The number of tiles.</returns>
+    inline size_t tileCount() const
+    {
+        return _tiles.size();
+    }
+
+    /// <summary>
+    /// Gets the tile with the given index; Tiles are ordered line by line.
+    /// </summary>
+    /// <param name="index">The index.</param>
+    /// <returns>The tile.</returns>
+    inline const ImageTile<T>& tile(const size_t& index) const
+    {
+        return *_tiles[index];
+    }
+
+    /// <summary>
+    /// Gets the tile at the given tile position
+    /// </summary>
+    /// <param name="tile_x">The tile column.</param>
+    /// <param name="tile_y">The tile row.</param>
+    /// <returns>The tile.</returns>
+    inline const ImageTile<T>& tile(const samples_t& tile_x, const lines_t& tile_y) const
+    {
+        return *_tiles[static_cast<size_t>(tile_y) * tiles_x + tile_x];
+    }
+
+    /// <summary>
+    /// Gets an iterator to the first tile
+    /// </summary>
+    /// <returns>The iterator.</returns>
+    inline const_iterator begin() const
+    {
+        return _tiles.begin();
+    }
+
+    /// <summary>
+    /// Gets an iterator past the last tile
+    /// </summary>
+    /// <returns>The iterator.</returns>
+    inline const_iterator end() const
+    {
+        return _tiles.end();
+    }
+
+    /// <summary>
+    /// Copies the tiles back into an image in line layout
+    /// </summary>
+    /// <returns>The image.</returns>
+    std::unique_ptr<Image<T>> toImage() const;
+
+    /// <summary>
+    /// Applies a neighborhood operator tile by tile and assembles the results in line layout.
+    /// The operator is called with the view of each tile and must return an image of the same size;
+    /// It may read up to <see cref="halo"/> samples beyond the tile.
+    /// </summary>
+    /// <param name="op">The operator.</param>
+    /// <returns>The image.</returns>
+    template <typename U, typename Operator>
+    std::unique_ptr<Image<U>> apply(const Operator& op) const;
+
+    /// <summary>
+    /// Convolves the image with the given kernel tile by tile; Samples outside of the image are taken from the border.
+    /// </summary>
+    /// <param name="kernel">The kernel; Its half size must not exceed the halo.</param>
+    /// <returns>The convolved image.</returns>
+    std::unique_ptr<Image<float>> convolve(const ImageView<float>& kernel) const;
+
+private:
+    TiledImage(const TiledImage&);
+    TiledImage& operator=(const TiledImage&);
+};
+
+template <typename T>
+const samples_t TiledImage<T>::default_tile_size;
+
+/// <summary>
+/// Copies the tiles back into an image in line layout
+/// </summary>
+/// <returns>The image.</returns>
+template <typename T>
+std::unique_ptr<Image<T>> TiledImage<T>::toImage() const
+{
+    std::unique_ptr<Image<T>> target(new Image<T>(samples, lines, bands, false));
+
+    // OpenMP needs signed integral type
+    typedef int_fast64_t omp_tilecount_t;
+    const omp_tilecount_t omp_tiles = static_cast<omp_tilecount_t>(_tiles.size());
+
+    #pragma omp parallel for
+    for (omp_tilecount_t index = 0; index < omp_tiles; ++index)
+    {
+        const ImageTile<T>& tile = *_tiles[index];
+        const ImageView<T> core = tile.view();
+        const ImageView<T> target_region = target->view(tile.sample_first, tile.line_first, tile.samples, tile.lines);
+
+        for (lines_t y = 0; y < tile.lines; ++y)
+        {
+            const T* source = core.line(y).get_samples();
+            std::copy(source, source + tile.samples * bands, target_region.line(y).get_samples());
+        }
+    }
+
+    return target;
+}
+
+/// <summary>
+/// Applies a neighborhood operator tile by tile and assembles the results in line layout.
+/// </summary>
+/// <param name="op">The operator.</param>
+/// <returns>The image.</returns>
+template <typename T>
+template <typename U, typename Operator>
+std::unique_ptr<Image<U>> TiledImage<T>::apply(const Operator& op) const
+{
+    std::unique_ptr<Image<U>> target(new Image<U>(samples, lines, bands, false));
+
+    // OpenMP needs signed integral type
+    typedef int_fast64_t omp_tilecount_t;
+    const omp_tilecount_t omp_tiles = static_cast<omp_tilecount_t>(_tiles.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for (omp_tilecount_t index = 0; index < omp_tiles; ++index)
+    {
+        const ImageTile<T>& tile = *_tiles[index];
+
+        // apply the operator on the tile, reading into its halo
+        std::unique_ptr<Image<U>> result = op(tile.view());
+        assert(result->samples == tile.samples && result->lines == tile.lines);
+
+        const ImageView<U> core = result->view();
+        const ImageView<U> target_region = target->view(tile.sample_first, tile.line_first, tile.samples, tile.lines);
+
+        for (lines_t y = 0; y < tile.lines; ++y)
+        {
+            const U* source = core.line(y).get_samples();
+            std::copy(source, source + tile.samples * bands, target_region.line(y).get_samples());
+        }
+    }
+
+    return target;
+}
+
+/// <summary>
+/// Convolution operator for <see cref="TiledImage::apply"/>
+/// </summary>
+template <typename T>
+struct ConvolveOperator
+{
+    const ImageView<float>& kernel;
+
+    explicit ConvolveOperator(const ImageView<float>& kernel) : kernel(kernel) {}
+
+    inline std::unique_ptr<Image<float>> operator()(const ImageView<T>& tile) const
+    {
+        return tile.convolve(kernel);
+    }
+
+private:
+    ConvolveOperator& operator=(const ConvolveOperator&);
+};
+
+/// <summary>
+/// Convolves the image with the given kernel tile by tile; Samples outside of the image are taken from the border.
+/// </summary>
+/// <param name="kernel">The kernel; Its half size must not exceed the halo.</param>
+/// <returns>The convolved image.</returns>
+template <typename T>
+std::unique_ptr<Image<float>> TiledImage<T>::convolve(const ImageView<float>& kernel) const
+{
+    assert(kernel.samples / 2 <= halo);
+    assert(static_cast<samples_t>(kernel.lines / 2) <= halo);
+
+    return apply<float>(ConvolveOperator<T>(kernel));
+}
+
+typedef TiledImage<float>                   FloatTiledImage;
+typedef std::unique_ptr<FloatTiledImage>    tiledimage_t;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,212 @@
+#pragma warning(disable: 4996) // Disable deprecation
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include "FloatImage.h"
+#include "ImageExpression.h"
+#include "TiledImage.h"
+
+using namespace std;
+
+/// <summary>The number of failed checks</summary>
+static int failures = 0;
+
+/// <summary>Records a failed check, with the expression and the line it is on</summary>
+#define CHECK(condition) \
+    do { if (!(condition)) { ++failures; cerr << "FAILED (line " << __LINE__ << "): " << #condition << endl; } } while (false)
+
+/// <summary>
+/// A distinct value for every position, exact in single precision for the positions used in the tests
+/// </summary>
+/// <param name="sample">The sample.</param>
+/// <param name="line">The line.</param>
+/// <param name="band">The band.</param>
+/// <returns>The value.</returns>
+static inline float valueAt(const samples_t& sample, const lines_t& line, const bands_t& band)
+{
+    return static_cast<float>((sample % 4096) + 4096 * (line % 256) + 1048576 * band);
+}
+
+/// <summary>
+/// Fills an image, sample by sample, through <see cref="Image::sample"/>
+/// </summary>
+/// <param name="image">The image.</param>
+static void fill(const FloatImage& image)
+{
+    for (lines_t y = 0; y < image.lines; ++y)
+    {
+        for (samples_t x = 0; x < image.samples; ++x)
+        {
+            for (bands_t b = 0; b < image.bands; ++b)
+            {
+                image.sample(y, x, b) = valueAt(x, y, b);
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Images wider than 65535 samples: stride, lines, samples and views, for one and three bands
+/// </summary>
+static void testWideImages()
+{
+    const samples_t samples = 70000;
+    const lines_t lines = 3;
+
+    for (bands_t bands = 1; bands <= 3; bands += 2)
+    {
+        FloatImage image(samples, lines, bands, false);
+        fill(image);
+
+        CHECK(image.stride >= samples * bands);
+        CHECK(image.line(2).get_samples() - image.line(0).get_samples() == 2 * image.stride);
+        CHECK(image.line(2).get_samples()[69999 * bands + bands - 1] == valueAt(69999, 2, bands - 1));
+        CHECK(image.sample(1, 65536, 0) == valueAt(65536, 1, 0));
+
+        // views starting beyond 65535 samples
+        const FloatImageView region = image.view(66000, 1, 4000, 2);
+        CHECK(region.sample(0, 0, bands - 1) == valueAt(66000, 1, bands - 1));
+        CHECK(region.sample(1, 3999, 0) == valueAt(69999, 2, 0));
+        CHECK(region.clone()->sample(1, 3999, 0) == valueAt(69999, 2, 0));
+    }
+}
+
+/// <summary>
+/// Images taller than 65535 lines: lines and views
+/// </summary>
+static void testTallImages()
+{
+    const samples_t samples = 3;
+    const lines_t lines = 70000;
+
+    FloatImage image(samples, lines, 1, false);
+    fill(image);
+
+    CHECK(image.line(69999).get_samples() - image.data() == 69999 * image.stride);
+    CHECK(image.sample(69999, 2) == valueAt(2, 69999, 0));
+    CHECK(image.view(1, 66000, 2, 4000).sample(3999, 1) == valueAt(2, 69999, 0));
+}
+
+/// <summary>
+/// Convolution of wide and tall images, directly and through tiles
+/// </summary>
+static void testConvolution()
+{
+    // a 3x3 box filter keeps a linear ramp unchanged away from its wrap-around
+    FloatImage kernel(3, 3, 1, false);
+    kernel = ScalarExpression(1.0F / 9.0F);
+
+    FloatImage wide(70000, 5, 1, false);
+    wide = ScalarExpression(0.0F);
+    for (lines_t y = 0; y < wide.lines; ++y)
+    {
+        for (samples_t x = 0; x < wide.samples; ++x)
+        {
+            wide.sample(y, x) = static_cast<float>(x % 1000);
+        }
+    }
+
+    const unique_ptr<FloatImage> convolved = wide.view().convolve(kernel.view());
+    CHECK(fabs(convolved->sample(2, 69500) - 500.0F) < 1e-3F);
+    CHECK(fabs(convolved->sample(2, 65600) - 600.0F) < 1e-3F);
+
+    const TiledImage<float> tiled(wide.view(), 1);
+    CHECK(tiled.tileCount() == static_cast<size_t>((70000 + 63) / 64));
+    CHECK(tiled.toImage()->sample(4, 69999) == 999.0F);
+
+    const unique_ptr<FloatImage> tiled_convolved = tiled.convolve(kernel.view());
+    CHECK(fabs(tiled_convolved->sample(2, 69500) - 500.0F) < 1e-3F);
+
+    FloatImage tall(4, 70000, 1, false);
+    for (lines_t y = 0; y < tall.lines; ++y)
+    {
+        for (samples_t x = 0; x < tall.samples; ++x)
+        {
+            tall.sample(y, x) = static_cast<float>(y % 1000);
+        }
+    }
+
+    CHECK(fabs(tall.view().convolve(kernel.view())->sample(69500, 1) - 500.0F) < 1e-3F);
+    CHECK(TiledImage<float>(tall.view(), 1).toImage()->sample(69999, 3) == 999.0F);
+}
+
+/// <summary>
+/// Conversion of wide images for display
+/// </summary>
+static void testOpenCv()
+{
+    Image<uint8_t> bytes(70000, 2, 1);
+    bytes.sample(1, 69999) = 255;
+
+    const IplImagePtr converted_bytes = bytes.toOpenCv();
+    CHECK(converted_bytes->width == 70000);
+    CHECK(static_cast<uint8_t>(converted_bytes->imageData[converted_bytes->widthStep + 69999]) == 255);
+    CHECK(static_cast<uint8_t>(converted_bytes->imageData[converted_bytes->widthStep + 69998]) == 0);
+
+    FloatImage floats(70000, 2, 1);
+    floats.sample(1, 69999) = 1.0F;
+
+    const IplImagePtr converted_floats = floats.toOpenCv();
+    CHECK(static_cast<uint8_t>(converted_floats->imageData[converted_floats->widthStep + 69999]) == 255);
+    CHECK(static_cast<uint8_t>(converted_floats->imageData[converted_floats->widthStep + 65536]) == 0);
+}
+
+/// <summary>
+/// Expressions assigned to wide images, including saturation of integer targets
+/// </summary>
+static void testAssign()
+{
+    FloatImage source(70000, 2, 1, false);
+    fill(source);
+
+    FloatImage scaled(70000, 2, 1, false);
+    scaled = source * 2.0F + 1.0F;
+    CHECK(scaled.sample(1, 69999) == 2.0F * valueAt(69999, 1, 0) + 1.0F);
+
+    Image<uint8_t> saturated(70000, 2, 1, false);
+    saturated = source;
+    CHECK(saturated.sample(0, 69999) == 255);
+    CHECK(saturated.sample(0, 65536) == 0);
+}
+
+/// <summary>
+/// Images whose buffer doesn't fit into the address space are rejected instead of being allocated too small
+/// </summary>
+static void testOversizedImages()
+{
+    if (sizeof(size_t) >= 8) return;
+
+    bool rejected = false;
+    try { FloatImage image(70000, 70000, 1, false); }
+    catch (const runtime_error&) { rejected = true; }
+    CHECK(rejected);
+}
+
+/// <summary>
+/// Runs the tests for image dimensions above 65535.
+/// </summary>
+/// <returns>0 if all checks passed.</returns>
+int main(void)
+{
+    try
+    {
+        testWideImages();
+        testTallImages();
+        testConvolution();
+        testOpenCv();
+        testAssign();
+        testOversizedImages();
+    }
+    catch (const exception& e)
+    {
+        ++failures;
+        cerr << "FAILED: " << e.what() << endl;
+    }
+
+    cout << (failures == 0 ? "All checks passed." : "Some checks failed.") << endl;
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file